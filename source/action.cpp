@@ -22,6 +22,9 @@
 #include "map.h"
 #include "editor.h"
 #include "gui.h"
+#include "iomap_otbm.h"
+
+#include <zlib.h>
 
 Change::Change() :
 	type(CHANGE_NONE), data(nullptr) {
@@ -55,7 +58,7 @@ Change::~Change() {
 void Change::clear() {
 	switch (type) {
 		case CHANGE_TILE:
-			ASSERT(data);
+			// Packed tiles live in the batch's stream
 			delete reinterpret_cast<Tile*>(data);
 			break;
 		case CHANGE_MOVE_HOUSE_EXIT:
@@ -83,7 +86,7 @@ void Change::clear() {
 
 uint32_t Change::memsize() const {
 	uint32_t mem = sizeof(*this);
-	if (type == CHANGE_TILE) {
+	if (type == CHANGE_TILE && data) {
 		mem += reinterpret_cast<Tile*>(data)->memsize();
 	}
 	return mem;
@@ -113,7 +116,7 @@ size_t Action::memsize() const {
 	mem += sizeof(Change*) * 3 * changes.size();
 
 	for (const Change* change : changes) {
-		if (change && change->getType() == CHANGE_TILE) {
+		if (change && change->getType() == CHANGE_TILE && change->getData()) {
 			mem += reinterpret_cast<Tile*>(change->getData())->memsize();
 		}
 	}
@@ -258,6 +261,8 @@ void Action::commit(DirtyList* dirty_list) {
 					}
 
 					new_tile->increaseWaypointCount();
+					map.markAreaDirty(waypoint->pos);
+					map.markAreaDirty(data->position);
 
 					Position old_pos = waypoint->pos;
 					waypoint->pos = data->position;
@@ -390,6 +395,8 @@ void Action::undo(DirtyList* dirty_list) {
 					}
 
 					new_tile->increaseWaypointCount();
+					map.markAreaDirty(waypoint->pos);
+					map.markAreaDirty(data->position);
 
 					Position old_pos = waypoint->pos;
 					waypoint->pos = data->position;
@@ -431,6 +438,16 @@ size_t BatchAction::memsize(bool recalc) const {
 	uint32_t mem = sizeof(*this);
 	mem += sizeof(Action*) * 3 * batch.size();
 
+	if (isPacked()) {
+		// The change records, the tiles that couldn't be packed and the stream if it's in memory
+		for (const Action* action : batch) {
+			mem += action->memsize();
+		}
+		mem += packed.capacity();
+		const_cast<BatchAction*>(this)->memory_size = mem;
+		return mem;
+	}
+
 	for (const Action* action : batch) {
 #ifdef __USE_EXACT_MEMSIZE__
 		mem += action->memsize();
@@ -499,11 +516,319 @@ void BatchAction::redo() {
 	}
 }
 
+namespace {
+	// The undo stream is never written to a map file, so it always uses the newest format
+	VirtualIOMap getPackingIOMap() {
+		MapVersion version;
+		version.otbm = MAP_OTBM_LAST_VERSION;
+		return VirtualIOMap(version);
+	}
+
+	// Creatures and spawns aren't part of the OTBM tile node, such tiles stay as they are
+	bool isPackable(const Tile* tile) {
+		if (tile->spawnMonster || tile->spawnNpc || tile->npc || !tile->monsters.empty()) {
+			return false;
+		}
+		if (tile->ground && tile->ground->getID() == 0) {
+			return false;
+		}
+		return std::ranges::none_of(tile->items, [](const Item* item) { return item->getID() == 0; });
+	}
+
+	// Deltas wrap around in 16 bits, coordinates span the whole u16 range
+	Position unpackPosition(const Position &last, uint16_t dx, uint16_t dy, uint8_t z) {
+		return Position(static_cast<uint16_t>(last.x + dx), static_cast<uint16_t>(last.y + dy), z);
+	}
+
+	void packTile(const IOMap &maphandle, NodeFileWriteHandle &f, const Tile* tile, Position &last) {
+		const Position &pos = tile->getPosition();
+
+		f.addNode(OTBM_TILE);
+		// Positions are stored relative to the previous tile, batches are mostly runs of neighbours
+		const uint16_t dx = static_cast<uint16_t>(pos.x - last.x);
+		const uint16_t dy = static_cast<uint16_t>(pos.y - last.y);
+		f.addU16(dx);
+		f.addU16(dy);
+		f.addU8(static_cast<uint8_t>(pos.z));
+		// Round trip, the first tile of a real map is a step of over 32767 from the origin
+		ASSERT(unpackPosition(last, dx, dy, static_cast<uint8_t>(pos.z)) == pos);
+		last = pos;
+
+		f.addU16(tile->getMapFlags());
+		f.addU16(tile->getStatFlags());
+		f.addU32(tile->house_id);
+		f.addU8(tile->ground ? 1 : 0);
+
+		// Selection isn't part of the item nodes, one bit per item with the ground first
+		const size_t count = tile->items.size() + (tile->ground ? 1 : 0);
+		f.addU32(static_cast<uint32_t>(count));
+		uint8_t bits = 0;
+		size_t index = 0;
+		const auto addSelection = [&](const Item* item) {
+			if (item->isSelected()) {
+				bits |= 1 << (index & 7);
+			}
+			if ((++index & 7) == 0) {
+				f.addU8(bits);
+				bits = 0;
+			}
+		};
+		if (tile->ground) {
+			addSelection(tile->ground);
+		}
+		for (const Item* item : tile->items) {
+			addSelection(item);
+		}
+		if ((index & 7) != 0) {
+			f.addU8(bits);
+		}
+
+		if (tile->ground) {
+			tile->ground->serializeItemNode_OTBM(maphandle, f);
+		}
+		for (const Item* item : tile->items) {
+			item->serializeItemNode_OTBM(maphandle, f);
+		}
+		if (!tile->zones.empty()) {
+			f.addNode(OTBM_TILE_ZONE);
+			f.addU16(tile->zones.size());
+			for (const auto &zoneId : tile->zones) {
+				f.addU16(zoneId);
+			}
+			f.endNode();
+		}
+		f.endNode();
+	}
+
+	Tile* unpackTile(const IOMap &maphandle, Map &map, BinaryNode* node, Position &last) {
+		uint8_t type;
+		uint16_t dx, dy, mapflags, statflags;
+		uint8_t z, has_ground;
+		uint32_t house_id, count;
+		if (!node->getU8(type) || type != OTBM_TILE || !node->getU16(dx) || !node->getU16(dy) || !node->getU8(z)) {
+			return nullptr;
+		}
+		if (!node->getU16(mapflags) || !node->getU16(statflags) || !node->getU32(house_id) || !node->getU8(has_ground) || !node->getU32(count)) {
+			return nullptr;
+		}
+
+		std::vector<uint8_t> selection((count + 7) / 8);
+		for (uint8_t &bits : selection) {
+			if (!node->getU8(bits)) {
+				return nullptr;
+			}
+		}
+
+		const Position pos = unpackPosition(last, dx, dy, z);
+		last = pos;
+
+		Tile* tile = map.allocator(map.createTileL(pos));
+		tile->house_id = house_id;
+
+		size_t index = 0;
+		for (BinaryNode* child = node->getChild(); child != nullptr; child = child->advance()) {
+			uint8_t child_type;
+			if (!child->getByte(child_type)) {
+				break;
+			}
+			if (child_type == OTBM_ITEM) {
+				Item* item = Item::Create_OTBM(maphandle, child);
+				if (!item) {
+					continue;
+				}
+				item->unserializeItemNode_OTBM(maphandle, child);
+				if (index < count && (selection[index >> 3] & (1 << (index & 7)))) {
+					item->select();
+				}
+				if (index == 0 && has_ground) {
+					tile->ground = item;
+				} else {
+					tile->items.push_back(item);
+				}
+				++index;
+			} else if (child_type == OTBM_TILE_ZONE) {
+				uint16_t zone_count;
+				if (child->getU16(zone_count)) {
+					uint16_t zone_id;
+					while (zone_count-- && child->getU16(zone_id)) {
+						tile->addZone(zone_id);
+					}
+				}
+			}
+		}
+
+		tile->setMapFlags(mapflags);
+		tile->setStatFlags(statflags);
+		tile->update();
+		return tile;
+	}
+}
+
+bool BatchAction::pack() {
+	if (isPacked()) {
+		return false;
+	}
+
+	std::vector<Change*> changes;
+	for (Action* action : batch) {
+		for (Change* change : action->changes) {
+			if (change->getType() == CHANGE_TILE && change->data && isPackable(reinterpret_cast<Tile*>(change->data))) {
+				changes.push_back(change);
+			}
+		}
+	}
+	if (changes.empty()) {
+		return false;
+	}
+
+	const VirtualIOMap maphandle = getPackingIOMap();
+	MemoryNodeFileWriteHandle writer;
+	writer.addNode(0);
+	Position last(0, 0, 0);
+	for (const Change* change : changes) {
+		packTile(maphandle, writer, reinterpret_cast<const Tile*>(change->data), last);
+	}
+	writer.endNode();
+
+	uLongf size = compressBound(writer.getSize());
+	std::vector<uint8_t> stream(size);
+	if (compress2(stream.data(), &size, writer.getMemory(), writer.getSize(), Z_BEST_SPEED) != Z_OK) {
+		spdlog::warn("[BatchAction::pack] Could not deflate {} tiles, keeping them in memory", changes.size());
+		return false;
+	}
+	stream.resize(size);
+	stream.shrink_to_fit();
+
+	for (Change* change : changes) {
+		delete reinterpret_cast<Tile*>(change->data);
+		change->data = nullptr;
+	}
+
+	packed = std::move(stream);
+	packed_tiles = static_cast<uint32_t>(changes.size());
+	packed_size = static_cast<uint32_t>(writer.getSize());
+	return true;
+}
+
+bool BatchAction::unpack(const uint8_t* data) {
+	if (!isPacked()) {
+		return true;
+	}
+
+	const uint8_t* source = data ? data : packed.data();
+	const size_t source_size = data ? spill_size : packed.size();
+
+	std::vector<uint8_t> stream(packed_size);
+	uLongf size = packed_size;
+	bool ok = source && uncompress(stream.data(), &size, source, source_size) == Z_OK && size == packed_size;
+
+	Map &map = editor.getMap();
+	const VirtualIOMap maphandle = getPackingIOMap();
+	MemoryNodeFileReadHandle reader(stream.data(), ok ? stream.size() : 0);
+	BinaryNode* root = ok ? reader.getRootNode() : nullptr;
+	BinaryNode* node = root ? root->getChild() : nullptr;
+	Position last(0, 0, 0);
+
+	uint32_t restored = 0;
+	for (Action* action : batch) {
+		for (Change* change : action->changes) {
+			if (change->getType() != CHANGE_TILE || change->data) {
+				continue;
+			}
+			Tile* tile = node ? unpackTile(maphandle, map, node, last) : nullptr;
+			if (tile) {
+				change->data = tile;
+				++restored;
+				node = node->advance();
+			} else {
+				// Can't be undone anymore, better to skip it than to put a broken tile on the map
+				change->clear();
+				node = nullptr;
+			}
+		}
+	}
+
+	if (restored != packed_tiles) {
+		spdlog::error("[BatchAction::unpack] Restored {} of {} packed tiles, the rest of the undo step is lost", restored, packed_tiles);
+		ok = false;
+	}
+
+	packed.clear();
+	packed.shrink_to_fit();
+	packed_tiles = 0;
+	packed_size = 0;
+	return ok;
+}
+
 void BatchAction::merge(BatchAction* other) {
 	batch.insert(batch.end(), other->batch.begin(), other->batch.end());
 	other->batch.clear();
 }
 
+UndoSpillFile::~UndoSpillFile() {
+	close();
+}
+
+bool UndoSpillFile::write(const std::vector<uint8_t> &data, uint64_t &offset) {
+	if (!file) {
+		const wxString name = wxFileName::CreateTempFileName(g_gui.GetLocalDataDirectory() + "undo");
+		if (name.empty()) {
+			return false;
+		}
+		path = nstr(name);
+		file = fopen(path.c_str(), "w+b");
+		if (!file) {
+			wxRemoveFile(name);
+			path.clear();
+			return false;
+		}
+		file_size = 0;
+	}
+
+	if (fseek(file, 0, SEEK_END) != 0 || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+		return false;
+	}
+	offset = file_size;
+	file_size += data.size();
+	live_bytes += data.size();
+	return true;
+}
+
+const uint8_t* UndoSpillFile::read(uint64_t offset, size_t size) {
+	if (!file || offset + size > file_size) {
+		return nullptr;
+	}
+	if (!mapping.isOpen() || offset + size > mapping.getSize()) {
+		mapping.close();
+		fflush(file);
+		if (!mapping.open(path)) {
+			return nullptr;
+		}
+	}
+	return mapping.getData() + offset;
+}
+
+void UndoSpillFile::release(size_t size) {
+	live_bytes -= std::min<uint64_t>(live_bytes, size);
+	if (live_bytes == 0) {
+		close();
+	}
+}
+
+void UndoSpillFile::close() {
+	mapping.close();
+	if (file) {
+		fclose(file);
+		file = nullptr;
+	}
+	if (!path.empty()) {
+		wxRemoveFile(wxstr(path));
+		path.clear();
+	}
+	file_size = 0;
+	live_bytes = 0;
+}
+
 ActionQueue::ActionQueue(Editor &editor) :
 	current(0), memory_size(0), editor(editor) {
 	////
@@ -514,6 +839,7 @@ ActionQueue::~ActionQueue() {
 		delete batch;
 	}
 	actions.clear();
+	spill.close();
 }
 
 Action* ActionQueue::createAction(ActionIdentifier identifier) const {
@@ -560,21 +886,14 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		memory_size -= actions.back()->memsize();
 		BatchAction* todelete = actions.back();
 		actions.pop_back();
-		delete todelete;
-	}
-
-	while (memory_size > size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE)) && !actions.empty()) {
-		memory_size -= actions.front()->memsize();
-		delete actions.front();
-		actions.pop_front();
-		current--;
+		destroy(todelete);
 	}
 
 	if (actions.size() > size_t(g_settings.getInteger(Config::UNDO_SIZE)) && !actions.empty()) {
 		memory_size -= actions.front()->memsize();
 		BatchAction* todelete = actions.front();
 		actions.pop_front();
-		delete todelete;
+		destroy(todelete);
 		current--;
 	}
 
@@ -582,6 +901,7 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		if (!actions.empty()) {
 			BatchAction* lastAction = actions.back();
 			if (lastAction->type == batch->type && g_settings.getInteger(Config::GROUP_ACTIONS) && time(nullptr) - stacking_delay < lastAction->timestamp) {
+				restore(lastAction);
 				lastAction->merge(batch);
 				lastAction->timestamp = time(nullptr);
 				memory_size -= lastAction->memsize();
@@ -595,6 +915,8 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		batch->timestamp = time(nullptr);
 		current++;
 	} while (false);
+
+	compact();
 }
 
 void ActionQueue::addAction(Action* action, int stacking_delay) {
@@ -628,8 +950,10 @@ bool ActionQueue::undo() {
 		current--;
 		BatchAction* batch = actions.at(current);
 		if (batch) {
+			restore(batch);
 			batch->undo();
 		}
+		compact();
 
 		// Update title
 		if (batch && batch->isNoSelection() && editor.getMap().doChange()) {
@@ -644,9 +968,11 @@ bool ActionQueue::redo() {
 	if (current < actions.size()) {
 		BatchAction* batch = actions.at(current);
 		if (batch) {
+			restore(batch);
 			batch->redo();
 		}
 		current++;
+		compact();
 
 		// Update title
 		if (batch && batch->isNoSelection() && editor.getMap().doChange()) {
@@ -671,10 +997,94 @@ void ActionQueue::clear() {
 		delete batch;
 	}
 	actions.clear();
+	spill.close();
 	memory_size = 0;
 	current = 0;
 }
 
+void ActionQueue::compact() {
+	const size_t budget = size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE));
+	if (memory_size <= budget) {
+		return;
+	}
+
+	// Furthest from the current position first, the next undo and redo steps stay as they are
+	std::vector<BatchAction*> candidates;
+	for (size_t index = 0; index + 1 < current; ++index) {
+		candidates.push_back(actions[index]);
+	}
+	for (size_t index = actions.size(); index > current + 1; --index) {
+		candidates.push_back(actions[index - 1]);
+	}
+
+	for (BatchAction* batch : candidates) {
+		if (memory_size <= budget) {
+			return;
+		}
+		const size_t before = batch->memsize();
+		if (batch->pack()) {
+			memory_size -= before;
+			memory_size += batch->memsize(true);
+		}
+	}
+
+	if (g_settings.getBoolean(Config::UNDO_DISK_SPILL)) {
+		for (BatchAction* batch : candidates) {
+			if (memory_size <= budget) {
+				return;
+			}
+			if (!batch->isPacked() || batch->isSpilled()) {
+				continue;
+			}
+			if (!spill.write(batch->packed, batch->spill_offset)) {
+				spdlog::warn("[ActionQueue::compact] Could not write to the undo spill file, dropping old undo steps instead");
+				break;
+			}
+			const size_t before = batch->memsize();
+			batch->spill_size = static_cast<uint32_t>(batch->packed.size());
+			batch->packed.clear();
+			batch->packed.shrink_to_fit();
+			memory_size -= before;
+			memory_size += batch->memsize(true);
+		}
+	}
+
+	while (memory_size > budget && current > 1) {
+		memory_size -= actions.front()->memsize();
+		destroy(actions.front());
+		actions.pop_front();
+		current--;
+	}
+}
+
+bool ActionQueue::restore(BatchAction* batch) {
+	if (!batch->isPacked()) {
+		return true;
+	}
+
+	const size_t before = batch->memsize();
+	bool ok;
+	if (batch->isSpilled()) {
+		const uint8_t* data = spill.read(batch->spill_offset, batch->spill_size);
+		ok = batch->unpack(data);
+		spill.release(batch->spill_size);
+		batch->spill_offset = 0;
+		batch->spill_size = 0;
+	} else {
+		ok = batch->unpack();
+	}
+	memory_size -= before;
+	memory_size += batch->memsize(true);
+	return ok;
+}
+
+void ActionQueue::destroy(BatchAction* batch) {
+	if (batch->isSpilled()) {
+		spill.release(batch->spill_size);
+	}
+	delete batch;
+}
+
 wxString ActionQueue::createLabel(ActionIdentifier type) {
 	switch (type) {
 		case ACTION_MOVE:
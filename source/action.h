@@ -19,6 +19,7 @@
 #define RME_ACTION_H_
 
 #include "position.h"
+#include "filehandle.h"
 
 class Editor;
 class Tile;
@@ -77,6 +78,7 @@ public:
 	ChangeType getType() const noexcept {
 		return type;
 	}
+	// Null for tile changes whose tile is in the batch's packed stream (see BatchAction::pack)
 	void* getData() const noexcept {
 		return data;
 	}
@@ -89,6 +91,7 @@ private:
 	void* data;
 
 	friend class Action;
+	friend class BatchAction;
 };
 
 typedef std::vector<Change*> ChangeList;
@@ -165,6 +168,7 @@ protected:
 	ActionIdentifier type;
 
 	friend class ActionQueue;
+	friend class BatchAction;
 };
 
 typedef std::vector<Action*> ActionVector;
@@ -193,12 +197,26 @@ public:
 	}
 	bool isNoSelection() const noexcept;
 
+	// Packed batches hold their tiles serialized and deflated, either in memory or in the spill file
+	bool isPacked() const noexcept {
+		return packed_tiles != 0;
+	}
+	bool isSpilled() const noexcept {
+		return spill_size != 0;
+	}
+
 	virtual void addAction(Action* action);
 	virtual void addAndCommitAction(Action* action);
 
 protected:
 	BatchAction(Editor &editor, ActionIdentifier ident);
 
+	// Serializes every tile of the batch's changes into one deflated stream and frees the tiles.
+	// Returns false if there was nothing worth packing.
+	bool pack();
+	// Rebuilds the tiles, data is the deflated stream when the batch was spilled
+	bool unpack(const uint8_t* data = nullptr);
+
 	virtual void commit();
 	virtual void undo();
 	virtual void redo();
@@ -212,9 +230,46 @@ protected:
 	ActionVector batch;
 	wxString label;
 
+	// Deflated tile stream while packed and in memory
+	std::vector<uint8_t> packed;
+	uint32_t packed_tiles = 0;
+	uint32_t packed_size = 0; // Before deflating
+	uint64_t spill_offset = 0;
+	uint32_t spill_size = 0;
+
 	friend class ActionQueue;
 };
 
+// Append only temporary file holding packed undo batches that didn't fit in memory,
+// read back through a mapping of the file
+class UndoSpillFile {
+public:
+	UndoSpillFile() = default;
+	~UndoSpillFile();
+
+	UndoSpillFile(const UndoSpillFile &) = delete;
+	UndoSpillFile &operator=(const UndoSpillFile &) = delete;
+
+	// Returns false if the file could not be written
+	bool write(const std::vector<uint8_t> &data, uint64_t &offset);
+	// Returns nullptr if the range can't be mapped, valid until the next write or release
+	const uint8_t* read(uint64_t offset, size_t size);
+	// The range is no longer needed, the file is emptied once nothing in it is
+	void release(size_t size);
+	void close();
+
+	uint64_t getLiveBytes() const noexcept {
+		return live_bytes;
+	}
+
+private:
+	std::string path;
+	FILE* file = nullptr;
+	FileMapping mapping;
+	uint64_t file_size = 0;
+	uint64_t live_bytes = 0;
+};
+
 class ActionQueue {
 public:
 	ActionQueue(Editor &editor);
@@ -262,10 +317,18 @@ public:
 protected:
 	static wxString createLabel(ActionIdentifier type);
 
+	// Packs, then spills, the batches furthest from the current position until the history
+	// fits in UNDO_MEM_SIZE again. Only drops batches when spilling is off or fails.
+	void compact();
+	// Makes sure the batch holds its tiles again before it's undone or redone
+	bool restore(BatchAction* batch);
+	void destroy(BatchAction* batch);
+
 	size_t current;
 	size_t memory_size;
 	Editor &editor;
 	ActionList actions;
+	UndoSpillFile spill;
 };
 
 #endif
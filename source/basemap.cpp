@@ -20,11 +20,15 @@
 #include "tile.h"
 #include "basemap.h"
 
-BaseMap::BaseMap() :
+#include <atomic>
+
+BaseMap::BaseMap(bool use_page_table) :
 	allocator(),
 	tilecount(0),
-	root(*this) {
-	////
+	root(*this),
+	leaf_table(use_page_table ? newd LeafPageTable() : nullptr) {
+	static std::atomic<uint64_t> next_instance_id { 1 };
+	instance_id = next_instance_id++;
 }
 
 BaseMap::~BaseMap() {
@@ -40,6 +44,44 @@ void BaseMap::clear(bool del) {
 	for (PositionVector::iterator pos_iter = pos_vec.begin(); pos_iter != pos_vec.end(); ++pos_iter) {
 		setTile(*pos_iter, nullptr, del);
 	}
+	if (del) {
+		allocator.releaseUnused();
+	}
+}
+
+QTreeNode* BaseMap::createLeaf(int x, int y) {
+	if (!leaf_table) {
+		return root.getLeafForce(x, y);
+	}
+
+	QTreeNode* leaf = leaf_table->get(x, y);
+	if (!leaf) {
+		// Leaves live until the map is destroyed, so the table never holds stale entries
+		leaf = root.getLeafForce(x, y);
+		leaf_table->set(x, y, leaf);
+	}
+	return leaf;
+}
+
+void BaseMap::trackDirtyAreas() {
+	dirty_areas.assign(TileAreaCount / 64, ~uint64_t(0));
+}
+
+void BaseMap::markAllAreasDirty() {
+	std::fill(dirty_areas.begin(), dirty_areas.end(), ~uint64_t(0));
+	for (uint32_t &revision : area_revisions) {
+		++revision;
+	}
+}
+
+void BaseMap::trackAreaRevisions() {
+	if (area_revisions.empty()) {
+		area_revisions.assign(TileAreaCount, 0);
+	}
+}
+
+void BaseMap::clearDirtyAreas() {
+	std::fill(dirty_areas.begin(), dirty_areas.end(), uint64_t(0));
 }
 
 void BaseMap::clearVisible(uint32_t mask) {
@@ -48,7 +90,7 @@ void BaseMap::clearVisible(uint32_t mask) {
 
 Tile* BaseMap::createTile(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	TileLocation* loc = leaf->createTile(x, y, z);
 	if (loc->get()) {
 		return loc->get();
@@ -60,7 +102,7 @@ Tile* BaseMap::createTile(int x, int y, int z) {
 
 TileLocation* BaseMap::getTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeaf(x, y);
+	QTreeNode* leaf = getLeaf(x, y);
 	if (leaf) {
 		Floor* floor = leaf->getFloor(z);
 		if (floor) {
@@ -87,7 +129,7 @@ const TileLocation* BaseMap::getTileL(const Position &pos) const {
 TileLocation* BaseMap::createTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Floor* floor = leaf->createFloor(x, y, z);
 	uint32_t offsetX = x & 3;
 	uint32_t offsetY = y & 3;
@@ -104,8 +146,9 @@ void BaseMap::setTile(int x, int y, int z, Tile* new_tile, bool remove) {
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
+	markAreaDirty(x, y, z);
 
 	if ((remove && old_tile) || new_tile) {
 		updateUniqueIds(remove ? old_tile : nullptr, new_tile);
@@ -133,8 +176,9 @@ Tile* BaseMap::swapTile(int x, int y, int z, Tile* new_tile) {
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
+	markAreaDirty(x, y, z);
 
 	if (old_tile || new_tile) {
 		updateUniqueIds(old_tile, new_tile);
@@ -174,53 +218,8 @@ MapIterator::MapIterator(const MapIterator &other) {
 MapIterator BaseMap::begin() {
 	MapIterator it(this);
 	it.nodestack.push_back(MapIterator::NodeIndex(&root));
-
-	while (true) {
-		MapIterator::NodeIndex &current = it.nodestack.back();
-		QTreeNode* node = current.node;
-		int &index = current.index;
-		// printf("Contemplating %p of %p (stack size %d)\n", node, this, it.nodestack.size());
-
-		bool unwind = false;
-		for (; index < 16; ++index) {
-			// printf("\tChecking index %d of %p\n", index, node);
-			if (QTreeNode* child = node->child[index]) {
-				if (child->isLeaf) {
-					QTreeNode* leaf = child;
-					// printf("\t%p is leaf\n", child);
-					for (it.local_z = 0; it.local_z < rme::MapLayers; ++it.local_z) {
-						if (Floor* floor = leaf->array[it.local_z]) {
-							for (it.local_i = 0; it.local_i < 16; ++it.local_i) {
-								// printf("\tit(%d;%d;%d)\n", it.local_x, it.local_y, it.local_z);
-								TileLocation &t = floor->locs[it.local_i];
-								if (t.get()) {
-									// printf("return it\n");
-									it.current_tile = &t;
-									return it;
-								}
-							}
-						}
-					}
-				} else {
-					// printf("\tAdding %p\n", child);
-					++index;
-					it.nodestack.push_back(MapIterator::NodeIndex(child));
-					unwind = true;
-					break;
-				}
-			}
-		}
-		if (unwind) {
-			continue;
-		}
-
-		// printf("Discarding dead node %p\n", node);
-		it.nodestack.pop_back();
-		if (it.nodestack.empty()) {
-			break;
-		}
-	}
-	return end();
+	it.seek(false);
+	return it;
 }
 
 MapIterator BaseMap::end() {
@@ -239,79 +238,56 @@ TileLocation* MapIterator::operator->() {
 }
 
 MapIterator &MapIterator::operator++() {
-	// printf("MapIterator::operator++");
-	bool increased = false;
-	bool first = true;
-	while (true) {
-		MapIterator::NodeIndex &current = nodestack.back();
-		QTreeNode* node = current.node;
-		int &index = current.index;
-		// printf("Contemplating %p (stack size %d)\n", node, nodestack.size());
-
-		bool unwind = false;
-		for (; index < rme::MapLayers; ++index) {
-			// printf("\tChecking index %d of %p\n", index, node);
-			if (QTreeNode* child = node->child[index]) {
-				if (child->isLeaf) {
-					QTreeNode* leaf = child;
-					// printf("\t%p is leaf\n", child);
-					for (; local_z < rme::MapLayers; ++local_z) {
-						// printf("\t\tIterating over Z:%d of %p", local_z, child);
-						if (Floor* floor = leaf->array[local_z]) {
-							// printf("\n");
-							for (; local_i < rme::MapLayers; ++local_i) {
-								// printf("\t\tIterating over Y:%d of %p\n", local_y, child);
-								TileLocation &t = floor->locs[local_i];
-								if (t.get()) {
-									if (increased) {
-										// printf("Modified %p to %p\n", current_tile, t);
-										current_tile = &t;
-										return *this;
-									} else {
-										increased = true;
-									}
-								} else if (first) {
-									increased = true;
-									first = false;
-								}
-							}
-
-							if (local_i > rme::MapMaxLayer) {
-								// printf("\t\tReset local_x\n");
-								local_i = 0;
-							}
-						} else {
-							// printf(":dead floor\n");
-						}
-					}
-					if (local_z == rme::MapLayers) {
-						// printf("\t\tReset local_z\n");
-						local_z = 0;
-					}
-				} else {
-					// printf("\tAdding %p\n", child);
-					++index;
-					nodestack.push_back(MapIterator::NodeIndex(child));
-					unwind = true;
-					break;
-				}
-			}
+	seek(true);
+	return *this;
+}
+
+bool MapIterator::seekLeaf(QTreeNode* leaf) {
+	for (; local_z < rme::MapLayers; ++local_z, local_i = 0) {
+		// Drop the slots before local_i, local_i may be one past the last slot
+		const uint32_t mask = (static_cast<uint32_t>(leaf->occupied[local_z]) >> local_i) << local_i;
+		if (mask != 0) {
+			local_i = std::countr_zero(mask);
+			current_tile = &leaf->array[local_z]->locs[local_i];
+			return true;
 		}
-		if (unwind) {
+	}
+	local_z = 0;
+	local_i = 0;
+	return false;
+}
+
+void MapIterator::seek(bool skip_current) {
+	if (skip_current) {
+		++local_i;
+	}
+
+	while (!nodestack.empty()) {
+		MapIterator::NodeIndex &current = nodestack.back();
+		if (current.index >= rme::MapLayers) {
+			nodestack.pop_back();
 			continue;
 		}
 
-		// printf("Discarding dead node %p\n", node);
-		nodestack.pop_back();
-		if (nodestack.size() == 0) {
-			// Set all values to "end"
-			// printf("END\n");
-			local_z = -1;
-			local_i = -1;
-			return *this;
+		QTreeNode* child = current.node->child[current.index];
+		if (!child) {
+			++current.index;
+		} else if (child->isLeaf) {
+			// The parent index stays on the leaf while we're inside it
+			if (seekLeaf(child)) {
+				return;
+			}
+			++current.index;
+		} else {
+			++current.index;
+			nodestack.push_back(MapIterator::NodeIndex(child));
 		}
 	}
-	return *this;
+
+	// Set all values to "end"
+	local_z = -1;
+	local_i = -1;
+	current_tile = nullptr;
 }
 
 MapIterator MapIterator::operator++(int) {
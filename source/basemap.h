@@ -22,6 +22,7 @@
 #include "position.h"
 #include "filehandle.h"
 #include "map_allocator.h"
+#include "map_region.h"
 #include "tile.h"
 
 // Class declarations
@@ -75,6 +76,10 @@ public:
 	};
 
 private:
+	// Moves to the next occupied slot using the leaves' occupancy masks
+	void seek(bool skip_current);
+	bool seekLeaf(QTreeNode* leaf);
+
 	std::vector<NodeIndex> nodestack;
 	int local_i, local_z;
 	TileLocation* current_tile;
@@ -85,7 +90,8 @@ private:
 
 class BaseMap {
 public:
-	BaseMap();
+	// With use_page_table, leaves are also indexed by a LeafPageTable so tile lookups skip the tree descent
+	explicit BaseMap(bool use_page_table = false);
 	virtual ~BaseMap();
 
 	// This doesn't destroy the map structure, just clears it, if param is true, delete all tiles too.
@@ -111,10 +117,18 @@ public:
 
 	// Get a Quad Tree Leaf from the map
 	QTreeNode* getLeaf(int x, int y) {
+		if (leaf_table) {
+			return leaf_table->get(x, y);
+		}
 		return root.getLeaf(x, y);
 	}
-	QTreeNode* createLeaf(int x, int y) {
-		return root.getLeafForce(x, y);
+	QTreeNode* createLeaf(int x, int y);
+
+	bool usesLeafPageTable() const noexcept {
+		return leaf_table != nullptr;
+	}
+	size_t getLeafPageCount() const noexcept {
+		return leaf_table ? leaf_table->getPageCount() : 0;
 	}
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
@@ -132,6 +146,58 @@ public:
 		return tilecount;
 	}
 
+	// Tile areas (256x256 tiles on one floor, the extent of an OTBM_TILE_AREA node) changed since
+	// the last save. Tracking stays off until enabled, so scratch maps don't pay for it.
+	static constexpr uint32_t TileAreaCount = 256 * 256 * rme::MapLayers;
+	static uint32_t getTileAreaKey(int x, int y, int z) noexcept {
+		return (static_cast<uint32_t>(z & 0xF) << 16) | (static_cast<uint32_t>((y >> 8) & 0xFF) << 8) | static_cast<uint32_t>((x >> 8) & 0xFF);
+	}
+
+	void trackDirtyAreas();
+	bool isTrackingDirtyAreas() const noexcept {
+		return !dirty_areas.empty();
+	}
+	void markAreaDirty(int x, int y, int z) {
+		if (!dirty_areas.empty()) {
+			const uint32_t key = getTileAreaKey(x, y, z);
+			dirty_areas[key >> 6] |= uint64_t(1) << (key & 63);
+		}
+		if (!area_revisions.empty()) {
+			++area_revisions[getTileAreaKey(x, y, z)];
+		}
+	}
+	void markAreaDirty(const Position &pos) {
+		markAreaDirty(pos.x, pos.y, pos.z);
+	}
+	// For rectangles no larger than a tile area, such as spawn radii, so the corners hit every area
+	void markAreasDirty(int start_x, int start_y, int end_x, int end_y, int z) {
+		markAreaDirty(std::max(start_x, 0), std::max(start_y, 0), z);
+		markAreaDirty(end_x, std::max(start_y, 0), z);
+		markAreaDirty(std::max(start_x, 0), end_y, z);
+		markAreaDirty(end_x, end_y, z);
+	}
+	void markAllAreasDirty();
+	void clearDirtyAreas();
+	bool isAreaDirty(uint32_t key) const {
+		return dirty_areas.empty() || (dirty_areas[key >> 6] & (uint64_t(1) << (key & 63))) != 0;
+	}
+
+	// Per tile area counters bumped whenever one of the area's tiles is replaced, so caches built
+	// from the map (the minimap) know what to rebuild. Unlike the dirty bits they are never reset.
+	void trackAreaRevisions();
+	uint32_t getAreaRevision(uint32_t key) const noexcept {
+		return area_revisions.empty() ? 0 : area_revisions[key];
+	}
+	// Unique for the life of the process, caches use it to tell maps apart
+	uint64_t getInstanceId() const noexcept {
+		return instance_id;
+	}
+
+	// Calls fn(x, y, node) for every 256x256 column of the map holding leaves, node being the
+	// subtree that covers exactly that column and x/y its top-left tile
+	template <typename F>
+	void forEachTileAreaColumn(F &&fn);
+
 public:
 	MapAllocator allocator;
 
@@ -141,10 +207,32 @@ protected:
 	uint64_t tilecount;
 
 	QTreeNode root; // The Quad Tree root
+	std::unique_ptr<LeafPageTable> leaf_table; // Only when selected at creation
+	std::vector<uint64_t> dirty_areas; // One bit per tile area key, empty when not tracking
+	std::vector<uint32_t> area_revisions; // Per tile area key, empty when not tracking
+	uint64_t instance_id;
 
 	friend class QTreeNode;
 };
 
+template <typename F>
+void BaseMap::forEachTileAreaColumn(F &&fn) {
+	// Every level splits x and y in four, so four levels down a node spans 256x256 tiles
+	const auto visit = [&fn](const auto &self, QTreeNode* node, int depth, int x, int y) -> void {
+		if (depth == 4) {
+			fn(x, y, *node);
+			return;
+		}
+		const int shift = 14 - depth * 2;
+		for (int i = 0; i < 16; ++i) {
+			if (QTreeNode* child = node->child[i]) {
+				self(self, child, depth + 1, x | ((i & 3) << shift), y | ((i >> 2) << shift));
+			}
+		}
+	};
+	visit(visit, &root, 0, 0, 0);
+}
+
 inline Tile* BaseMap::getTile(int x, int y, int z) {
 	TileLocation* l = getTileL(x, y, z);
 	return l ? l->get() : nullptr;
@@ -564,6 +564,7 @@ ExportMiniMapWindow::ExportMiniMapWindow(wxWindow* parent, Editor &editor) :
 	format_choices.Add(".otmm (Client Minimap)");
 	format_choices.Add(".png (PNG Image)");
 	format_choices.Add(".bmp (Bitmap Image)");
+	format_choices.Add(".png tiles (Zoomable Pyramid)");
 	format_options = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, format_choices);
 	format_options->SetSelection(0);
 	tmpsizer->Add(format_options, 1, wxALL, 5);
@@ -605,8 +606,13 @@ ExportMiniMapWindow::ExportMiniMapWindow(wxWindow* parent, Editor &editor) :
 ExportMiniMapWindow::~ExportMiniMapWindow() = default;
 
 void ExportMiniMapWindow::OnExportTypeChange(wxCommandEvent &event) {
-	imageSizeOptions->Enable(event.GetSelection() > 0);
-	floor_number->Enable(event.GetSelection() == 2);
+	if (event.GetEventObject() == format_options) {
+		// Pyramid tiles have a fixed size
+		const auto format = static_cast<MinimapExportFormat>(event.GetSelection());
+		imageSizeOptions->Enable(format == MinimapExportFormat::Png || format == MinimapExportFormat::Bmp);
+	} else if (event.GetEventObject() == floor_options) {
+		floor_number->Enable(event.GetSelection() == 2);
+	}
 }
 
 void ExportMiniMapWindow::OnClickBrowse(wxCommandEvent &WXUNUSED(event)) {
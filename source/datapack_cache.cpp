@@ -0,0 +1,404 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "datapack_cache.h"
+#include "items.h"
+#include "monsters.h"
+#include "npcs.h"
+
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+	constexpr uint32_t DatapackMagic = 0x50444D52; // "RMDP"
+	constexpr uint32_t DatapackVersion = 1;
+
+	enum ItemRecordFlag : uint16_t {
+		ITEM_CAN_READ_TEXT = 1 << 0,
+		ITEM_CAN_WRITE_TEXT = 1 << 1,
+		ITEM_DECAYS = 1 << 2,
+		ITEM_ALLOW_DIST_READ = 1 << 3,
+		ITEM_EXTRA_CHARGEABLE = 1 << 4,
+		ITEM_FLOOR_CHANGE = 1 << 5,
+		ITEM_FLOOR_CHANGE_DOWN = 1 << 6,
+		ITEM_FLOOR_CHANGE_NORTH = 1 << 7,
+		ITEM_FLOOR_CHANGE_SOUTH = 1 << 8,
+		ITEM_FLOOR_CHANGE_EAST = 1 << 9,
+		ITEM_FLOOR_CHANGE_WEST = 1 << 10,
+	};
+
+	// FNV-1a, only used to tell source sets apart
+	uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	uint64_t hashValue(uint64_t hash, const T &value) {
+		return hashBytes(hash, &value, sizeof(value));
+	}
+
+	// Bounds checked reads straight from the mapped file
+	class SnapshotReader {
+	public:
+		SnapshotReader(const uint8_t* data, size_t size) :
+			position(data), end(data + size) { }
+
+		template <typename T>
+		bool get(T &value) {
+			if (static_cast<size_t>(end - position) < sizeof(T)) {
+				return false;
+			}
+			std::memcpy(&value, position, sizeof(T));
+			position += sizeof(T);
+			return true;
+		}
+
+		bool getString(std::string &str) {
+			uint32_t length;
+			if (!get(length) || static_cast<size_t>(end - position) < length) {
+				return false;
+			}
+			str.assign(reinterpret_cast<const char*>(position), length);
+			position += length;
+			return true;
+		}
+
+		bool getWarnings(wxArrayString &warnings) {
+			uint32_t count;
+			if (!get(count)) {
+				return false;
+			}
+			std::string warning;
+			for (uint32_t i = 0; i < count; ++i) {
+				if (!getString(warning)) {
+					return false;
+				}
+				warnings.push_back(wxstr(warning));
+			}
+			return true;
+		}
+
+		bool getCreatures(std::vector<DatapackCache::CreatureRecord> &creatures) {
+			uint32_t count;
+			if (!get(count)) {
+				return false;
+			}
+			for (uint32_t i = 0; i < count; ++i) {
+				DatapackCache::CreatureRecord &creature = creatures.emplace_back();
+				Outfit &outfit = creature.outfit;
+				if (!get(creature.standard) || !getString(creature.name)) {
+					return false;
+				}
+				if (!get(outfit.lookType) || !get(outfit.lookItem) || !get(outfit.lookMount) || !get(outfit.lookAddon) || !get(outfit.lookHead) || !get(outfit.lookBody) || !get(outfit.lookLegs) || !get(outfit.lookFeet)) {
+					return false;
+				}
+				outfit.name = creature.name;
+			}
+			return true;
+		}
+
+	private:
+		const uint8_t* position;
+		const uint8_t* end;
+	};
+
+	class SnapshotWriter {
+	public:
+		template <typename T>
+		void add(const T &value) {
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void addString(const std::string &str) {
+			add(static_cast<uint32_t>(str.size()));
+			buffer.append(str);
+		}
+
+		void addWarnings(const wxArrayString &warnings) {
+			add(static_cast<uint32_t>(warnings.size()));
+			for (const wxString &warning : warnings) {
+				addString(nstr(warning));
+			}
+		}
+
+		template <typename Database>
+		void addCreatures(Database &database) {
+			const size_t count_offset = buffer.size();
+			add(uint32_t(0));
+
+			uint32_t count = 0;
+			for (const auto &[key, type] : database) {
+				if (type->missing) {
+					continue;
+				}
+				const Outfit &outfit = type->outfit;
+				add(type->standard);
+				addString(type->name);
+				add(outfit.lookType);
+				add(outfit.lookItem);
+				add(outfit.lookMount);
+				add(outfit.lookAddon);
+				add(outfit.lookHead);
+				add(outfit.lookBody);
+				add(outfit.lookLegs);
+				add(outfit.lookFeet);
+				++count;
+			}
+			std::memcpy(buffer.data() + count_offset, &count, sizeof(count));
+		}
+
+		const std::string &getBuffer() const noexcept {
+			return buffer;
+		}
+
+	private:
+		std::string buffer;
+	};
+}
+
+bool DatapackCache::open(const std::string &path, const std::vector<std::string> &sources) {
+	close();
+	this->path = path;
+
+	// A new editor version may read the xml differently, so it is part of the key
+	uint64_t hash = hashValue(0xCBF29CE484222325ULL, DatapackVersion);
+	hash = hashValue(hash, static_cast<uint32_t>(__RME_VERSION_ID__));
+	for (const std::string &source : sources) {
+		hash = hashBytes(hash, source.data(), source.size());
+		FileMapping file;
+		if (file.open(source)) {
+			hash = hashValue(hash, static_cast<uint64_t>(file.getSize()));
+			hash = hashBytes(hash, file.getData(), file.getSize());
+		} else {
+			hash = hashValue(hash, uint64_t(0));
+		}
+	}
+	key = hash;
+
+	FileMapping mapping;
+	if (!mapping.open(path)) {
+		return false;
+	}
+
+	SnapshotReader reader(mapping.getData(), mapping.getSize());
+	uint32_t magic, version;
+	uint64_t file_key;
+	if (!reader.get(magic) || magic != DatapackMagic || !reader.get(version) || version != DatapackVersion || !reader.get(file_key) || file_key != key) {
+		spdlog::info("[DatapackCache::open] - Data files changed, reloading them from xml");
+		return false;
+	}
+
+	uint32_t count;
+	bool ok = reader.get(max_item_id) && reader.getWarnings(item_warnings) && reader.get(count);
+	for (uint32_t i = 0; ok && i < count; ++i) {
+		ItemRecord &item = items.emplace_back();
+		ok = reader.get(item.id) && reader.get(item.type) && reader.get(item.group) && reader.get(item.flags)
+			&& reader.get(item.rotateTo) && reader.get(item.volume) && reader.get(item.maxTextLen) && reader.get(item.charges)
+			&& reader.get(item.armor) && reader.get(item.defense) && reader.get(item.weight)
+			&& reader.getString(item.name) && reader.getString(item.editorsuffix) && reader.getString(item.description);
+	}
+	ok = ok && reader.getWarnings(monster_warnings) && reader.getCreatures(monsters);
+	ok = ok && reader.getWarnings(npc_warnings) && reader.getCreatures(npcs);
+	if (!ok) {
+		spdlog::warn("[DatapackCache::open] - {} is damaged, reloading the data files from xml", path);
+		close();
+		this->path = path;
+		key = hash;
+		return false;
+	}
+
+	loaded = true;
+	return true;
+}
+
+void DatapackCache::close() {
+	path.clear();
+	key = 0;
+	loaded = false;
+	max_item_id = 0;
+	items.clear();
+	monsters.clear();
+	npcs.clear();
+	item_warnings.clear();
+	monster_warnings.clear();
+	npc_warnings.clear();
+}
+
+bool DatapackCache::applyItems(wxArrayString &warnings) const {
+	if (!loaded || g_items.getMaxID() != max_item_id) {
+		return false;
+	}
+	for (const ItemRecord &record : items) {
+		if (!g_items.isValidID(record.id)) {
+			return false;
+		}
+	}
+
+	for (const ItemRecord &record : items) {
+		ItemType &item = g_items.getItemType(record.id);
+		item.name = record.name;
+		item.editorsuffix = record.editorsuffix;
+		item.description = record.description;
+		item.type = static_cast<ItemTypes_t>(record.type);
+		item.group = static_cast<ItemGroup_t>(record.group);
+		item.rotateTo = record.rotateTo;
+		item.volume = record.volume;
+		item.maxTextLen = record.maxTextLen;
+		item.charges = record.charges;
+		item.armor = record.armor;
+		item.defense = record.defense;
+		item.weight = record.weight;
+		item.canReadText = record.flags & ITEM_CAN_READ_TEXT;
+		item.canWriteText = record.flags & ITEM_CAN_WRITE_TEXT;
+		item.decays = record.flags & ITEM_DECAYS;
+		item.allowDistRead = record.flags & ITEM_ALLOW_DIST_READ;
+		item.extra_chargeable = record.flags & ITEM_EXTRA_CHARGEABLE;
+		item.floorChange = record.flags & ITEM_FLOOR_CHANGE;
+		item.floorChangeDown = record.flags & ITEM_FLOOR_CHANGE_DOWN;
+		item.floorChangeNorth = record.flags & ITEM_FLOOR_CHANGE_NORTH;
+		item.floorChangeSouth = record.flags & ITEM_FLOOR_CHANGE_SOUTH;
+		item.floorChangeEast = record.flags & ITEM_FLOOR_CHANGE_EAST;
+		item.floorChangeWest = record.flags & ITEM_FLOOR_CHANGE_WEST;
+	}
+	for (const wxString &warning : item_warnings) {
+		warnings.push_back(warning);
+	}
+	return true;
+}
+
+bool DatapackCache::applyMonsters(wxArrayString &warnings) const {
+	if (!loaded) {
+		return false;
+	}
+	for (const CreatureRecord &record : monsters) {
+		if (g_monsters[record.name]) {
+			return false;
+		}
+	}
+
+	for (const CreatureRecord &record : monsters) {
+		g_monsters.addMonsterType(record.name, record.outfit)->standard = record.standard;
+	}
+	for (const wxString &warning : monster_warnings) {
+		warnings.push_back(warning);
+	}
+	return true;
+}
+
+bool DatapackCache::applyNpcs(wxArrayString &warnings) const {
+	if (!loaded) {
+		return false;
+	}
+	for (const CreatureRecord &record : npcs) {
+		if (g_npcs[record.name]) {
+			return false;
+		}
+	}
+
+	for (const CreatureRecord &record : npcs) {
+		g_npcs.addNpcType(record.name, record.outfit)->standard = record.standard;
+	}
+	for (const wxString &warning : npc_warnings) {
+		warnings.push_back(warning);
+	}
+	return true;
+}
+
+bool DatapackCache::store(const wxArrayString &item_warnings, const wxArrayString &monster_warnings, const wxArrayString &npc_warnings) const {
+	if (path.empty()) {
+		return false;
+	}
+
+	SnapshotWriter writer;
+	writer.add(DatapackMagic);
+	writer.add(DatapackVersion);
+	writer.add(key);
+
+	const uint16_t max_id = g_items.getMaxID();
+	writer.add(max_id);
+	writer.addWarnings(item_warnings);
+
+	std::vector<uint16_t> ids;
+	for (uint16_t id = 1; id != 0 && id <= max_id; ++id) {
+		if (g_items.isValidID(id)) {
+			ids.push_back(id);
+		}
+	}
+	writer.add(static_cast<uint32_t>(ids.size()));
+	for (const uint16_t id : ids) {
+		const ItemType &item = g_items.getItemType(id);
+		uint16_t flags = 0;
+		flags |= item.canReadText ? ITEM_CAN_READ_TEXT : 0;
+		flags |= item.canWriteText ? ITEM_CAN_WRITE_TEXT : 0;
+		flags |= item.decays ? ITEM_DECAYS : 0;
+		flags |= item.allowDistRead ? ITEM_ALLOW_DIST_READ : 0;
+		flags |= item.extra_chargeable ? ITEM_EXTRA_CHARGEABLE : 0;
+		flags |= item.floorChange ? ITEM_FLOOR_CHANGE : 0;
+		flags |= item.floorChangeDown ? ITEM_FLOOR_CHANGE_DOWN : 0;
+		flags |= item.floorChangeNorth ? ITEM_FLOOR_CHANGE_NORTH : 0;
+		flags |= item.floorChangeSouth ? ITEM_FLOOR_CHANGE_SOUTH : 0;
+		flags |= item.floorChangeEast ? ITEM_FLOOR_CHANGE_EAST : 0;
+		flags |= item.floorChangeWest ? ITEM_FLOOR_CHANGE_WEST : 0;
+
+		writer.add(id);
+		writer.add(static_cast<uint8_t>(item.type));
+		writer.add(static_cast<uint8_t>(item.group));
+		writer.add(flags);
+		writer.add(item.rotateTo);
+		writer.add(item.volume);
+		writer.add(item.maxTextLen);
+		writer.add(static_cast<uint32_t>(item.charges));
+		writer.add(static_cast<int32_t>(item.armor));
+		writer.add(static_cast<int32_t>(item.defense));
+		writer.add(item.weight);
+		writer.addString(item.name);
+		writer.addString(item.editorsuffix);
+		writer.addString(item.description);
+	}
+
+	writer.addWarnings(monster_warnings);
+	writer.addCreatures(g_monsters);
+	writer.addWarnings(npc_warnings);
+	writer.addCreatures(g_npcs);
+
+	// Written under a temporary name so a crash never leaves a truncated snapshot behind
+	const std::string &buffer = writer.getBuffer();
+	{
+		FileWriteHandle file(path + ".tmp");
+		if (!file.isOk() || !file.addRAW(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size())) {
+			spdlog::warn("[DatapackCache::store] - Unable to write {}", path);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(path + ".tmp", path, error);
+	if (error) {
+		fs::remove(path + ".tmp", error);
+		return false;
+	}
+	spdlog::info("[DatapackCache::store] - Wrote {} item types, {} KB", ids.size(), buffer.size() / 1024);
+	return true;
+}
@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_DATAPACK_CACHE_H_
+#define RME_DATAPACK_CACHE_H_
+
+#include "main.h"
+#include "filehandle.h"
+#include "outfit.h"
+
+// Binary snapshot of what items.xml, monsters.xml and npcs.xml (the user files included) add on top
+// of the client assets, so later runs skip parsing them. It is keyed by a hash of the contents of those
+// files and of catalog-content.json, any change to them makes the loader fall back to the xml and
+// write a new snapshot. Materials and brushes are always loaded from xml.
+class DatapackCache {
+public:
+	struct ItemRecord {
+		uint16_t id = 0;
+		uint8_t type = 0;
+		uint8_t group = 0;
+		uint16_t flags = 0;
+		uint16_t rotateTo = 0;
+		uint16_t volume = 0;
+		uint16_t maxTextLen = 0;
+		uint32_t charges = 0;
+		int32_t armor = 0;
+		int32_t defense = 0;
+		float weight = 0.0f;
+		std::string name;
+		std::string editorsuffix;
+		std::string description;
+	};
+
+	struct CreatureRecord {
+		bool standard = false;
+		std::string name;
+		Outfit outfit;
+	};
+
+	// Hashes the sources and reads the snapshot at path if it was made from the same ones
+	bool open(const std::string &path, const std::vector<std::string> &sources);
+	void close();
+
+	bool isLoaded() const noexcept {
+		return loaded;
+	}
+
+	// Fill the databases from the snapshot, false without changing anything if it doesn't fit the loaded assets
+	bool applyItems(wxArrayString &warnings) const;
+	bool applyMonsters(wxArrayString &warnings) const;
+	bool applyNpcs(wxArrayString &warnings) const;
+
+	// Writes the loaded databases for the sources given to open, with the warnings the xml loaders gave
+	bool store(const wxArrayString &item_warnings, const wxArrayString &monster_warnings, const wxArrayString &npc_warnings) const;
+
+private:
+	std::string path;
+	uint64_t key = 0;
+	bool loaded = false;
+
+	uint16_t max_item_id = 0;
+	std::vector<ItemRecord> items;
+	std::vector<CreatureRecord> monsters;
+	std::vector<CreatureRecord> npcs;
+	wxArrayString item_warnings;
+	wxArrayString monster_warnings;
+	wxArrayString npc_warnings;
+};
+
+#endif
@@ -343,12 +343,20 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 
 		// Perform the actual save
 		IOMapOTBM mapsaver(map.getVersion());
+		if (!save_otgz && !backup_otbm.empty()) {
+			// Unchanged tile areas are copied over from the file we just moved aside
+			mapsaver.setPreviousSave(backup_otbm);
+		}
 		bool success = mapsaver.saveMap(map, fn);
 
 		if (showdialog) {
 			g_gui.DestroyLoadBar();
 		}
 
+		if (success && !save_otgz) {
+			g_gui.SetStatusText(wxString::Format("Saved map, %s of tile data reused and %s encoded.", wxFileName::GetHumanReadableSize(wxULongLong(mapsaver.getReusedBytes())), wxFileName::GetHumanReadableSize(wxULongLong(mapsaver.getEncodedBytes()))));
+		}
+
 		// Check for errors...
 		if (!success) {
 			// Rename the temporary backup files back to their previous names
@@ -883,27 +891,103 @@ void Editor::borderizeSelection() {
 	updateActions();
 }
 
+namespace {
+	// Tiles that come out of a map-wide transform unchanged are not worth an undo step
+	bool sameItem(const Item* a, const Item* b) {
+		if (!a || !b) {
+			return a == b;
+		}
+		return a->getID() == b->getID() && a->getSubtype() == b->getSubtype() && a->hasAttributes() == b->hasAttributes();
+	}
+
+	bool sameTile(const Tile* a, const Tile* b) {
+		if (a->getMapFlags() != b->getMapFlags() || a->getStatFlags() != b->getStatFlags()) {
+			return false;
+		}
+		if (!sameItem(a->ground, b->ground) || a->items.size() != b->items.size()) {
+			return false;
+		}
+		return std::ranges::equal(a->items, b->items, sameItem);
+	}
+
+	// Runs transform(tile) on every tile of the map and returns the changed copies in map order.
+	// One job per 256x256 column: jobs only read the map (neighbours past the column edge
+	// included) and write to their own copies, so the result doesn't depend on the thread count.
+	template <typename F>
+	std::vector<Tile*> transformMap(Map &map, bool showdialog, F &&transform) {
+		std::vector<QTreeNode*> columns;
+		map.forEachTileAreaColumn([&columns](int, int, QTreeNode &column) { columns.push_back(&column); });
+
+		ThreadPool pool;
+		std::vector<std::future<std::vector<Tile*>>> pending;
+		pending.reserve(columns.size());
+		for (QTreeNode* column : columns) {
+			pending.push_back(pool.enqueue([&transform, column]() {
+				std::vector<Tile*> changed;
+				column->forEachLeaf([&](QTreeNode &leaf) {
+					for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+						leaf.forEachTile(z, [&](TileLocation &location) {
+							const Tile* tile = location.get();
+							Tile* new_tile = tile ? transform(tile) : nullptr;
+							if (!new_tile) {
+								return;
+							}
+							if (sameTile(tile, new_tile)) {
+								delete new_tile;
+							} else {
+								changed.push_back(new_tile);
+							}
+						});
+					}
+				});
+				return changed;
+			}));
+		}
+
+		std::vector<Tile*> changed;
+		for (size_t i = 0; i < pending.size(); ++i) {
+			if (showdialog) {
+				g_gui.SetLoadDone(static_cast<int32_t>(100.0 * i / pending.size()));
+			}
+			std::vector<Tile*> column = pending[i].get();
+			changed.insert(changed.end(), column.begin(), column.end());
+		}
+		return changed;
+	}
+
+	uint64_t mixPosition(uint64_t seed, const Position &pos) {
+		// splitmix64 finalizer
+		uint64_t value = seed ^ (static_cast<uint64_t>(pos.x) | static_cast<uint64_t>(pos.y) << 16 | static_cast<uint64_t>(pos.z) << 32);
+		value += 0x9E3779B97F4A7C15ULL;
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+}
+
 void Editor::borderizeMap(bool showdialog) {
 	if (showdialog) {
 		g_gui.CreateLoadBar("Borderizing map...");
 	}
 
-	uint64_t tiles_done = 0;
-	for (TileLocation* tileLocation : map) {
-		if (showdialog && tiles_done % 4096 == 0) {
-			g_gui.SetLoadDone(static_cast<int32_t>(tiles_done / double(map.tilecount) * 100.0));
-		}
-
-		Tile* tile = tileLocation->get();
-		ASSERT(tile);
+	const std::vector<Tile*> changed = transformMap(map, showdialog, [this](const Tile* tile) {
+		Tile* new_tile = tile->deepCopy(map);
+		new_tile->borderize(&map);
+		return new_tile;
+	});
 
-		tile->borderize(&map);
-		++tiles_done;
+	if (!changed.empty()) {
+		Action* action = actionQueue->createAction(ACTION_BORDERIZE);
+		for (Tile* new_tile : changed) {
+			action->addChange(newd Change(new_tile));
+		}
+		addAction(action);
 	}
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
+	updateActions();
 }
 
 void Editor::randomizeSelection() {
@@ -939,42 +1023,46 @@ void Editor::randomizeMap(bool showdialog) {
 		g_gui.CreateLoadBar("Randomizing map...");
 	}
 
-	uint64_t tiles_done = 0;
-	for (TileLocation* tileLocation : map) {
-		if (showdialog && tiles_done % 4096 == 0) {
-			g_gui.SetLoadDone(static_cast<int32_t>(tiles_done / double(map.tilecount) * 100.0));
-		}
-
-		Tile* tile = tileLocation->get();
-		ASSERT(tile);
-
+	// Each tile rolls from the run's seed and its position instead of the shared generator,
+	// so the jobs can run in any order and still produce the same map
+	const uint64_t seed = (static_cast<uint64_t>(random(0x7FFFFFFF)) << 31) | static_cast<uint64_t>(random(0x7FFFFFFF));
+	const std::vector<Tile*> changed = transformMap(map, showdialog, [this, seed](const Tile* tile) -> Tile* {
 		GroundBrush* groundBrush = tile->getGroundBrush();
-		if (groundBrush) {
-			Item* oldGround = tile->ground;
-
-			uint16_t actionId, uniqueId;
-			if (oldGround) {
-				actionId = oldGround->getActionID();
-				uniqueId = oldGround->getUniqueID();
-			} else {
-				actionId = 0;
-				uniqueId = 0;
-			}
-			groundBrush->draw(&map, tile, nullptr);
+		if (!groundBrush || groundBrush->getTotalChance() <= 0) {
+			return nullptr;
+		}
 
-			Item* newGround = tile->ground;
-			if (newGround) {
+		Tile* new_tile = tile->deepCopy(map);
+		const int chance = 1 + static_cast<int>(mixPosition(seed, tile->getPosition()) % static_cast<uint64_t>(groundBrush->getTotalChance()));
+		groundBrush->drawVariant(new_tile, chance);
+
+		// Only carried over when set, an explicit zero would make every tile look changed
+		Item* oldGround = tile->ground;
+		Item* newGround = new_tile->ground;
+		if (oldGround && newGround) {
+			if (const uint16_t actionId = oldGround->getActionID()) {
 				newGround->setActionID(actionId);
+			}
+			if (const uint16_t uniqueId = oldGround->getUniqueID()) {
 				newGround->setUniqueID(uniqueId);
 			}
-			tile->update();
 		}
-		++tiles_done;
+		new_tile->update();
+		return new_tile;
+	});
+
+	if (!changed.empty()) {
+		Action* action = actionQueue->createAction(ACTION_RANDOMIZE);
+		for (Tile* new_tile : changed) {
+			action->addChange(newd Change(new_tile));
+		}
+		addAction(action);
 	}
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
+	updateActions();
 }
 
 void Editor::clearInvalidHouseTiles(bool showdialog) {
@@ -1005,6 +1093,7 @@ void Editor::clearInvalidHouseTiles(bool showdialog) {
 		if (tile->isHouseTile()) {
 			if (houses.getHouse(tile->getHouseID()) == nullptr) {
 				tile->setHouse(nullptr);
+				map.markAreaDirty(tile->getPosition());
 			}
 		}
 		++tiles_done;
@@ -2072,6 +2161,11 @@ void Editor::QueryNode(int ndx, int ndy, bool underground) {
 	live_client->queryNode(ndx, ndy, underground);
 }
 
+void Editor::SetNodeViewport(int start_x, int start_y, int end_x, int end_y, bool underground) {
+	ASSERT(live_client);
+	live_client->updateViewport(start_x, start_y, end_x, end_y, underground);
+}
+
 void Editor::SendNodeRequests() {
 	if (live_client) {
 		live_client->sendNodeRequests();
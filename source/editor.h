@@ -69,6 +69,7 @@ public: // Functions
 
 	// Client side
 	void QueryNode(int ndx, int ndy, bool underground);
+	void SetNodeViewport(int start_x, int start_y, int end_x, int end_y, bool underground);
 	void SendNodeRequests();
 
 	bool hasChanges() const;
@@ -19,6 +19,15 @@
 
 #include "filehandle.h"
 
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 uint8_t NodeFileWriteHandle::NODE_START = ::NODE_START;
 uint8_t NodeFileWriteHandle::NODE_END = ::NODE_END;
 uint8_t NodeFileWriteHandle::ESCAPE_CHAR = ::ESCAPE_CHAR;
@@ -72,6 +81,77 @@ std::string FileHandle::getErrorMessage() {
 	return "No error";
 }
 
+//=============================================================================
+// Memory mapped file
+
+bool FileMapping::open(const std::string &name) {
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileW(string2wstring(name).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_handle = file;
+	mapping_handle = mapping;
+	data = static_cast<const uint8_t*>(view);
+	size = static_cast<size_t>(file_size.QuadPart);
+#else
+	int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	::close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	// Node trees are walked front to back
+	madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+	data = static_cast<const uint8_t*>(view);
+	size = static_cast<size_t>(info.st_size);
+#endif
+	return true;
+}
+
+void FileMapping::close() {
+	if (!data) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+	mapping_handle = nullptr;
+	file_handle = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(data), size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
 //=============================================================================
 // File read handle
 
@@ -142,6 +222,7 @@ bool FileReadHandle::getLongString(std::string &str) {
 
 NodeFileReadHandle::NodeFileReadHandle() :
 	last_was_start(false),
+	in_place(false),
 	cache(nullptr),
 	cache_size(32768),
 	cache_length(0),
@@ -175,10 +256,24 @@ void NodeFileReadHandle::freeNode(BinaryNode* node) {
 	}
 }
 
+bool NodeFileReadHandle::isAcceptedIdentifier(const char* identifier, const std::vector<std::string> &acceptable_identifiers) {
+	// 0x00 00 00 00 is accepted as a wildcard version
+	if (identifier[0] == 0 && identifier[1] == 0 && identifier[2] == 0 && identifier[3] == 0) {
+		return true;
+	}
+	for (const std::string &acceptable : acceptable_identifiers) {
+		if (memcmp(identifier, acceptable.c_str(), 4) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 //=============================================================================
 // Memory based node file read handle
 
 MemoryNodeFileReadHandle::MemoryNodeFileReadHandle(const uint8_t* data, size_t size) {
+	in_place = true;
 	assign(data, size);
 }
 
@@ -206,6 +301,12 @@ bool MemoryNodeFileReadHandle::renewCache() {
 BinaryNode* MemoryNodeFileReadHandle::getRootNode() {
 	assert(root_node == nullptr); // You should never do this twice
 
+	if (cache_length == 0) {
+		// Truncated, not even the first NODE_START is there
+		error_code = FILE_PREMATURE_END;
+		return nullptr;
+	}
+
 	local_read_index++; // Skip first NODE_START
 	last_was_start = true;
 	root_node = getNode(nullptr);
@@ -213,6 +314,32 @@ BinaryNode* MemoryNodeFileReadHandle::getRootNode() {
 	return root_node;
 }
 
+//=============================================================================
+// Memory mapped node file read handle
+
+MappedNodeFileReadHandle::MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers) :
+	MemoryNodeFileReadHandle(nullptr, 0) {
+	if (!mapping.open(name)) {
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+	if (mapping.getSize() < 4 || !isAcceptedIdentifier(reinterpret_cast<const char*>(mapping.getData()), acceptable_identifiers)) {
+		mapping.close();
+		error_code = FILE_SYNTAX_ERROR;
+		return;
+	}
+	assign(mapping.getData() + 4, mapping.getSize() - 4);
+}
+
+MappedNodeFileReadHandle::~MappedNodeFileReadHandle() {
+	close();
+}
+
+void MappedNodeFileReadHandle::close() {
+	MemoryNodeFileReadHandle::close();
+	mapping.close();
+}
+
 //=============================================================================
 // File based node file read handle
 
@@ -233,22 +360,10 @@ DiskNodeFileReadHandle::DiskNodeFileReadHandle(const std::string &name, const st
 			return;
 		}
 
-		// 0x00 00 00 00 is accepted as a wildcard version
-
-		if (ver[0] != 0 || ver[1] != 0 || ver[2] != 0 || ver[3] != 0) {
-			bool accepted = false;
-			for (std::vector<std::string>::const_iterator id_iter = acceptable_identifiers.begin(); id_iter != acceptable_identifiers.end(); ++id_iter) {
-				if (memcmp(ver, id_iter->c_str(), 4) == 0) {
-					accepted = true;
-					break;
-				}
-			}
-
-			if (!accepted) {
-				fclose(file);
-				error_code = FILE_SYNTAX_ERROR;
-				return;
-			}
+		if (!isAcceptedIdentifier(ver, acceptable_identifiers)) {
+			fclose(file);
+			error_code = FILE_SYNTAX_ERROR;
+			return;
 		}
 
 		fseek(file, 0, SEEK_END);
@@ -303,6 +418,8 @@ BinaryNode* DiskNodeFileReadHandle::getRootNode() {
 // Binary file node
 
 BinaryNode::BinaryNode(NodeFileReadHandle* file, BinaryNode* parent) :
+	data(nullptr),
+	data_size(0),
 	read_offset(0),
 	file(file),
 	parent(parent),
@@ -327,21 +444,21 @@ BinaryNode* BinaryNode::getChild() {
 }
 
 bool BinaryNode::getRAW(uint8_t* ptr, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > data_size) {
+		read_offset = data_size;
 		return false;
 	}
-	memcpy(ptr, data.data() + read_offset, sz);
+	memcpy(ptr, data + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
 
 bool BinaryNode::getRAW(std::string &str, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > data_size) {
+		read_offset = data_size;
 		return false;
 	}
-	str.assign(data.data() + read_offset, sz);
+	str.assign(reinterpret_cast<const char*>(data) + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
@@ -406,7 +523,6 @@ BinaryNode* BinaryNode::advance() {
 			// Another node follows this.
 			// Load this node as the next one
 			read_offset = 0;
-			data.clear();
 			load();
 			return this;
 		} else if (op == NODE_END) {
@@ -424,7 +540,47 @@ BinaryNode* BinaryNode::advance() {
 
 void BinaryNode::load() {
 	ASSERT(file);
+	if (file->in_place) {
+		if (file->local_read_index >= file->cache_length) {
+			// Cut short before the body, nothing to reference
+			data = nullptr;
+			data_size = 0;
+			file->error_code = FILE_PREMATURE_END;
+			return;
+		}
+
+		// Reference the body in place, unless it has to be unescaped
+		const uint8_t* begin = file->cache + file->local_read_index;
+		const uint8_t* end = file->cache + file->cache_length;
+		const uint8_t* it = begin;
+		while (it != end && *it != NODE_START && *it != NODE_END && *it != ESCAPE_CHAR) {
+			++it;
+		}
+
+		if (it == end) {
+			data = begin;
+			data_size = it - begin;
+			file->local_read_index = file->cache_length;
+			file->error_code = FILE_PREMATURE_END;
+			return;
+		}
+		if (*it != ESCAPE_CHAR) {
+			data = begin;
+			data_size = it - begin;
+			file->last_was_start = *it == NODE_START;
+			file->local_read_index += data_size + 1;
+			return;
+		}
+	}
+
+	loadEscaped();
+	data = reinterpret_cast<const uint8_t*>(unescaped.data());
+	data_size = unescaped.size();
+}
+
+void BinaryNode::loadEscaped() {
 	// Read until next node starts
+	unescaped.clear();
 	uint8_t*&cache = file->cache;
 	size_t &cache_length = file->cache_length;
 	size_t &local_read_index = file->local_read_index;
@@ -469,7 +625,7 @@ void BinaryNode::load() {
 				break;
 		}
 		// std::cout << "Appending..." << std::endl;
-		data.append(1, op);
+		unescaped.append(1, op);
 	}
 }
 
@@ -578,6 +734,7 @@ void DiskNodeFileWriteHandle::renewCache() {
 		if (ferror(file) != 0) {
 			error_code = FILE_WRITE_ERROR;
 		}
+		flushed += local_write_index;
 	} else {
 		cache = (uint8_t*)malloc(cache_size + 1);
 	}
@@ -634,7 +791,8 @@ void MemoryNodeFileWriteHandle::renewCache() {
 NodeFileWriteHandle::NodeFileWriteHandle() :
 	cache(nullptr),
 	cache_size(0x7FFF),
-	local_write_index(0) {
+	local_write_index(0),
+	flushed(0) {
 	////
 }
 
@@ -715,3 +873,17 @@ bool NodeFileWriteHandle::addRAW(const uint8_t* ptr, size_t sz) {
 	writeBytes(ptr, sz);
 	return error_code == FILE_NO_ERROR;
 }
+
+bool NodeFileWriteHandle::addEncoded(const uint8_t* ptr, size_t sz) {
+	while (sz != 0) {
+		const size_t chunk = std::min(sz, cache_size - local_write_index);
+		memcpy(cache + local_write_index, ptr, chunk);
+		local_write_index += chunk;
+		if (local_write_index >= cache_size) {
+			renewCache();
+		}
+		ptr += chunk;
+		sz -= chunk;
+	}
+	return error_code == FILE_NO_ERROR;
+}
@@ -78,6 +78,39 @@ public:
 	FILE* file;
 };
 
+// Read-only view of a complete file mapped into memory
+class FileMapping {
+public:
+	FileMapping() = default;
+	~FileMapping() {
+		close();
+	}
+
+	FileMapping(const FileMapping &) = delete;
+	FileMapping &operator=(const FileMapping &) = delete;
+
+	bool open(const std::string &name);
+	void close();
+
+	bool isOpen() const noexcept {
+		return data != nullptr;
+	}
+	const uint8_t* getData() const noexcept {
+		return data;
+	}
+	size_t getSize() const noexcept {
+		return size;
+	}
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
 class FileReadHandle : public FileHandle {
 public:
 	explicit FileReadHandle(const std::string &name);
@@ -146,8 +179,8 @@ public:
 		return getType(u64);
 	}
 	FORCEINLINE bool skip(size_t sz) {
-		if (read_offset + sz > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sz > data_size) {
+			read_offset = data_size;
 			return false;
 		}
 		read_offset += sz;
@@ -165,18 +198,23 @@ public:
 protected:
 	template <class T>
 	bool getType(T &ref) {
-		if (read_offset + sizeof(ref) > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sizeof(ref) > data_size) {
+			read_offset = data_size;
 			return false;
 		}
-		ref = *(T*)(data.data() + read_offset);
+		memcpy(&ref, data + read_offset, sizeof(ref));
 
 		read_offset += sizeof(ref);
 		return true;
 	}
 
 	void load();
-	std::string data;
+	void loadEscaped();
+	// Points into the handle's buffer when it holds the whole tree, else into unescaped
+	const uint8_t* data;
+	size_t data_size;
+	// Only filled when the body can't be used in place (escaped bytes or a streamed file)
+	std::string unescaped;
 	size_t read_offset;
 	NodeFileReadHandle* file;
 	BinaryNode* parent;
@@ -203,6 +241,8 @@ protected:
 	virtual bool renewCache() = 0;
 
 	bool last_was_start;
+	// True when cache holds the complete node tree, so nodes can reference it without copying
+	bool in_place;
 	uint8_t* cache;
 	size_t cache_size;
 	size_t cache_length;
@@ -212,6 +252,8 @@ protected:
 
 	std::stack<void*> unused;
 
+	static bool isAcceptedIdentifier(const char* identifier, const std::vector<std::string> &acceptable_identifiers);
+
 	friend class BinaryNode;
 };
 
@@ -266,6 +308,32 @@ protected:
 	uint8_t* index;
 };
 
+class MappedNodeFileReadHandle : public MemoryNodeFileReadHandle {
+public:
+	// Maps the whole file read-only and walks the node tree straight from the page cache
+	MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers);
+	virtual ~MappedNodeFileReadHandle();
+
+	virtual void close();
+	virtual bool isOpen() {
+		return mapping.isOpen();
+	}
+	virtual bool isOk() {
+		return mapping.isOpen() && error_code == FILE_NO_ERROR;
+	}
+
+	// The node tree without the file identifier, for loaders that split it up themselves
+	const uint8_t* getNodeData() const noexcept {
+		return cache;
+	}
+	size_t getNodeSize() const noexcept {
+		return cache_length;
+	}
+
+protected:
+	FileMapping mapping;
+};
+
 class FileWriteHandle : public FileHandle {
 public:
 	explicit FileWriteHandle(const std::string &name);
@@ -324,6 +392,13 @@ public:
 	bool addRAW(const char* c) {
 		return addRAW(reinterpret_cast<const uint8_t*>(c), strlen(c));
 	}
+	// Appends bytes that are already node encoded (escaped), such as a node copied from another file
+	bool addEncoded(const uint8_t* ptr, size_t sz);
+
+	// Bytes written so far, not counting the file identifier
+	uint64_t getWriteOffset() const noexcept {
+		return flushed + local_write_index;
+	}
 
 protected:
 	virtual void renewCache() = 0;
@@ -335,6 +410,8 @@ protected:
 	uint8_t* cache;
 	size_t cache_size;
 	size_t local_write_index;
+	// Bytes already moved out of the cache by renewCache
+	uint64_t flushed;
 
 	FORCEINLINE void writeBytes(const uint8_t* ptr, size_t sz) {
 		if (sz) {
@@ -226,6 +226,7 @@ void GraphicManager::clear() {
 	sprite_space.swap(new_sprite_space);
 	image_space.clear();
 	cleanup_list.clear();
+	clearAtlas();
 
 	item_count = 0;
 	creature_count = 0;
@@ -976,6 +977,30 @@ void GraphicManager::addSpriteToCleanup(GameSprite* spr) {
 }
 
 void GraphicManager::garbageCollection() {
+	// Pages above the limit that weren't needed by the last frame can go now
+	const size_t max_pages = std::max(1, g_settings.getInteger(Config::TEXTURE_ATLAS_PAGES));
+	while (atlas_resident_pages > max_pages) {
+		AtlasPage* lru = nullptr;
+		for (AtlasPage &page : atlas_pages) {
+			if (page.texture != 0 && page.last_used != atlas_frame && (!lru || page.last_used < lru->last_used)) {
+				lru = &page;
+			}
+		}
+		if (!lru) {
+			break;
+		}
+		glDeleteTextures(1, &lru->texture);
+		*lru = AtlasPage();
+		lru->generation = ++atlas_generation;
+		++texture_generation;
+		--atlas_resident_pages;
+		++atlas_evictions;
+	}
+
+	atlas_upload_bytes_last_frame = atlas_upload_bytes;
+	atlas_upload_bytes = 0;
+	++atlas_frame;
+
 	if (g_settings.getInteger(Config::TEXTURE_MANAGEMENT)) {
 		int t = time(nullptr);
 		if (loaded_textures > g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD) && t - lastclean > g_settings.getInteger(Config::TEXTURE_CLEAN_PULSE)) {
@@ -989,6 +1014,156 @@ void GraphicManager::garbageCollection() {
 	}
 }
 
+int GraphicManager::getAtlasPage(int cell_width, int cell_height) {
+	const uint32_t capacity = (AtlasPageSize / cell_width) * (AtlasPageSize / cell_height);
+	for (size_t i = 0; i < atlas_pages.size(); ++i) {
+		const AtlasPage &page = atlas_pages[i];
+		if (page.texture != 0 && page.cell_width == cell_width && page.cell_height == cell_height && page.used < capacity) {
+			return static_cast<int>(i);
+		}
+	}
+
+	int index = -1;
+	const size_t max_pages = std::max(1, g_settings.getInteger(Config::TEXTURE_ATLAS_PAGES));
+	if (atlas_resident_pages >= max_pages) {
+		// Recycle the least recently used page, unless the current frame still draws from it
+		for (size_t i = 0; i < atlas_pages.size(); ++i) {
+			const AtlasPage &page = atlas_pages[i];
+			if (page.texture != 0 && page.last_used != atlas_frame && (index == -1 || page.last_used < atlas_pages[index].last_used)) {
+				index = static_cast<int>(i);
+			}
+		}
+		if (index != -1) {
+			++atlas_evictions;
+			++texture_generation;
+		}
+	}
+
+	if (index == -1) {
+		// Below the limit, or every page is in use by this frame and the limit is exceeded until the next collection
+		for (size_t i = 0; i < atlas_pages.size(); ++i) {
+			if (atlas_pages[i].texture == 0) {
+				index = static_cast<int>(i);
+				break;
+			}
+		}
+		if (index == -1) {
+			index = static_cast<int>(atlas_pages.size());
+			atlas_pages.emplace_back();
+		}
+
+		AtlasPage &page = atlas_pages[index];
+		page.texture = getFreeTextureID();
+		glBindTexture(GL_TEXTURE_2D, page.texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); // GL_CLAMP_TO_EDGE
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F); // GL_CLAMP_TO_EDGE
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, AtlasPageSize, AtlasPageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		++atlas_resident_pages;
+	}
+
+	AtlasPage &page = atlas_pages[index];
+	page.cell_width = cell_width;
+	page.cell_height = cell_height;
+	page.used = 0;
+	page.generation = ++atlas_generation;
+	return index;
+}
+
+void GraphicManager::fillAtlasRegion(const AtlasPage &page, uint32_t slot, AtlasRegion &region) const {
+	const uint32_t columns = AtlasPageSize / page.cell_width;
+	const int x = (slot % columns) * page.cell_width;
+	const int y = (slot / columns) * page.cell_height;
+
+	region.texture = page.texture;
+	region.width = page.cell_width;
+	region.height = page.cell_height;
+	region.u0 = static_cast<float>(x) / AtlasPageSize;
+	region.v0 = static_cast<float>(y) / AtlasPageSize;
+	region.u1 = static_cast<float>(x + page.cell_width) / AtlasPageSize;
+	region.v1 = static_cast<float>(y + page.cell_height) / AtlasPageSize;
+}
+
+bool GraphicManager::fetchAtlasRegion(GameSprite::NormalImage &image, AtlasRegion &region) {
+	if (image.atlas_page >= 0 && static_cast<size_t>(image.atlas_page) < atlas_pages.size()) {
+		AtlasPage &page = atlas_pages[image.atlas_page];
+		if (page.texture != 0 && page.generation == image.atlas_generation) {
+			page.last_used = atlas_frame;
+			fillAtlasRegion(page, image.atlas_slot, region);
+			return true;
+		}
+	}
+
+	// Don't stall the frame on a sheet that still has to be decompressed
+	if (!image.m_cachedData && !g_spriteAppearances.requestSpriteSheet(image.id, SheetPriority::Visible)) {
+		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(image.id, false);
+		region = AtlasRegion();
+		region.width = sheet ? sheet->getSpriteSize().width : rme::SpritePixels;
+		region.height = sheet ? sheet->getSpriteSize().height : rme::SpritePixels;
+		return true;
+	}
+
+	uint8_t* rgba = image.getRGBAData();
+	if (!rgba) {
+		return false;
+	}
+
+	const auto &sheet = g_spriteAppearances.getSheetBySpriteId(image.id);
+	if (!sheet) {
+		return false;
+	}
+
+	const int width = sheet->getSpriteSize().width;
+	const int height = sheet->getSpriteSize().height;
+	const int index = getAtlasPage(width, height);
+	AtlasPage &page = atlas_pages[index];
+	const uint32_t slot = page.used++;
+	page.last_used = atlas_frame;
+	fillAtlasRegion(page, slot, region);
+
+	// Sprite sheets are stored as BGRA
+	const size_t pixels = static_cast<size_t>(width) * height;
+	atlas_upload_buffer.resize(pixels * 4);
+	for (size_t i = 0; i < pixels; ++i) {
+		atlas_upload_buffer[i * 4 + 0] = rgba[i * 4 + 2];
+		atlas_upload_buffer[i * 4 + 1] = rgba[i * 4 + 1];
+		atlas_upload_buffer[i * 4 + 2] = rgba[i * 4 + 0];
+		atlas_upload_buffer[i * 4 + 3] = rgba[i * 4 + 3];
+	}
+
+	const uint32_t columns = AtlasPageSize / width;
+	glBindTexture(GL_TEXTURE_2D, page.texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % columns) * width, (slot / columns) * height, width, height, GL_RGBA, GL_UNSIGNED_BYTE, atlas_upload_buffer.data());
+	atlas_upload_bytes += pixels * 4;
+
+	image.atlas_page = index;
+	image.atlas_slot = slot;
+	image.atlas_generation = page.generation;
+	return true;
+}
+
+void GraphicManager::clearAtlas() {
+	for (AtlasPage &page : atlas_pages) {
+		if (page.texture != 0) {
+			glDeleteTextures(1, &page.texture);
+		}
+	}
+	atlas_pages.clear();
+	atlas_resident_pages = 0;
+	++texture_generation;
+}
+
+void GraphicManager::touchTexture(GLuint texture) {
+	for (AtlasPage &page : atlas_pages) {
+		if (page.texture == texture) {
+			page.last_used = atlas_frame;
+			return;
+		}
+	}
+}
+
 EditorSprite::EditorSprite(wxBitmap* b16x16, wxBitmap* b32x32) {
 	for(int i = 0; i < SPRITE_SIZE_COUNT; ++i) {
 		bm[i] = nullptr;
@@ -1049,7 +1224,8 @@ uint16_t GameSprite::getDrawHeight() const {
 
 wxPoint GameSprite::getDrawOffset() {
 	if (!isDrawOffsetLoaded && !spriteList.empty()) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID());
+		// Only the size is needed, the sheet doesn't have to be decoded for that
+		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id, false);
 		if (!sheet) {
 			return wxPoint(0, 0);
 		}
@@ -1064,7 +1240,7 @@ wxPoint GameSprite::getDrawOffset() {
 
 uint8_t GameSprite::getWidth() {
 	if (width <= 0) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID(), false);
+		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id, false);
 		if (sheet) {
 			width = sheet->getSpriteSize().width;
 			height = sheet->getSpriteSize().height;
@@ -1076,7 +1252,7 @@ uint8_t GameSprite::getWidth() {
 
 uint8_t GameSprite::getHeight() {
 	if (height <= 0) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->getHardwareID(), false);
+		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id, false);
 		if (sheet) {
 			width = sheet->getSpriteSize().width;
 			height = sheet->getSpriteSize().height;
@@ -1104,6 +1280,14 @@ int GameSprite::getIndex(int width, int height, int layer, int pattern_x, int pa
 }
 
 GLuint GameSprite::getHardwareID(int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) {
+	return getImage(_layer, _count, _pattern_x, _pattern_y, _pattern_z, _frame)->getHardwareID();
+}
+
+bool GameSprite::getAtlasRegion(int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame, AtlasRegion &region) {
+	return getImage(_layer, _count, _pattern_x, _pattern_y, _pattern_z, _frame)->getAtlasRegion(region);
+}
+
+GameSprite::NormalImage* GameSprite::getImage(int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) {
 	uint32_t v;
 	if (_count >= 0) {
 		v = _count;
@@ -1117,7 +1301,7 @@ GLuint GameSprite::getHardwareID(int _layer, int _count, int _pattern_x, int _pa
 			v %= numsprites;
 		}
 	}
-	return spriteList[v]->getHardwareID();
+	return spriteList[v];
 }
 
 std::shared_ptr<GameSprite::OutfitImage> GameSprite::getOutfitImage(int spriteId, Direction direction, const Outfit &outfit) {
@@ -1271,6 +1455,7 @@ void GameSprite::Image::createGLTexture(GLuint textureId) {
 void GameSprite::Image::unloadGLTexture(GLuint textureId) {
 	isGLLoaded = false;
 	g_gui.gfx.loaded_textures -= 1;
+	++g_gui.gfx.texture_generation;
 	glDeleteTextures(1, &textureId);
 }
 
@@ -1322,6 +1507,11 @@ GLuint GameSprite::NormalImage::getHardwareID() {
 	return id;
 }
 
+bool GameSprite::NormalImage::getAtlasRegion(AtlasRegion &region) {
+	visit();
+	return g_gui.gfx.fetchAtlasRegion(*this, region);
+}
+
 void GameSprite::NormalImage::createGLTexture(GLuint) {
 	Image::createGLTexture(id);
 }
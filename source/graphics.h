@@ -56,6 +56,16 @@ class GraphicManager;
 class FileReadHandle;
 class Animator;
 
+// Where a sprite image lives inside a texture atlas page.
+// A texture of 0 means the sprite sheet is still being decoded and only the size is known.
+struct AtlasRegion {
+	GLuint texture = 0;
+	float u0 = 0.f, v0 = 0.f;
+	float u1 = 1.f, v1 = 1.f;
+	int width = 0;
+	int height = 0;
+};
+
 struct SpriteLight {
 	uint8_t intensity = 0;
 	uint8_t color = 0;
@@ -92,6 +102,8 @@ public:
 
 	int getIndex(int width, int height, int layer, int pattern_x, int pattern_y, int pattern_z, int frame) const;
 	GLuint getHardwareID(int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame);
+	// Same lookup as getHardwareID, but the image is packed into an atlas page instead of its own texture
+	bool getAtlasRegion(int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame, AtlasRegion &region);
 	virtual void DrawTo(wxDC* dc, SpriteSize sz, int start_x, int start_y, int width = -1, int height = -1);
 
 	virtual void unloadDC();
@@ -118,6 +130,7 @@ protected:
 	class OutfitImage;
 
 	wxMemoryDC* getDC(SpriteSize spriteSize);
+	NormalImage* getImage(int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame);
 
 	class Image {
 	public:
@@ -155,7 +168,13 @@ protected:
 
 		virtual void clean(int time);
 
+		// Atlas placement, only valid while the page generation matches
+		int atlas_page = -1;
+		uint32_t atlas_slot = 0;
+		uint32_t atlas_generation = 0;
+
 		virtual GLuint getHardwareID();
+		bool getAtlasRegion(AtlasRegion &region);
 #if CLIENT_VERSION < 1100
 		virtual uint8_t* getRGBData() = 0;
 #endif
@@ -337,8 +356,25 @@ public:
 	bool loadItemSpriteMetadata(const std::shared_ptr<ItemType> &t, wxString &error, wxArrayString &warnings);
 	bool loadOutfitSpriteMetadata(canary::protobuf::appearances::Appearance outfit, wxString &error, wxArrayString &warnings);
 
-	// Cleans old & unused textures according to config settings
+	// Cleans old & unused textures according to config settings, called once per drawn frame
 	void garbageCollection();
+
+	// Texture atlas counters
+	size_t getAtlasPageCount() const noexcept {
+		return atlas_resident_pages;
+	}
+	uint64_t getAtlasEvictions() const noexcept {
+		return atlas_evictions;
+	}
+	uint64_t getAtlasUploadBytesLastFrame() const noexcept {
+		return atlas_upload_bytes_last_frame;
+	}
+	// Bumped whenever a texture or atlas slot handed out before may have been deleted or reused
+	uint32_t getTextureGeneration() const noexcept {
+		return texture_generation;
+	}
+	// Keeps the atlas page behind a texture resident for the current frame, for quads drawn without fetching their region
+	void touchTexture(GLuint texture);
 	void addSpriteToCleanup(GameSprite* spr);
 
 	wxFileName getMetadataFileName() const {
@@ -354,6 +390,32 @@ private:
 	std::string spritefile;
 	bool loadSpriteDump(uint8_t*&target, uint16_t &size, int sprite_id);
 
+	// Sprites of one size packed into a single texture, evicted as a whole
+	struct AtlasPage {
+		GLuint texture = 0;
+		int cell_width = 0;
+		int cell_height = 0;
+		uint32_t used = 0;
+		uint32_t generation = 0;
+		uint64_t last_used = 0; // Frame number
+	};
+	static constexpr int AtlasPageSize = 1024;
+
+	bool fetchAtlasRegion(GameSprite::NormalImage &image, AtlasRegion &region);
+	int getAtlasPage(int cell_width, int cell_height);
+	void fillAtlasRegion(const AtlasPage &page, uint32_t slot, AtlasRegion &region) const;
+	void clearAtlas();
+
+	std::vector<AtlasPage> atlas_pages;
+	std::vector<uint8_t> atlas_upload_buffer;
+	size_t atlas_resident_pages = 0;
+	uint32_t atlas_generation = 0;
+	uint32_t texture_generation = 0;
+	uint64_t atlas_frame = 1;
+	uint64_t atlas_evictions = 0;
+	uint64_t atlas_upload_bytes = 0;
+	uint64_t atlas_upload_bytes_last_frame = 0;
+
 	typedef std::map<int, Sprite*> SpriteMap;
 	SpriteMap sprite_space;
 	typedef std::map<int, GameSprite::Image*> ImageMap;
@@ -546,7 +546,15 @@ void GroundBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 			return;
 		}
 	}
-	int chance = random(1, total_chance);
+	drawVariant(tile, random(1, total_chance));
+}
+
+void GroundBrush::drawVariant(Tile* tile, int chance) const {
+	ASSERT(tile);
+	if (border_items.empty()) {
+		return;
+	}
+
 	uint16_t id = 0;
 	for (std::vector<ItemChanceBlock>::const_iterator it = border_items.begin(); it != border_items.end(); ++it) {
 		if (chance < it->chance) {
@@ -695,7 +703,8 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 		neighbours[7] = { false, extractGroundBrushFromTile(map, x + 1, y + 1, z) };
 	}
 
-	static std::vector<const BorderBlock*> specificList;
+	// Borderizing the whole map runs this on several threads at once
+	static thread_local std::vector<const BorderBlock*> specificList;
 	specificList.clear();
 
 	std::vector<BorderCluster> borderList;
@@ -42,6 +42,8 @@ public:
 	virtual bool load(pugi::xml_node node, wxArrayString &warnings);
 
 	virtual void draw(BaseMap* map, Tile* tile, void* parameter);
+	// Places the ground variant picked by chance, in [1, getTotalChance()], draw() rolls it itself
+	void drawVariant(Tile* tile, int chance) const;
 	virtual void undraw(BaseMap* map, Tile* tile);
 	static void doBorders(BaseMap* map, Tile* tile);
 	static const BorderBlock* getBrushTo(GroundBrush* first, GroundBrush* second);
@@ -55,6 +57,9 @@ public:
 	bool isReRandomizable() const {
 		return randomize;
 	}
+	int getTotalChance() const {
+		return total_chance;
+	}
 
 	bool hasOuterZilchBorder() const {
 		return has_zilch_outer_border || optional_border;
@@ -45,6 +45,8 @@
 #include "spawn_npc_brush.h"
 #include "actions_history_window.h"
 #include "sprite_appearances.h"
+#include "startup_loader.h"
+#include "datapack_cache.h"
 #include "preferences.h"
 
 #include "live_client.h"
@@ -302,71 +304,167 @@ bool GUI::LoadDataFiles(wxString &error, wxArrayString &warnings) {
 	g_gui.SetLoadDone(0, "Loading assets file");
 	spdlog::info("Loading assets");
 
-	g_gui.SetLoadDone(20, "Loading client assets...");
-	spdlog::info("Loading appearances");
-	if (!ClientAssets::loadAppearanceProtobuf(error, warnings)) {
-
-		InternalGUI::logErrorAndSetMessage("Couldn't load catalog-content.json", error);
+	// Paths are resolved here, the stages run on worker threads
+	const wxString materials_path = data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "materials/materials.xml";
+	FileName user_monsters_path = ClientAssets::getLocalPath();
+	user_monsters_path.AppendDir("materials");
+	user_monsters_path.SetFullName("monsters.xml");
+	FileName user_npcs_path = user_monsters_path;
+	user_npcs_path.SetFullName("npcs.xml");
+
+	const auto loadFailed = [](wxArrayString &warnings, const wxString &name, const wxString &path, const wxString &error) {
+		warnings.push_back("Couldn't load " + name + ": " + error);
+		spdlog::warn("[GUI::LoadDataFiles] {}: {}", path.ToStdString(), error.ToStdString());
 		return false;
-	}
+	};
 
-	g_gui.SetLoadDone(30, "Loading items.xml ...");
-	spdlog::info("Loading items");
-	if (!g_items.loadFromGameXml(wxString("data/items/items.xml"), error, warnings)) {
-		warnings.push_back("Couldn't load items.xml: " + error);
-		spdlog::warn("[GUI::LoadDataFiles] {}: {}", wxString("data/items/items.xml").ToStdString(), error.ToStdString());
-	}
+	// The xml files are parsed while the client assets load, the databases are filled once the sprites they check exist
+	struct DataFile {
+		wxString name;
+		wxString path;
+		wxString read_error;
+		pugi::xml_document doc;
+		bool read = false;
+		bool from_cache = false;
+	};
+	DataFile items_xml { "items.xml", "data/items/items.xml", "Could not load items.xml (Syntax error?)" };
+	DataFile monsters_xml { "monsters.xml", "data/creatures/monsters.xml", "Couldn't open file \"monsters.xml\", invalid format?" };
+	DataFile npcs_xml { "npcs.xml", "data/creatures/npcs.xml", "Couldn't open file \"npcs.xml\", invalid format?" };
+
+	// Snapshot of the three databases, only rewritten when every file loaded cleanly
+	const bool use_cache = g_settings.getBoolean(Config::DATAPACK_CACHE);
+	FileName cache_path = ClientAssets::getLocalPath();
+	cache_path.SetFullName("datapack.bin");
+	const std::vector<std::string> cache_sources = {
+		nstr(items_xml.path),
+		nstr(monsters_xml.path),
+		nstr(user_monsters_path.GetFullPath()),
+		nstr(npcs_xml.path),
+		nstr(user_npcs_path.GetFullPath()),
+		nstr(ClientAssets::getPath()) + "/assets/catalog-content.json",
+	};
+	DatapackCache cache;
+	bool cached = false;
+	std::atomic<bool> cacheable { use_cache };
+	wxArrayString item_warnings;
+	wxArrayString monster_warnings;
+	wxArrayString npc_warnings;
+
+	const auto readFile = [&](DataFile &file, wxArrayString &warnings) {
+		file.read = file.doc.load_file(file.path.mb_str());
+		return file.read || loadFailed(warnings, file.name, file.path, file.read_error);
+	};
+	const auto loadFile = [&](DataFile &file, wxString &error, wxArrayString &warnings, bool (DatapackCache::*applyCache)(wxArrayString &) const, const std::function<bool(const pugi::xml_document &, wxString &, wxArrayString &)> &load) {
+		if (cached) {
+			if ((cache.*applyCache)(warnings)) {
+				file.from_cache = true;
+				return true;
+			}
+			// The snapshot doesn't fit the loaded assets, so the document was never read
+			readFile(file, warnings);
+		}
+		if (!file.read) {
+			cacheable = false;
+			return false;
+		}
+		if (!load(file.doc, error, warnings)) {
+			cacheable = false;
+			return loadFailed(warnings, file.name, file.path, error);
+		}
+		return true;
+	};
 
-	g_gui.SetLoadDone(45, "Loading monsters.xml ...");
-	spdlog::info("Loading monsters");
-	if (!g_monsters.loadFromXML(wxString("data/creatures/monsters.xml"), true, error, warnings)) {
-		warnings.push_back("Couldn't load monsters.xml: " + error);
-		spdlog::warn("[GUI::LoadDataFiles] {}: {}", wxString("data/creatures/monsters.xml").ToStdString(), error.ToStdString());
-	}
+	StartupLoader loader;
+	const size_t appearances = loader.addStage("client assets", {}, [](wxString &error, wxArrayString &warnings) {
+		return ClientAssets::loadAppearanceProtobuf(error, warnings);
+	}, StartupLoader::STAGE_REQUIRED);
 
-	g_gui.SetLoadDone(45, "Loading user monsters.xml ...");
-	spdlog::info("Loading user monsters");
-	{
-		FileName cdb = ClientAssets::getLocalPath();
-		cdb.AppendDir("materials");
-		cdb.SetFullName("monsters.xml");
-		wxString nerr;
-		wxArrayString nwarn;
-		g_monsters.loadFromXML(cdb, false, nerr, nwarn);
-	}
+	const size_t cache_file = loader.addStage("read datapack cache", {}, [&](wxString &error, wxArrayString &warnings) {
+		cached = use_cache && cache.open(nstr(cache_path.GetFullPath()), cache_sources);
+		return true;
+	});
+	const size_t items_file = loader.addStage("read items.xml", { cache_file }, [&](wxString &error, wxArrayString &warnings) {
+		return cached || readFile(items_xml, warnings);
+	});
+	const size_t monsters_file = loader.addStage("read monsters.xml", { cache_file }, [&](wxString &error, wxArrayString &warnings) {
+		return cached || readFile(monsters_xml, warnings);
+	});
+	const size_t npcs_file = loader.addStage("read npcs.xml", { cache_file }, [&](wxString &error, wxArrayString &warnings) {
+		return cached || readFile(npcs_xml, warnings);
+	});
+	const size_t materials_files = loader.addStage("read materials", {}, [&](wxString &error, wxArrayString &warnings) {
+		g_materials.prefetchMaterials(materials_path);
+		return true;
+	});
 
-	g_gui.SetLoadDone(45, "Loading npcs.xml ...");
-	spdlog::info("Loading npcs");
-	if (!g_npcs.loadFromXML(wxString("data/creatures/npcs.xml"), true, error, warnings)) {
-		warnings.push_back("Couldn't load npcs.xml: " + error);
-		spdlog::warn("[GUI::LoadDataFiles] {}: {}", wxString("data/creatures/npcs.xml").ToStdString(), error.ToStdString());
-	}
+	const size_t items = loader.addStage("items", { appearances, items_file }, [&](wxString &error, wxArrayString &warnings) {
+		const bool loaded = loadFile(items_xml, error, warnings, &DatapackCache::applyItems, [](const pugi::xml_document &doc, wxString &error, wxArrayString &warnings) {
+			return g_items.loadFromGameXml(doc, error, warnings);
+		});
+		item_warnings = warnings;
+		return loaded;
+	});
+	const size_t monsters = loader.addStage("monsters", { appearances, monsters_file }, [&](wxString &error, wxArrayString &warnings) {
+		const bool loaded = loadFile(monsters_xml, error, warnings, &DatapackCache::applyMonsters, [](const pugi::xml_document &doc, wxString &error, wxArrayString &warnings) {
+			return g_monsters.loadFromXML(doc, true, error, warnings);
+		});
+		monster_warnings = warnings;
+		return loaded;
+	});
+	const size_t user_monsters = loader.addStage("user monsters", { monsters }, [&](wxString &error, wxArrayString &warnings) {
+		// The snapshot holds them already. Only exists once monsters were added by hand, so errors are not worth a warning
+		if (!monsters_xml.from_cache) {
+			wxArrayString user_warnings;
+			g_monsters.loadFromXML(user_monsters_path, false, error, user_warnings);
+		}
+		return true;
+	});
+	const size_t npcs = loader.addStage("npcs", { appearances, npcs_file }, [&](wxString &error, wxArrayString &warnings) {
+		const bool loaded = loadFile(npcs_xml, error, warnings, &DatapackCache::applyNpcs, [](const pugi::xml_document &doc, wxString &error, wxArrayString &warnings) {
+			return g_npcs.loadFromXML(doc, true, error, warnings);
+		});
+		npc_warnings = warnings;
+		return loaded;
+	});
+	const size_t user_npcs = loader.addStage("user npcs", { npcs }, [&](wxString &error, wxArrayString &warnings) {
+		if (!npcs_xml.from_cache) {
+			g_npcs.loadFromXML(user_npcs_path, false, error, warnings);
+			for (const wxString &warning : warnings) {
+				npc_warnings.push_back(warning);
+			}
+		}
+		return true;
+	});
 
-	g_gui.SetLoadDone(45, "Loading user npcs.xml ...");
-	spdlog::info("Loading user npcs");
-	{
-		FileName cdb = ClientAssets::getLocalPath();
-		cdb.AppendDir("materials");
-		cdb.SetFullName("npcs.xml");
-		wxString nerr;
-		wxArrayString nwarn;
-		g_npcs.loadFromXML(cdb, false, nerr, warnings);
-	}
+	// Has to be done before the materials link brushes to the types
+	const size_t cache_write = loader.addStage("write datapack cache", { items, user_monsters, user_npcs }, [&](wxString &error, wxArrayString &warnings) {
+		if (cacheable && !(items_xml.from_cache && monsters_xml.from_cache && npcs_xml.from_cache)) {
+			cache.store(item_warnings, monster_warnings, npc_warnings);
+		}
+		return true;
+	});
 
-	g_gui.SetLoadDone(50, "Loading materials.xml ...");
-	spdlog::info("Loading materials");
-	auto materialsPath = wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "materials/materials.xml");
-	if (!g_materials.loadMaterials(materialsPath, error, warnings)) {
-		warnings.push_back("Couldn't load materials.xml: " + error);
-		spdlog::warn("[GUI::LoadDataFiles] {}: {}", materialsPath.ToStdString(), error.ToStdString());
-	}
+	// Materials create brushes for the item, monster and npc types, which links everything together
+	const size_t materials = loader.addStage("materials", { items, user_monsters, user_npcs, cache_write, materials_files }, [&](wxString &error, wxArrayString &warnings) {
+		return g_materials.loadMaterials(materials_path, error, warnings) || loadFailed(warnings, "materials.xml", materials_path, error);
+	}, StartupLoader::STAGE_MAIN_THREAD);
+	loader.addStage("brushes", { materials }, [](wxString &error, wxArrayString &warnings) {
+		g_brushes.init();
+		g_materials.createOtherTileset();
+		g_materials.createNpcTileset();
+		return true;
+	}, StartupLoader::STAGE_MAIN_THREAD);
 
-	g_gui.SetLoadDone(70, "Finishing...");
-	spdlog::info("Finishing load map...");
+	const bool loaded = loader.run(error, warnings, [](size_t finished, size_t total, const std::string &name) {
+		g_gui.SetLoadDone(static_cast<int32_t>(10 + 85 * finished / total), wxString::Format("Loaded %s...", name));
+	});
+	if (!loaded) {
+		InternalGUI::logErrorAndSetMessage("Couldn't load catalog-content.json", error);
+		return false;
+	}
 
-	g_brushes.init();
-	g_materials.createOtherTileset();
-	g_materials.createNpcTileset();
+	// Brushes are done tagging item types, nothing changes them from here on
+	g_items.freeze();
 
 	g_gui.DestroyLoadBar();
 	spdlog::info("Assets loaded");
@@ -94,12 +94,14 @@ void House::clean() {
 		Tile* tile = map->getTile(*pos_iter);
 		if (tile) {
 			tile->setHouse(nullptr);
+			map->markAreaDirty(*pos_iter);
 		}
 	}
 
 	Tile* tile = map->getTile(exit);
 	if (tile) {
 		tile->removeHouseExit(this);
+		map->markAreaDirty(exit);
 	}
 }
 
@@ -119,6 +121,7 @@ void House::addTile(Tile* tile) {
 	ASSERT(tile);
 	tile->setHouse(this);
 	tiles.push_back(tile->getPosition());
+	map->markAreaDirty(tile->getPosition());
 }
 
 void House::removeTile(Tile* tile) {
@@ -127,6 +130,7 @@ void House::removeTile(Tile* tile) {
 		if (*tile_iter == tile->getPosition()) {
 			tiles.erase(tile_iter);
 			tile->setHouse(nullptr);
+			map->markAreaDirty(tile->getPosition());
 			return;
 		}
 	}
@@ -186,6 +190,7 @@ void House::setExit(Map* targetmap, const Position &pos) {
 		Tile* oldexit = targetmap->getTile(exit);
 		if (oldexit) {
 			oldexit->removeHouseExit(this);
+			targetmap->markAreaDirty(exit);
 		}
 	}
 
@@ -196,6 +201,7 @@ void House::setExit(Map* targetmap, const Position &pos) {
 	}
 
 	newexit->addHouseExit(this);
+	targetmap->markAreaDirty(pos);
 	exit = pos;
 }
 
@@ -32,6 +32,8 @@
 #include "complexitem.h"
 #include "town.h"
 
+#include <filesystem>
+
 typedef uint8_t attribute_t;
 typedef uint32_t flags_t;
 
@@ -433,8 +435,8 @@ bool IOMapOTBM::getVersionInfo(const FileName &filename, MapVersion &out_ver) {
 	}
 #endif
 
-	// Just open a disk-based read handle
-	DiskNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+	// Only the root node is read, the rest of the mapping is never paged in
+	MappedNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
 	if (!f.isOk()) {
 		return false;
 	}
@@ -443,7 +445,8 @@ bool IOMapOTBM::getVersionInfo(const FileName &filename, MapVersion &out_ver) {
 
 bool IOMapOTBM::getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver) {
 	BinaryNode* root = f->getRootNode();
-	if (!root) {
+	if (!root || !f->isOk()) {
+		// Truncated files end inside the root node
 		return false;
 	}
 
@@ -514,13 +517,7 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 
 				g_gui.SetLoadDone(0, "Loading OTBM map...");
 
-				// Create a read handle on it
-				std::shared_ptr<NodeFileReadHandle> f(
-					new MemoryNodeFileReadHandle(otbm_buffer.get() + 4, otbm_size - 4)
-				);
-
-				// Read the version info
-				if (!loadMap(map, *f.get())) {
+				if (!loadMapParallel(map, otbm_buffer.get() + 4, otbm_size - 4)) {
 					error("Could not load OTBM file inside archive");
 					return false;
 				}
@@ -616,13 +613,13 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 	}
 #endif
 
-	DiskNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+	MappedNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
 	if (!f.isOk()) {
 		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage())).wc_str());
 		return false;
 	}
 
-	if (!loadMap(map, f)) {
+	if (!loadMapParallel(map, f.getNodeData(), f.getNodeSize())) {
 		return false;
 	}
 
@@ -648,10 +645,194 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 
 bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	BinaryNode* root = f.getRootNode();
-	if (!root) {
+	if (!root || !f.isOk()) {
 		error("Could not read root node.");
 		return false;
 	}
+
+	BinaryNode* mapHeaderNode = loadMapHeader(map, root);
+	if (!mapHeaderNode) {
+		return false;
+	}
+
+	int nodes_loaded = 0;
+
+	for (BinaryNode* mapNode = mapHeaderNode->getChild(); mapNode != nullptr; mapNode = mapNode->advance()) {
+		++nodes_loaded;
+		if (nodes_loaded % 15 == 0) {
+			g_gui.SetLoadDone(static_cast<int32_t>(100.0 * f.tell() / f.size()));
+		}
+
+		uint8_t node_type;
+		if (!mapNode->getByte(node_type)) {
+			warning("Invalid map node");
+			continue;
+		}
+		if (node_type == OTBM_TILE_AREA) {
+			StagedTileArea area;
+			decodeTileArea(mapNode, area);
+			mergeTileArea(map, area);
+		} else if (node_type == OTBM_TOWNS) {
+			loadTowns(map, mapNode);
+		} else if (node_type == OTBM_WAYPOINTS) {
+			loadWaypoints(map, mapNode);
+		}
+	}
+
+	if (!f.isOk()) {
+		warning(wxstr(f.getErrorMessage()).wc_str());
+	}
+	return true;
+}
+
+namespace {
+	// Byte range of one direct child of the OTBM_MAP_DATA node, NODE_START to NODE_END inclusive
+	struct OTBM_NodeRange {
+		size_t begin;
+		size_t end;
+		uint8_t type;
+	};
+
+	// Walks the raw (escaped) node stream without decoding anything and collects
+	// the ranges of every child of the map data node, in file order.
+	// data points to the root NODE_START, right after the file identifier.
+	bool scanMapDataChildren(const uint8_t* data, size_t size, std::vector<OTBM_NodeRange> &ranges) {
+		int depth = 0;
+		bool type_pending = false;
+		for (size_t i = 0; i < size; ++i) {
+			switch (data[i]) {
+				case NODE_START: {
+					++depth;
+					if (depth == 3) {
+						ranges.push_back({ i, 0, 0 });
+						type_pending = true;
+						continue;
+					}
+					break;
+				}
+				case NODE_END: {
+					if (depth == 3) {
+						ranges.back().end = i + 1;
+					} else if (depth == 2) {
+						// End of the map data node, nothing else is read by the loader
+						return true;
+					} else if (depth <= 0) {
+						return false;
+					}
+					--depth;
+					break;
+				}
+				case ESCAPE_CHAR: {
+					++i;
+					if (i >= size) {
+						return false;
+					}
+					break;
+				}
+				default:
+					break;
+			}
+			if (type_pending) {
+				ranges.back().type = data[i];
+				type_pending = false;
+			}
+		}
+		// The stream ended before the map data node was closed
+		return false;
+	}
+}
+
+bool IOMapOTBM::loadMapParallel(Map &map, const uint8_t* data, size_t size) {
+	using Clock = std::chrono::steady_clock;
+	const auto millisecondsSince = [](Clock::time_point start) {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+	};
+	const Clock::time_point load_start = Clock::now();
+
+	if (size == 0 || data[0] != NODE_START) {
+		error("Could not read root node.");
+		return false;
+	}
+
+	// Phase 1: locate the children of the map data node
+	std::vector<OTBM_NodeRange> ranges;
+	if (!scanMapDataChildren(data, size, ranges)) {
+		error("Node file syntax error, the map data node is not properly terminated.");
+		return false;
+	}
+	const auto scan_time = millisecondsSince(load_start);
+
+	{
+		// The header handle only ever reads the root and map data node bodies
+		MemoryNodeFileReadHandle header(data, size);
+		BinaryNode* root = header.getRootNode();
+		if (!root) {
+			error("Could not read root node.");
+			return false;
+		}
+		if (!loadMapHeader(map, root)) {
+			return false;
+		}
+	}
+
+	// Phase 2: decode every tile area on the worker pool
+	const Clock::time_point decode_start = Clock::now();
+	ThreadPool pool;
+	std::vector<std::future<StagedTileArea>> pending(ranges.size());
+	std::vector<Clock::time_point> decoded_at(ranges.size(), decode_start);
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		const OTBM_NodeRange &range = ranges[i];
+		if (range.type != OTBM_TILE_AREA) {
+			continue;
+		}
+		pending[i] = pool.enqueue([this, data, range, &decoded_at, i]() {
+			StagedTileArea area;
+			MemoryNodeFileReadHandle handle(data + range.begin, range.end - range.begin);
+			BinaryNode* areaNode = handle.getRootNode();
+			areaNode->skip(1); // Type byte, already known from the scan
+			decodeTileArea(areaNode, area);
+			decoded_at[i] = Clock::now();
+			return area;
+		});
+	}
+
+	// Phase 3: merge in file order, so the result is the same as the serial loader
+	Clock::duration merge_time = Clock::duration::zero();
+	Clock::time_point decode_end = decode_start;
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		if (i % 15 == 0) {
+			g_gui.SetLoadDone(static_cast<int32_t>(100.0 * i / ranges.size()));
+		}
+
+		const OTBM_NodeRange &range = ranges[i];
+		if (range.type == OTBM_TILE_AREA) {
+			StagedTileArea area = pending[i].get();
+			decode_end = std::max(decode_end, decoded_at[i]);
+
+			const Clock::time_point merge_start = Clock::now();
+			mergeTileArea(map, area);
+			merge_time += Clock::now() - merge_start;
+		} else if (range.type == OTBM_TOWNS || range.type == OTBM_WAYPOINTS) {
+			MemoryNodeFileReadHandle handle(data + range.begin, range.end - range.begin);
+			BinaryNode* mapNode = handle.getRootNode();
+			mapNode->skip(1);
+			if (range.type == OTBM_TOWNS) {
+				loadTowns(map, mapNode);
+			} else {
+				loadWaypoints(map, mapNode);
+			}
+		}
+	}
+
+	spdlog::info("Loaded OTBM map with {} nodes on {} threads: scan {} ms, decode {} ms, merge {} ms, total {} ms",
+		ranges.size(), pool.size(), scan_time,
+		std::chrono::duration_cast<std::chrono::milliseconds>(decode_end - decode_start).count(),
+		std::chrono::duration_cast<std::chrono::milliseconds>(merge_time).count(),
+		millisecondsSince(load_start));
+	return true;
+}
+
+BinaryNode* IOMapOTBM::loadMapHeader(Map &map, BinaryNode* root) {
 	root->skip(1); // Skip the type byte
 
 	uint8_t u8;
@@ -659,7 +840,7 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	uint32_t u32;
 
 	if (!root->getU32(u32)) {
-		return false;
+		return nullptr;
 	}
 
 	version.otbm = (MapVersionID)u32;
@@ -673,17 +854,17 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 			warning("Unsupported or damaged map version");
 		} else {
 			error("Unsupported OTBM version, could not load map");
-			return false;
+			return nullptr;
 		}
 	}
 
 	if (!root->getU16(u16)) {
-		return false;
+		return nullptr;
 	}
 
 	map.width = u16;
 	if (!root->getU16(u16)) {
-		return false;
+		return nullptr;
 	}
 
 	map.height = u16;
@@ -691,7 +872,7 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	BinaryNode* mapHeaderNode = root->getChild();
 	if (mapHeaderNode == nullptr || !mapHeaderNode->getByte(u8) || u8 != OTBM_MAP_DATA) {
 		error("Could not get root child node. Cannot recover from fatal error!");
-		return false;
+		return nullptr;
 	}
 
 	uint8_t attribute;
@@ -734,231 +915,248 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 			}
 		}
 	}
+	return mapHeaderNode;
+}
 
-	int nodes_loaded = 0;
-
-	for (BinaryNode* mapNode = mapHeaderNode->getChild(); mapNode != nullptr; mapNode = mapNode->advance()) {
-		++nodes_loaded;
-		if (nodes_loaded % 15 == 0) {
-			g_gui.SetLoadDone(static_cast<int32_t>(100.0 * f.tell() / f.size()));
+void IOMapOTBM::decodeTileArea(BinaryNode* mapNode, StagedTileArea &area) const {
+	// Runs on worker threads, so it must not touch the map or IOMap::warning
+	const auto stageWarning = [&area](const wxString &message) {
+		StagedTile entry;
+		entry.warnings.push_back(message);
+		area.tiles.push_back(std::move(entry));
+	};
+
+	uint16_t base_x, base_y;
+	uint8_t base_z;
+	if (!mapNode->getU16(base_x) || !mapNode->getU16(base_y) || !mapNode->getU8(base_z)) {
+		stageWarning("Invalid map node, no base coordinate");
+		return;
+	}
+
+	for (BinaryNode* tileNode = mapNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
+		uint8_t tile_type;
+		if (!tileNode->getByte(tile_type)) {
+			stageWarning("Invalid tile type");
+			continue;
 		}
-
-		uint8_t node_type;
-		if (!mapNode->getByte(node_type)) {
-			warning("Invalid map node");
+		if (tile_type != OTBM_TILE && tile_type != OTBM_HOUSETILE) {
+			stageWarning("Unknown type of tile node");
 			continue;
 		}
-		if (node_type == OTBM_TILE_AREA) {
-			uint16_t base_x, base_y;
-			uint8_t base_z;
-			if (!mapNode->getU16(base_x) || !mapNode->getU16(base_y) || !mapNode->getU8(base_z)) {
-				warning("Invalid map node, no base coordinate");
-				continue;
-			}
 
-			for (BinaryNode* tileNode = mapNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
-				Tile* tile = nullptr;
-				uint8_t tile_type;
-				if (!tileNode->getByte(tile_type)) {
-					warning("Invalid tile type");
-					continue;
-				}
-				if (tile_type == OTBM_TILE || tile_type == OTBM_HOUSETILE) {
-					// printf("Start\n");
-					uint8_t x_offset, y_offset;
-					if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
-						warning("Could not read position of tile");
-						continue;
-					}
-					const Position pos(base_x + x_offset, base_y + y_offset, base_z);
-
-					if (map.getTile(pos)) {
-						warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
-						continue;
-					}
-
-					tile = map.allocator(map.createTileL(pos));
-					House* house = nullptr;
-					if (tile_type == OTBM_HOUSETILE) {
-						uint32_t house_id;
-						if (!tileNode->getU32(house_id)) {
-							warning("House tile without house data, discarding tile");
-							delete tile;
-							continue;
-						}
-						if (house_id) {
-							house = map.houses.getHouse(house_id);
-							if (!house) {
-								house = newd House(map);
-								house->id = house_id;
-								map.houses.addHouse(house);
-							}
-						} else {
-							warning("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z);
-						}
-					}
+		uint8_t x_offset, y_offset;
+		if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
+			stageWarning("Could not read position of tile");
+			continue;
+		}
 
-					// printf("So far so good\n");
-
-					uint8_t attribute;
-					while (tileNode->getU8(attribute)) {
-						switch (attribute) {
-							case OTBM_ATTR_TILE_FLAGS: {
-								uint32_t flags = 0;
-								if (!tileNode->getU32(flags)) {
-									warning("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->setMapFlags(flags);
-								break;
-							}
-							case OTBM_ATTR_ITEM: {
-								Item* item = Item::Create_OTBM(*this, tileNode);
-								if (item == nullptr) {
-									warning("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->addItem(item);
-								break;
-							}
-							default: {
-								warning("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z);
-								break;
-							}
-						}
-					}
+		StagedTile &staged = area.tiles.emplace_back();
+		staged.located = true;
+		staged.pos = Position(base_x + x_offset, base_y + y_offset, base_z);
+		const Position &pos = staged.pos;
 
-					// printf("Didn't die in loop\n");
+		if (tile_type == OTBM_HOUSETILE) {
+			if (!tileNode->getU32(staged.house_id)) {
+				staged.warnings.push_back("House tile without house data, discarding tile");
+				continue;
+			}
+			if (staged.house_id == 0) {
+				staged.warnings.push_back(wxString::Format("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z));
+			}
+		}
 
-					for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
-						Item* item = nullptr;
-						uint8_t node_type;
-						if (!childNode->getByte(node_type)) {
-							warning("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z);
-							continue;
-						}
-						if (node_type == OTBM_ITEM) {
-							item = Item::Create_OTBM(*this, childNode);
-							if (item) {
-								if (!item->unserializeItemNode_OTBM(*this, childNode)) {
-									warning("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								// reform(&map, tile, item);
-								tile->addItem(item);
-							}
-						} else if (node_type == OTBM_TILE_ZONE) {
-							uint16_t zone_count;
-							if (!childNode->getU16(zone_count)) {
-								warning("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z);
-								continue;
-							}
-							for (uint16_t i = 0; i < zone_count; ++i) {
-								uint16_t zone_id;
-								if (!childNode->getU16(zone_id)) {
-									warning("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z);
-									continue;
-								}
-								tile->addZone(zone_id);
-							}
-						} else {
-							warning("Unknown type of tile child node");
-						}
-					}
+		// Detached until the merge gives it a location
+		Tile* tile = newd Tile(pos.x, pos.y, pos.z);
+		staged.tile = tile;
 
-					tile->update();
-					if (house) {
-						house->addTile(tile);
+		uint8_t attribute;
+		while (tileNode->getU8(attribute)) {
+			switch (attribute) {
+				case OTBM_ATTR_TILE_FLAGS: {
+					uint32_t flags = 0;
+					if (!tileNode->getU32(flags)) {
+						staged.warnings.push_back(wxString::Format("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z));
 					}
-
-					map.setTile(pos.x, pos.y, pos.z, tile);
-				} else {
-					warning("Unknown type of tile node");
+					tile->setMapFlags(flags);
+					break;
 				}
-			}
-		} else if (node_type == OTBM_TOWNS) {
-			for (BinaryNode* townNode = mapNode->getChild(); townNode != nullptr; townNode = townNode->advance()) {
-				Town* town = nullptr;
-				uint8_t town_type;
-				if (!townNode->getByte(town_type)) {
-					warning("Invalid town type (1)");
-					continue;
-				}
-				if (town_type != OTBM_TOWN) {
-					warning("Invalid town type (2)");
-					continue;
+				case OTBM_ATTR_ITEM: {
+					Item* item = Item::Create_OTBM(*this, tileNode);
+					if (item == nullptr) {
+						staged.warnings.push_back(wxString::Format("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z));
+					}
+					tile->addItem(item);
+					break;
 				}
-				uint32_t town_id;
-				if (!townNode->getU32(town_id)) {
-					warning("Invalid town id");
-					continue;
+				default: {
+					staged.warnings.push_back(wxString::Format("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z));
+					break;
 				}
+			}
+		}
 
-				town = map.towns.getTown(town_id);
-				if (town) {
-					warning("Duplicate town id %d, discarding duplicate", town_id);
-					continue;
-				} else {
-					town = newd Town(town_id);
-					if (!map.towns.addTown(town)) {
-						delete town;
-						continue;
+		for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
+			uint8_t node_type;
+			if (!childNode->getByte(node_type)) {
+				staged.warnings.push_back(wxString::Format("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z));
+				continue;
+			}
+			if (node_type == OTBM_ITEM) {
+				Item* item = Item::Create_OTBM(*this, childNode);
+				if (item) {
+					if (!item->unserializeItemNode_OTBM(*this, childNode)) {
+						staged.warnings.push_back(wxString::Format("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z));
 					}
+					// reform(&map, tile, item);
+					tile->addItem(item);
 				}
-				std::string town_name;
-				if (!townNode->getString(town_name)) {
-					warning("Invalid town name");
+			} else if (node_type == OTBM_TILE_ZONE) {
+				uint16_t zone_count;
+				if (!childNode->getU16(zone_count)) {
+					staged.warnings.push_back(wxString::Format("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z));
 					continue;
 				}
-				town->setName(town_name);
-				Position pos;
-				uint16_t x;
-				uint16_t y;
-				uint8_t z;
-				if (!townNode->getU16(x) || !townNode->getU16(y) || !townNode->getU8(z)) {
-					warning("Invalid town temple position");
-					continue;
+				for (uint16_t i = 0; i < zone_count; ++i) {
+					uint16_t zone_id;
+					if (!childNode->getU16(zone_id)) {
+						staged.warnings.push_back(wxString::Format("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z));
+						continue;
+					}
+					tile->addZone(zone_id);
 				}
-				pos.x = x;
-				pos.y = y;
-				pos.z = z;
-				town->setTemplePosition(pos);
+			} else {
+				staged.warnings.push_back("Unknown type of tile child node");
 			}
-		} else if (node_type == OTBM_WAYPOINTS) {
-			for (BinaryNode* waypointNode = mapNode->getChild(); waypointNode != nullptr; waypointNode = waypointNode->advance()) {
-				uint8_t waypoint_type;
-				if (!waypointNode->getByte(waypoint_type)) {
-					warning("Invalid waypoint type (1)");
-					continue;
-				}
-				if (waypoint_type != OTBM_WAYPOINT) {
-					warning("Invalid waypoint type (2)");
-					continue;
-				}
+		}
 
-				Waypoint wp;
+		tile->update();
+	}
+}
 
-				if (!waypointNode->getString(wp.name)) {
-					warning("Invalid waypoint name");
-					continue;
-				}
-				uint16_t x;
-				uint16_t y;
-				uint8_t z;
-				if (!waypointNode->getU16(x) || !waypointNode->getU16(y) || !waypointNode->getU8(z)) {
-					warning("Invalid waypoint position");
-					continue;
-				}
-				wp.pos.x = x;
-				wp.pos.y = y;
-				wp.pos.z = z;
+void IOMapOTBM::mergeTileArea(Map &map, StagedTileArea &area) {
+	for (StagedTile &staged : area.tiles) {
+		if (!staged.located) {
+			for (const wxString &message : staged.warnings) {
+				warnings.push_back(message);
+			}
+			continue;
+		}
+
+		const Position &pos = staged.pos;
+		if (map.getTile(pos)) {
+			// The serial loader never decoded duplicates, so their own warnings are dropped
+			warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
+			delete staged.tile;
+			continue;
+		}
+
+		TileLocation* location = map.createTileL(pos);
+		for (const wxString &message : staged.warnings) {
+			warnings.push_back(message);
+		}
+
+		Tile* tile = staged.tile;
+		if (!tile) {
+			continue;
+		}
+		tile->setLocation(location);
 
-				map.waypoints.addWaypoint(newd Waypoint(wp));
+		if (staged.house_id) {
+			House* house = map.houses.getHouse(staged.house_id);
+			if (!house) {
+				house = newd House(map);
+				house->id = staged.house_id;
+				map.houses.addHouse(house);
 			}
+			house->addTile(tile);
 		}
+
+		map.setTile(pos.x, pos.y, pos.z, tile);
 	}
+	area.tiles.clear();
+}
 
-	if (!f.isOk()) {
-		warning(wxstr(f.getErrorMessage()).wc_str());
+void IOMapOTBM::loadTowns(Map &map, BinaryNode* mapNode) {
+	for (BinaryNode* townNode = mapNode->getChild(); townNode != nullptr; townNode = townNode->advance()) {
+		Town* town = nullptr;
+		uint8_t town_type;
+		if (!townNode->getByte(town_type)) {
+			warning("Invalid town type (1)");
+			continue;
+		}
+		if (town_type != OTBM_TOWN) {
+			warning("Invalid town type (2)");
+			continue;
+		}
+		uint32_t town_id;
+		if (!townNode->getU32(town_id)) {
+			warning("Invalid town id");
+			continue;
+		}
+
+		town = map.towns.getTown(town_id);
+		if (town) {
+			warning("Duplicate town id %d, discarding duplicate", town_id);
+			continue;
+		} else {
+			town = newd Town(town_id);
+			if (!map.towns.addTown(town)) {
+				delete town;
+				continue;
+			}
+		}
+		std::string town_name;
+		if (!townNode->getString(town_name)) {
+			warning("Invalid town name");
+			continue;
+		}
+		town->setName(town_name);
+		Position pos;
+		uint16_t x;
+		uint16_t y;
+		uint8_t z;
+		if (!townNode->getU16(x) || !townNode->getU16(y) || !townNode->getU8(z)) {
+			warning("Invalid town temple position");
+			continue;
+		}
+		pos.x = x;
+		pos.y = y;
+		pos.z = z;
+		town->setTemplePosition(pos);
+	}
+}
+
+void IOMapOTBM::loadWaypoints(Map &map, BinaryNode* mapNode) {
+	for (BinaryNode* waypointNode = mapNode->getChild(); waypointNode != nullptr; waypointNode = waypointNode->advance()) {
+		uint8_t waypoint_type;
+		if (!waypointNode->getByte(waypoint_type)) {
+			warning("Invalid waypoint type (1)");
+			continue;
+		}
+		if (waypoint_type != OTBM_WAYPOINT) {
+			warning("Invalid waypoint type (2)");
+			continue;
+		}
+
+		Waypoint wp;
+
+		if (!waypointNode->getString(wp.name)) {
+			warning("Invalid waypoint name");
+			continue;
+		}
+		uint16_t x;
+		uint16_t y;
+		uint8_t z;
+		if (!waypointNode->getU16(x) || !waypointNode->getU16(y) || !waypointNode->getU8(z)) {
+			warning("Invalid waypoint position");
+			continue;
+		}
+		wp.pos.x = x;
+		wp.pos.y = y;
+		wp.pos.z = z;
+
+		map.waypoints.addWaypoint(newd Waypoint(wp));
 	}
-	return true;
 }
 
 bool IOMapOTBM::loadSpawnsMonster(Map &map, const FileName &dir) {
@@ -1490,25 +1688,67 @@ bool IOMapOTBM::saveMap(Map &map, const FileName &identifier) {
 		archive_write_close(a);
 		archive_write_free(a);
 
+		// There's no plain node stream on disk to copy areas from
+		map.saved_areas.clear();
+
 		g_gui.DestroyLoadBar();
 		return true;
 	}
 #endif
 
+	const std::string path = nstr(identifier.GetFullPath());
+	Map::SavedTileAreas &saved = map.saved_areas;
+
+	// Only reuse the previous save if it's still the exact file the area index was made for
+	FileMapping previous;
+	if (!previous_save.empty() && previous_save != path && saved.filename == path && saved.version == version.otbm) {
+		std::error_code ec;
+		const uint64_t size = std::filesystem::file_size(previous_save, ec);
+		const int64_t time = ec ? 0 : std::filesystem::last_write_time(previous_save, ec).time_since_epoch().count();
+		if (!ec && size == saved.file_size && time == saved.file_time && previous.open(previous_save) && previous.getSize() == size && size > 4) {
+			reuse_data = previous.getData() + 4;
+			reuse_size = previous.getSize() - 4;
+			reuse_ranges = &saved.ranges;
+		}
+	}
+
 	DiskNodeFileWriteHandle f(
-		nstr(identifier.GetFullPath()),
+		path,
 		(g_settings.getInteger(Config::SAVE_WITH_OTB_MAGIC_NUMBER) ? "OTBM" : std::string(4, '\0'))
 	);
 
 	if (!f.isOk()) {
+		reuse_data = nullptr;
+		reuse_ranges = nullptr;
 		error("Can not open file %s for writing", (const char*)identifier.GetFullPath().mb_str(wxConvUTF8));
 		return false;
 	}
 
-	if (!saveMap(map, f)) {
+	const bool saved_ok = saveMap(map, f);
+	reuse_data = nullptr;
+	reuse_size = 0;
+	reuse_ranges = nullptr;
+	previous.close();
+
+	f.close();
+	if (!saved_ok || !f.isOk()) {
 		return false;
 	}
 
+	// Remember where the areas went for the next save, it's only valid as long as the file is untouched
+	std::error_code ec;
+	saved.filename = path;
+	saved.file_size = std::filesystem::file_size(path, ec);
+	saved.file_time = ec ? 0 : std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	saved.version = version.otbm;
+	saved.ranges = std::move(written_areas);
+	if (ec) {
+		saved.clear();
+	}
+	map.clearDirtyAreas();
+
+	spdlog::info("Saved {}: {} tile area bytes reused, {} encoded", path, reused_bytes, encoded_bytes);
+
 	g_gui.SetLoadDone(99, "Saving monster spawns...");
 	saveSpawns(map, identifier);
 
@@ -1535,8 +1775,6 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	 * format.
 	 */
 
-	const IOMapOTBM &self = *this;
-
 	FileName tmpName;
 	f.addNode(0);
 	{
@@ -1574,119 +1812,82 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 			f.addU8(OTBM_ATTR_EXT_ZONE_FILE);
 			f.addString(nstr(tmpName.GetFullName()));
 
-			// Start writing tiles
-			uint32_t tiles_saved = 0;
-			bool first = true;
+			// Tiles are written as one node per tile area (256x256 tiles of one floor), in tree order.
+			// Areas unchanged since the previous save are copied from it byte for byte.
+			written_areas.clear();
+			reused_bytes = 0;
+			encoded_bytes = 0;
 
-			int local_x = -1, local_y = -1, local_z = -1;
+			size_t columns_total = 0, columns_saved = 0;
+			map.forEachTileAreaColumn([&columns_total](int, int, QTreeNode &) { ++columns_total; });
 
-			MapIterator map_iterator = map.begin();
-			while (map_iterator != map.end()) {
+			std::vector<QTreeNode*> leaves;
+			map.forEachTileAreaColumn([&](int area_x, int area_y, QTreeNode &column) {
 				// Update progressbar
-				++tiles_saved;
-				if (tiles_saved % 8192 == 0) {
-					g_gui.SetLoadDone(int(tiles_saved / double(map.getTileCount()) * 100.0));
-				}
-
-				// Get tile
-				Tile* save_tile = (*map_iterator)->get();
-
-				// Is it an empty tile that we can skip? (Leftovers...)
-				if (!save_tile || save_tile->size() == 0) {
-					++map_iterator;
-					continue;
-				}
-
-				const Position &pos = save_tile->getPosition();
-
-				// Decide if newd node should be created
-				if (pos.x < local_x || pos.x >= local_x + 256 || pos.y < local_y || pos.y >= local_y + 256 || pos.z != local_z) {
-					// End last node
-					if (!first) {
-						f.endNode();
-					}
-					first = false;
-
-					// Start newd node
-					f.addNode(OTBM_TILE_AREA);
-					f.addU16(local_x = pos.x & 0xFF00);
-					f.addU16(local_y = pos.y & 0xFF00);
-					f.addU8(local_z = pos.z);
-				}
-				f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
-
-				f.addU8(save_tile->getX() & 0xFF);
-				f.addU8(save_tile->getY() & 0xFF);
-
-				if (save_tile->isHouseTile()) {
-					f.addU32(save_tile->getHouseID());
+				++columns_saved;
+				if (columns_saved * 100 / columns_total != (columns_saved - 1) * 100 / columns_total) {
+					g_gui.SetLoadDone(int(columns_saved * 100 / columns_total));
 				}
 
-				if (save_tile->getMapFlags()) {
-					f.addByte(OTBM_ATTR_TILE_FLAGS);
-					f.addU32(save_tile->getMapFlags());
-				}
-
-				if (save_tile->ground) {
-					Item* ground = save_tile->ground;
-					if (ground->isMetaItem()) {
-						// Do nothing, we don't save metaitems...
-					} else if (ground->hasBorderEquivalent()) {
-						bool found = false;
-						for (Item* item : save_tile->items) {
-							if (item->getGroundEquivalent() == ground->getID()) {
-								// Do nothing
-								// Found equivalent
-								found = true;
-								break;
-							}
+				leaves.clear();
+				uint32_t floors = 0;
+				column.forEachLeaf([&](QTreeNode &leaf) {
+					leaves.push_back(&leaf);
+					for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+						if (leaf.getOccupancy(z)) {
+							floors |= 1u << z;
 						}
-
-						if (!found) {
-							if (ground->getID() == 0) {
-								continue;
-							}
-							ground->serializeItemNode_OTBM(self, f);
-						}
-					} else if (ground->isComplex()) {
-						if (ground->getID() == 0) {
+					}
+				});
+
+				for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+					const uint32_t key = BaseMap::getTileAreaKey(area_x, area_y, z);
+					if (reuse_ranges && !map.isAreaDirty(key)) {
+						const auto it = reuse_ranges->find(key);
+						if (it == reuse_ranges->end()) {
+							// Had nothing worth saving last time either
 							continue;
 						}
-						ground->serializeItemNode_OTBM(self, f);
-					} else {
-						f.addByte(OTBM_ATTR_ITEM);
-						if (ground->getID() == 0) {
+						const auto [offset, size] = it->second;
+						if (offset + size <= reuse_size && size > 2 && reuse_data[offset] == NODE_START && reuse_data[offset + 1] == OTBM_TILE_AREA) {
+							written_areas[key] = { f.getWriteOffset(), size };
+							f.addEncoded(reuse_data + offset, size);
+							reused_bytes += size;
 							continue;
 						}
-						ground->serializeItemCompact_OTBM(self, f);
 					}
-				}
 
-				for (Item* item : save_tile->items) {
-					if (!item->isMetaItem()) {
-						if (item->getID() == 0) {
-							continue;
-						}
-						item->serializeItemNode_OTBM(self, f);
-					}
-				}
-				if (!save_tile->zones.empty()) {
-					f.addNode(OTBM_TILE_ZONE);
-					f.addU16(save_tile->zones.size());
-					for (const auto &zoneId : save_tile->zones) {
-						f.addU16(zoneId);
+					if ((floors & (1u << z)) == 0) {
+						continue;
 					}
-					f.endNode();
-				}
 
-				f.endNode();
-				++map_iterator;
-			}
+					const uint64_t start = f.getWriteOffset();
+					bool started = false;
+					for (QTreeNode* leaf : leaves) {
+						leaf->forEachTile(z, [&](TileLocation &location) {
+							const Tile* save_tile = location.get();
+							// Is it an empty tile that we can skip? (Leftovers...)
+							if (!save_tile || save_tile->size() == 0) {
+								return;
+							}
+							if (!started) {
+								f.addNode(OTBM_TILE_AREA);
+								f.addU16(area_x);
+								f.addU16(area_y);
+								f.addU8(z);
+								started = true;
+							}
+							saveTile(save_tile, f);
+						});
+					}
 
-			// Only close the last node if one has actually been created
-			if (!first) {
-				f.endNode();
-			}
+					if (started) {
+						f.endNode();
+						written_areas[key] = { start, f.getWriteOffset() - start };
+						encoded_bytes += f.getWriteOffset() - start;
+					}
+				}
+			});
 
 			f.addNode(OTBM_TOWNS);
 			for (const auto &townEntry : map.towns) {
@@ -1722,6 +1923,70 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	return true;
 }
 
+void IOMapOTBM::saveTile(const Tile* save_tile, NodeFileWriteHandle &f) const {
+	const IOMapOTBM &self = *this;
+
+	f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+
+	f.addU8(save_tile->getX() & 0xFF);
+	f.addU8(save_tile->getY() & 0xFF);
+
+	if (save_tile->isHouseTile()) {
+		f.addU32(save_tile->getHouseID());
+	}
+
+	if (save_tile->getMapFlags()) {
+		f.addByte(OTBM_ATTR_TILE_FLAGS);
+		f.addU32(save_tile->getMapFlags());
+	}
+
+	// Grounds without an id are never written
+	Item* ground = save_tile->ground;
+	if (ground && ground->getID() != 0) {
+		if (ground->isMetaItem()) {
+			// Do nothing, we don't save metaitems...
+		} else if (ground->hasBorderEquivalent()) {
+			bool found = false;
+			for (Item* item : save_tile->items) {
+				if (item->getGroundEquivalent() == ground->getID()) {
+					// Do nothing
+					// Found equivalent
+					found = true;
+					break;
+				}
+			}
+
+			if (!found) {
+				ground->serializeItemNode_OTBM(self, f);
+			}
+		} else if (ground->isComplex()) {
+			ground->serializeItemNode_OTBM(self, f);
+		} else {
+			f.addByte(OTBM_ATTR_ITEM);
+			ground->serializeItemCompact_OTBM(self, f);
+		}
+	}
+
+	for (Item* item : save_tile->items) {
+		if (!item->isMetaItem()) {
+			if (item->getID() == 0) {
+				continue;
+			}
+			item->serializeItemNode_OTBM(self, f);
+		}
+	}
+	if (!save_tile->zones.empty()) {
+		f.addNode(OTBM_TILE_ZONE);
+		f.addU16(save_tile->zones.size());
+		for (const auto &zoneId : save_tile->zones) {
+			f.addU16(zoneId);
+		}
+		f.endNode();
+	}
+
+	f.endNode();
+}
+
 bool IOMapOTBM::saveSpawns(Map &map, const FileName &dir) {
 	wxString filepath = dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
 	filepath += wxString(map.spawnmonsterfile.c_str(), wxConvUTF8);
@@ -19,6 +19,7 @@
 #define RME_OTBM_MAP_IO_H_
 
 #include "iomap.h"
+#include "position.h"
 
 enum OTBM_ItemAttribute {
 	OTBM_ATTR_DESCRIPTION = 1,
@@ -109,9 +110,11 @@ struct OTBM_HouseTile_coords {
 };
 
 struct MapVersion;
+class BinaryNode;
 class NodeFileReadHandle;
 class NodeFileWriteHandle;
 class Map;
+class Tile;
 
 class IOMapOTBM : public IOMap {
 public:
@@ -123,10 +126,47 @@ public:
 	virtual bool loadMap(Map &map, const FileName &identifier);
 	virtual bool saveMap(Map &map, const FileName &identifier);
 
+	// The file the map was last saved as, under its current name (the editor moves it aside
+	// before saving). Tile areas that have not changed since are copied from it as they are.
+	void setPreviousSave(const std::string &path) {
+		previous_save = path;
+	}
+	// Tile area bytes copied from the previous save and encoded anew by the last saveMap
+	uint64_t getReusedBytes() const noexcept {
+		return reused_bytes;
+	}
+	uint64_t getEncodedBytes() const noexcept {
+		return encoded_bytes;
+	}
+
 protected:
 	static bool getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver);
 
 	virtual bool loadMap(Map &map, NodeFileReadHandle &handle);
+	// Decodes the tile areas on a worker pool, data must hold the whole node tree (without the file identifier)
+	bool loadMapParallel(Map &map, const uint8_t* data, size_t size);
+
+	// A tile decoded off the map, it's given a location and inserted when the area is merged
+	struct StagedTile {
+		Position pos;
+		Tile* tile = nullptr;
+		uint32_t house_id = 0;
+		// False for entries that only carry warnings of nodes without a position
+		bool located = false;
+		std::vector<wxString> warnings;
+	};
+	struct StagedTileArea {
+		std::vector<StagedTile> tiles;
+	};
+
+	// Returns the map data node, or nullptr on failure
+	BinaryNode* loadMapHeader(Map &map, BinaryNode* root);
+	// Thread safe, only reads the node and the item database
+	void decodeTileArea(BinaryNode* mapNode, StagedTileArea &area) const;
+	void mergeTileArea(Map &map, StagedTileArea &area);
+	void loadTowns(Map &map, BinaryNode* mapNode);
+	void loadWaypoints(Map &map, BinaryNode* mapNode);
+
 	bool loadSpawnsMonster(Map &map, const FileName &dir);
 	bool loadSpawnsMonster(Map &map, pugi::xml_document &doc);
 	bool loadHouses(Map &map, const FileName &dir);
@@ -137,6 +177,7 @@ protected:
 	bool loadZones(Map &map, pugi::xml_document &doc);
 
 	virtual bool saveMap(Map &map, NodeFileWriteHandle &handle);
+	void saveTile(const Tile* tile, NodeFileWriteHandle &f) const;
 	bool saveSpawns(Map &map, const FileName &dir);
 	bool saveSpawns(Map &map, pugi::xml_document &doc);
 	bool saveHouses(Map &map, const FileName &dir);
@@ -145,6 +186,15 @@ protected:
 	bool saveSpawnsNpc(Map &map, pugi::xml_document &doc);
 	bool saveZones(Map &map, const FileName &dir);
 	bool saveZones(Map &map, pugi::xml_document &doc);
+
+	std::string previous_save;
+	// Node stream of the previous save (past the identifier), only set while saving
+	const uint8_t* reuse_data = nullptr;
+	size_t reuse_size = 0;
+	const std::unordered_map<uint32_t, std::pair<uint64_t, uint64_t>>* reuse_ranges = nullptr;
+	std::unordered_map<uint32_t, std::pair<uint64_t, uint64_t>> written_areas;
+	uint64_t reused_bytes = 0;
+	uint64_t encoded_bytes = 0;
 };
 
 #endif
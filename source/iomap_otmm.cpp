@@ -279,13 +279,13 @@ IOMapOTMM::~IOMapOTMM() {
 
 ClientVersionID IOMapOTMM::getVersionInfo(const FileName &filename) {
 	wxString wpath = filename.GetFullPath();
-	DiskNodeFileReadHandle f((const char*)wpath.mb_str(wxConvUTF8));
+	MappedNodeFileReadHandle f((const char*)wpath.mb_str(wxConvUTF8), StringVector(1, "OTMM"));
 	if (f.isOk() == false) {
 		return CLIENT_VERSION_NONE;
 	}
 
 	BinaryNode* root = f.getRootNode();
-	if (!root) {
+	if (!root || !f.isOk()) {
 		return CLIENT_VERSION_NONE;
 	}
 	root->skip(1); // Skip the type byte
@@ -311,7 +311,7 @@ bool IOMapOTMM::loadMap(Map &map, const FileName &identifier, bool showdialog) {
 	if (showdialog) {
 		g_gui.CreateLoadBar("Loading OTMM map...");
 	}
-	DiskNodeFileReadHandle f(nstr(identifier.GetFullPath()));
+	MappedNodeFileReadHandle f(nstr(identifier.GetFullPath()), StringVector(1, "OTMM"));
 	if (f.isOk() == false) {
 		error("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage()));
 		return false;
@@ -328,7 +328,7 @@ bool IOMapOTMM::loadMap(Map &map, const FileName &identifier, bool showdialog) {
 
 bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identifier, bool showdialog) {
 	BinaryNode* root = f.getRootNode();
-	if (!root) {
+	if (!root || !f.isOk()) {
 		error("Could not read root node.");
 		return false;
 	}
@@ -27,6 +27,68 @@
 #include <wx/image.h>
 #include <zlib.h>
 
+#include <array>
+#include <filesystem>
+#include <unordered_set>
+
+namespace {
+	// Pyramid tiles are the size of a tile area column, so the native zoom renders one column per tile
+	// and 256 of them span the 65536 wide map
+	constexpr int PyramidTileSize = 256;
+	constexpr int PyramidMaxZoom = 8;
+	// Subtrees rooted at this zoom are rendered as pool jobs, the levels above on the calling thread
+	constexpr int PyramidSplitZoom = 3;
+	constexpr size_t PyramidTileBytes = PyramidTileSize * PyramidTileSize * rme::PixelFormatRGB;
+
+	uint32_t getPyramidKey(int zoom, int x, int y) {
+		return (static_cast<uint32_t>(zoom) << 16) | (static_cast<uint32_t>(y) << 8) | static_cast<uint32_t>(x);
+	}
+
+	void setMinimapPixel(uint8_t* pixel, uint8_t color) {
+		pixel[0] = (uint8_t)(static_cast<int>(color / 36) % 6 * 51); // red
+		pixel[1] = (uint8_t)(static_cast<int>(color / 6) % 6 * 51); // green
+		pixel[2] = (uint8_t)(color % 6 * 51); // blue
+	}
+
+	// Halves child into one quadrant of parent, black pixels count as empty
+	void downsampleQuadrant(const std::vector<uint8_t> &child, std::vector<uint8_t> &parent, int quadrant) {
+		constexpr int half = PyramidTileSize / 2;
+		const int offset_x = (quadrant & 1) * half;
+		const int offset_y = (quadrant >> 1) * half;
+		for (int y = 0; y < half; ++y) {
+			for (int x = 0; x < half; ++x) {
+				int sum[3] = { 0, 0, 0 };
+				int count = 0;
+				for (int i = 0; i < 4; ++i) {
+					const uint8_t* pixel = &child[((y * 2 + (i >> 1)) * PyramidTileSize + x * 2 + (i & 1)) * rme::PixelFormatRGB];
+					if (pixel[0] | pixel[1] | pixel[2]) {
+						sum[0] += pixel[0];
+						sum[1] += pixel[1];
+						sum[2] += pixel[2];
+						++count;
+					}
+				}
+				if (count != 0) {
+					uint8_t* target = &parent[((offset_y + y) * PyramidTileSize + offset_x + x) * rme::PixelFormatRGB];
+					target[0] = static_cast<uint8_t>(sum[0] / count);
+					target[1] = static_cast<uint8_t>(sum[1] / count);
+					target[2] = static_cast<uint8_t>(sum[2] / count);
+				}
+			}
+		}
+	}
+}
+
+struct IOMinimap::PyramidFloor {
+	int z;
+	std::filesystem::path directory;
+	const std::unordered_map<uint32_t, QTreeNode*>* columns;
+	// Every pyramid tile with an occupied column of this floor below it, keyed by getPyramidKey
+	std::unordered_set<uint32_t> occupied;
+	// Split zoom tiles rendered on the pool, keyed like columns. Empty pixels for empty subtrees.
+	std::unordered_map<uint32_t, std::future<std::vector<uint8_t>>> jobs;
+};
+
 void MinimapBlock::updateTile(int x, int y, const MinimapTile &tile) {
 	m_tiles[getTileIndex(x, y)] = tile;
 }
@@ -55,6 +117,9 @@ bool IOMinimap::saveMinimap(const std::string &directory, const std::string &nam
 	if (m_format == MinimapExportFormat::Otmm) {
 		return saveOtmm(wxFileName(directory, name + ".otmm"));
 	}
+	if (m_format == MinimapExportFormat::PngTiles) {
+		return exportTiles(directory, name);
+	}
 	return saveImage(directory, name);
 }
 
@@ -84,31 +149,42 @@ bool IOMinimap::saveOtmm(const wxFileName &file) {
 		writer.addU16(start);
 		writer.seek(start);
 
-		unsigned long blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-		std::vector<uint8_t> buffer(compressBound(blockSize));
-		constexpr int COMPRESS_LEVEL = 3;
-
-		readBlocks();
-
-		for (uint8_t z = 0; z <= rme::MapMaxLayer; ++z) {
-			for (auto &it : m_blocks[z]) {
-				int index = it.first;
-				auto &block = it.second;
-
-				// write index pos
-				uint16_t x = static_cast<uint16_t>((index % (65536 / MMBLOCK_SIZE)) * MMBLOCK_SIZE);
-				uint16_t y = static_cast<uint16_t>((index / (65536 / MMBLOCK_SIZE)) * MMBLOCK_SIZE);
-				writer.addU16(x);
-				writer.addU16(y);
-				writer.addU8(z);
-
-				unsigned long len = blockSize;
-				int ret = compress2(buffer.data(), &len, (uint8_t*)&block.getTiles(), blockSize, COMPRESS_LEVEL);
-				assert(ret == Z_OK);
-				writer.addU16(len);
-				writer.addRAW(buffer.data(), len);
+		// Columns are encoded on the pool and written in map order as they finish. Only a few
+		// columns are in flight at a time, so memory stays bounded whatever the map size.
+		if (m_mode != MinimapExportMode::SelectedArea || m_editor->hasSelection()) {
+			auto &map = m_editor->getMap();
+			std::vector<std::pair<Position, QTreeNode*>> columns;
+			map.forEachTileAreaColumn([&columns](int x, int y, QTreeNode &column) {
+				columns.emplace_back(Position(x, y, 0), &column);
+			});
+
+			ThreadPool pool;
+			const size_t window = pool.size() * 2;
+			std::deque<std::future<std::vector<EncodedBlock>>> pending;
+			size_t written = 0;
+			const auto writeNext = [&]() {
+				for (const EncodedBlock &block : pending.front().get()) {
+					writer.addU16(block.x);
+					writer.addU16(block.y);
+					writer.addU8(block.z);
+					writer.addU16(block.data.size());
+					writer.addRAW(block.data.data(), block.data.size());
+				}
+				pending.pop_front();
+				if (m_updateLoadbar && ++written % 16 == 0) {
+					g_gui.SetLoadDone(int(written / double(columns.size()) * 90.0));
+				}
+			};
+
+			for (const auto &entry : columns) {
+				pending.push_back(pool.enqueue([this, entry]() { return encodeColumn(*entry.second, entry.first.x, entry.first.y); }));
+				if (pending.size() >= window) {
+					writeNext();
+				}
+			}
+			while (!pending.empty()) {
+				writeNext();
 			}
-			m_blocks[z].clear();
 		}
 
 		// end of file is an invalid pos
@@ -153,109 +229,237 @@ bool IOMinimap::exportMinimap(const std::string &directory) {
 		return true;
 	}
 
-	wxRect bounds[rme::MapLayers];
-	int min_z = m_floor == -1 ? 0 : m_floor;
-	int max_z = m_floor == -1 ? rme::MapMaxLayer : m_floor;
-
-	for (size_t z = min_z; z <= max_z; z++) {
-		auto &rect = bounds[z];
-		rect.x = rme::MapMaxWidth + 1;
-		rect.y = rme::MapMaxHeight + 1;
-		rect.width = 0;
-		rect.height = 0;
-	}
-
-	int totalTiles = 0;
-	for (auto it = map.begin(); it != map.end(); ++it) {
-		auto tile = (*it)->get();
-		if (!tile || (!tile->ground && tile->items.empty())) {
-			continue;
+	const int min_z = m_floor == -1 ? 0 : m_floor;
+	const int max_z = m_floor == -1 ? rme::MapMaxLayer : m_floor;
+
+	// Image sizes are multiples of 256, so every tile area column falls in exactly one image
+	std::map<std::tuple<int, int, int>, std::vector<QTreeNode*>> images;
+	map.forEachTileAreaColumn([&](int x, int y, QTreeNode &column) {
+		uint32_t floors = 0;
+		column.forEachLeaf([&floors](QTreeNode &leaf) {
+			for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+				if (leaf.getOccupancy(z)) {
+					floors |= 1u << z;
+				}
+			}
+		});
+		for (int z = min_z; z <= max_z; ++z) {
+			if (floors & (1u << z)) {
+				images[{ z, y - y % m_imageSize, x - x % m_imageSize }].push_back(&column);
+			}
 		}
+	});
+
+	// Every job holds one full image, the number in flight is capped to keep memory in check
+	const size_t pixels_size = static_cast<size_t>(m_imageSize) * m_imageSize * rme::PixelFormatRGB;
+	ThreadPool pool;
+	const size_t window = std::clamp<size_t>((512 * 1024 * 1024) / pixels_size, 1, pool.size());
+
+	const wxString extension = m_format == MinimapExportFormat::Png ? "png" : "bmp";
+	const wxBitmapType type = m_format == MinimapExportFormat::Png ? wxBITMAP_TYPE_PNG : wxBITMAP_TYPE_BMP;
+
+	std::deque<std::future<void>> pending;
+	size_t done = 0;
+	for (const auto &entry : images) {
+		const int z = std::get<0>(entry.first);
+		const int h = std::get<1>(entry.first);
+		const int w = std::get<2>(entry.first);
+		const std::vector<QTreeNode*> &columns = entry.second;
+		pending.push_back(pool.enqueue([&, z, h, w]() {
+			std::vector<uint8_t> pixels(pixels_size, 0);
+			bool empty = true;
+			for (QTreeNode* column : columns) {
+				column->forEachLeaf([&](QTreeNode &leaf) {
+					leaf.forEachTile(z, [&](TileLocation &location) {
+						const Tile* tile = location.get();
+						if (!tile || (!tile->ground && tile->items.empty())) {
+							return;
+						}
+						const Position &position = location.getPosition();
+						const size_t index = (static_cast<size_t>(position.y - h) * m_imageSize + (position.x - w)) * rme::PixelFormatRGB;
+						const uint8_t color = tile->getMiniMapColor();
+						pixels[index] = (uint8_t)(static_cast<int>(color / 36) % 6 * 51); // red
+						pixels[index + 1] = (uint8_t)(static_cast<int>(color / 6) % 6 * 51); // green
+						pixels[index + 2] = (uint8_t)(color % 6 * 51); // blue
+						empty = false;
+					});
+				});
+			}
 
-		const auto &position = tile->getPosition();
-		auto &rect = bounds[position.z];
-		if (position.x < rect.x) {
-			rect.x = position.x;
-		}
-		if (position.y < rect.y) {
-			rect.y = position.y;
-		}
-		if (position.x > rect.width) {
-			rect.width = position.x;
-		}
-		if (position.y > rect.height) {
-			rect.height = position.y;
+			if (!empty) {
+				wxImage image(m_imageSize, m_imageSize, pixels.data(), true);
+				wxFileName file = wxString::Format("%s-%s-%s.%s", std::to_string(h), std::to_string(w), std::to_string(z), extension);
+				file.Normalize(wxPATH_NORM_DOTS | wxPATH_NORM_TILDE | wxPATH_NORM_CASE | wxPATH_NORM_ABSOLUTE, directory);
+				image.SaveFile(file.GetFullPath(), type);
+			}
+		}));
+
+		if (pending.size() >= window) {
+			pending.front().get();
+			pending.pop_front();
+			if (m_updateLoadbar) {
+				g_gui.SetLoadDone(static_cast<int>(++done * 100 / images.size()));
+			}
 		}
-		totalTiles++;
+	}
+	while (!pending.empty()) {
+		pending.front().get();
+		pending.pop_front();
 	}
 
-	int pixels_size = m_imageSize * m_imageSize * rme::PixelFormatRGB;
-	uint8_t* pixels = new uint8_t[pixels_size];
-	auto image = new wxImage(m_imageSize, m_imageSize, pixels, true);
+	g_gui.DestroyLoadBar();
+	return true;
+}
+
+bool IOMinimap::exportTiles(const std::string &directory, const std::string &name) {
+	auto &map = m_editor->getMap();
+	if (map.size() == 0 || (m_mode == MinimapExportMode::SelectedArea && !m_editor->hasSelection())) {
+		return true;
+	}
 
-	int processedTiles = 0;
-	int lastShownProgress = -1;
-	for (size_t z = min_z; z <= max_z; z++) {
-		auto &rect = bounds[z];
-		if (rect.IsEmpty()) {
+	std::unordered_map<uint32_t, QTreeNode*> columns;
+	std::array<std::unordered_set<uint32_t>, rme::MapLayers> occupied;
+	uint32_t floors = 0;
+	map.forEachTileAreaColumn([&](int x, int y, QTreeNode &column) {
+		const int column_x = x / PyramidTileSize;
+		const int column_y = y / PyramidTileSize;
+		columns.emplace((column_y << 8) | column_x, &column);
+
+		uint32_t column_floors = 0;
+		column.forEachLeaf([&column_floors](QTreeNode &leaf) {
+			for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+				if (leaf.getOccupancy(z)) {
+					column_floors |= 1u << z;
+				}
+			}
+		});
+		floors |= column_floors;
+
+		// Mark the column and its ancestors, empty subtrees are skipped without being rendered
+		for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+			if (column_floors & (1u << z)) {
+				for (int zoom = PyramidMaxZoom; zoom >= 0; --zoom) {
+					const int shift = PyramidMaxZoom - zoom;
+					if (!occupied[z].insert(getPyramidKey(zoom, column_x >> shift, column_y >> shift)).second) {
+						break;
+					}
+				}
+			}
+		}
+	});
+
+	const int min_z = m_floor == -1 ? 0 : m_floor;
+	const int max_z = m_floor == -1 ? rme::MapMaxLayer : m_floor;
+	const std::filesystem::path root = std::filesystem::path(directory) / name;
+
+	// Queue the subtrees of every floor first, so all floors render at once. The pool goes first on
+	// the way out, its jobs point into pyramids.
+	std::vector<std::unique_ptr<PyramidFloor>> pyramids;
+	ThreadPool pool;
+	for (int z = min_z; z <= max_z; ++z) {
+		if ((floors & (1u << z)) == 0) {
 			continue;
 		}
 
-		for (int h = 0; h < rme::MapMaxHeight; h += m_imageSize) {
-			for (int w = 0; w < rme::MapMaxWidth; w += m_imageSize) {
-				if (w < rect.x || w > rect.width || h < rect.y || h > rect.height) {
+		auto &floor = pyramids.emplace_back(std::make_unique<PyramidFloor>());
+		floor->z = z;
+		floor->directory = root / std::to_string(z);
+		floor->columns = &columns;
+		floor->occupied = std::move(occupied[z]);
+
+		constexpr int split_tiles = 1 << PyramidSplitZoom;
+		for (int y = 0; y < split_tiles; ++y) {
+			for (int x = 0; x < split_tiles; ++x) {
+				if (floor->occupied.count(getPyramidKey(PyramidSplitZoom, x, y)) == 0) {
 					continue;
 				}
 
-				bool empty = true;
-				memset(pixels, 0, pixels_size);
+				PyramidFloor* pyramid = floor.get();
+				floor->jobs.emplace((y << 8) | x, pool.enqueue([this, pyramid, x, y]() {
+					std::vector<uint8_t> pixels;
+					if (!renderPyramidTile(*pyramid, PyramidSplitZoom, x, y, pixels, false)) {
+						pixels.clear();
+					}
+					return pixels;
+				}));
+			}
+		}
+	}
 
-				int index = 0;
-				for (int y = 0; y < m_imageSize; y++) {
-					for (int x = 0; x < m_imageSize; x++) {
-						auto tile = map.getTile(w + x, h + y, z);
-						if (!tile || (!tile->ground && tile->items.empty())) {
-							index += rme::PixelFormatRGB;
-							continue;
-						}
+	// The top levels are built from the finished subtrees, floor by floor
+	std::vector<uint8_t> pixels;
+	for (size_t i = 0; i < pyramids.size(); ++i) {
+		renderPyramidTile(*pyramids[i], 0, 0, 0, pixels, true);
+		pyramids[i].reset();
+		if (m_updateLoadbar) {
+			g_gui.SetLoadDone(static_cast<int>((i + 1) * 100 / pyramids.size()));
+		}
+	}
+	return true;
+}
 
-						processedTiles++;
-						int progress = static_cast<int>((static_cast<double>(processedTiles) / totalTiles) * 100);
-						if (progress > lastShownProgress) {
-							if (m_updateLoadbar) {
-								g_gui.SetLoadDone(progress);
-							}
-							lastShownProgress = progress;
-						}
+bool IOMinimap::renderPyramidTile(PyramidFloor &floor, int zoom, int x, int y, std::vector<uint8_t> &pixels, bool use_jobs) const {
+	if (floor.occupied.count(getPyramidKey(zoom, x, y)) == 0) {
+		return false;
+	}
 
-						uint8_t color = tile->getMiniMapColor();
-						pixels[index] = (uint8_t)(static_cast<int>(color / 36) % 6 * 51); // red
-						pixels[index + 1] = (uint8_t)(static_cast<int>(color / 6) % 6 * 51); // green
-						pixels[index + 2] = (uint8_t)(color % 6 * 51); // blue
-						index += rme::PixelFormatRGB;
-						empty = false;
-					}
-				}
+	if (use_jobs && zoom == PyramidSplitZoom) {
+		const auto it = floor.jobs.find((y << 8) | x);
+		if (it != floor.jobs.end()) {
+			pixels = it->second.get();
+			return !pixels.empty();
+		}
+	}
 
-				if (!empty) {
-					image->SetData(pixels, true);
-					wxString extension = m_format == MinimapExportFormat::Png ? "png" : "bmp";
-					wxBitmapType type = m_format == MinimapExportFormat::Png ? wxBITMAP_TYPE_PNG : wxBITMAP_TYPE_BMP;
-					wxString extension_wx = wxString::FromAscii(extension.mb_str());
-					wxFileName file = wxString::Format("%s-%s-%s.%s", std::to_string(h), std::to_string(w), std::to_string(z), extension_wx);
-					file.Normalize(wxPATH_NORM_DOTS | wxPATH_NORM_TILDE | wxPATH_NORM_CASE | wxPATH_NORM_ABSOLUTE, directory);
-					image->SaveFile(file.GetFullPath(), type);
+	bool empty = true;
+	if (zoom == PyramidMaxZoom) {
+		const auto it = floor.columns->find((y << 8) | x);
+		if (it == floor.columns->end()) {
+			return false;
+		}
+
+		pixels.assign(PyramidTileBytes, 0);
+		it->second->forEachLeaf([&](QTreeNode &leaf) {
+			leaf.forEachTile(floor.z, [&](TileLocation &location) {
+				const Tile* tile = location.get();
+				if (!includesTile(tile)) {
+					return;
+				}
+				const Position &position = location.getPosition();
+				setMinimapPixel(&pixels[((position.y % PyramidTileSize) * PyramidTileSize + position.x % PyramidTileSize) * rme::PixelFormatRGB], tile->getMiniMapColor());
+				empty = false;
+			});
+		});
+	} else {
+		std::vector<uint8_t> child;
+		for (int quadrant = 0; quadrant < 4; ++quadrant) {
+			if (renderPyramidTile(floor, zoom + 1, x * 2 + (quadrant & 1), y * 2 + (quadrant >> 1), child, use_jobs)) {
+				if (empty) {
+					pixels.assign(PyramidTileBytes, 0);
+					empty = false;
 				}
+				downsampleQuadrant(child, pixels, quadrant);
 			}
 		}
 	}
 
-	g_gui.DestroyLoadBar();
-	image->Destroy();
-	delete[] pixels;
+	if (empty) {
+		return false;
+	}
+	writePyramidTile(floor, zoom, x, y, pixels);
 	return true;
 }
 
+void IOMinimap::writePyramidTile(const PyramidFloor &floor, int zoom, int x, int y, const std::vector<uint8_t> &pixels) const {
+	const std::filesystem::path directory = floor.directory / std::to_string(zoom) / std::to_string(x);
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	// wxImage only borrows the buffer with static data, it is never written through
+	wxImage image(PyramidTileSize, PyramidTileSize, const_cast<uint8_t*>(pixels.data()), true);
+	image.SaveFile(wxString((directory / (std::to_string(y) + ".png")).native()), wxBITMAP_TYPE_PNG);
+}
+
 bool IOMinimap::exportSelection(const std::string &directory, const std::string &name) {
 	int min_x = rme::MapMaxWidth + 1;
 	int min_y = rme::MapMaxHeight + 1;
@@ -352,58 +556,71 @@ bool IOMinimap::exportSelection(const std::string &directory, const std::string
 	return true;
 }
 
-void IOMinimap::readBlocks() {
-	if (m_mode == MinimapExportMode::SelectedArea && !m_editor->hasSelection()) {
-		return;
+bool IOMinimap::includesTile(const Tile* tile) const {
+	if (!tile || (!tile->ground && tile->items.empty())) {
+		return false;
 	}
+	if (m_mode == MinimapExportMode::SelectedArea) {
+		return tile->isSelected();
+	}
+	return m_floor == -1 || tile->getZ() == m_floor;
+}
 
-	auto &map = m_editor->getMap();
-
-	int tiles_iterated = 0;
-	for (auto it = map.begin(); it != map.end(); ++it) {
-		auto tile = (*it)->get();
-
-		if (m_updateLoadbar) {
-			++tiles_iterated;
-			if (tiles_iterated % 8192 == 0) {
-				g_gui.SetLoadDone(int(tiles_iterated / double(map.size()) * 90.0));
-			}
-		}
+std::vector<IOMinimap::EncodedBlock> IOMinimap::encodeColumn(QTreeNode &column, int column_x, int column_y) const {
+	// A 256x256 column holds 4x4 blocks on each floor
+	constexpr int BlocksPerSide = 256 / MMBLOCK_SIZE;
+	std::vector<std::unique_ptr<MinimapBlock>> blocks(rme::MapLayers * BlocksPerSide * BlocksPerSide);
+
+	column.forEachLeaf([&](QTreeNode &leaf) {
+		for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+			leaf.forEachTile(z, [&](TileLocation &location) {
+				const Tile* tile = location.get();
+				if (!includesTile(tile)) {
+					return;
+				}
 
-		if (!tile || (!tile->ground && tile->items.empty())) {
-			continue;
+				MinimapTile minimapTile;
+				minimapTile.color = tile->getMiniMapColor();
+				minimapTile.flags |= MinimapTileWasSeen;
+				if (tile->isBlocking()) {
+					minimapTile.flags |= MinimapTileNotWalkable;
+				}
+				// if (!tile->isPathable()) {
+				// minimapTile.flags |= MinimapTileNotPathable;
+				//}
+				minimapTile.speed = std::min<int>((int)std::ceil(tile->getGroundSpeed() / 10.f), 0xFF);
+
+				const Position &position = location.getPosition();
+				const int local_x = (position.x - column_x) / MMBLOCK_SIZE;
+				const int local_y = (position.y - column_y) / MMBLOCK_SIZE;
+				auto &block = blocks[(z * BlocksPerSide + local_y) * BlocksPerSide + local_x];
+				if (!block) {
+					block = std::make_unique<MinimapBlock>();
+				}
+				block->updateTile(position.x, position.y, minimapTile);
+			});
 		}
+	});
 
-		const auto &position = tile->getPosition();
+	constexpr unsigned long blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
+	constexpr int COMPRESS_LEVEL = 3;
 
-		if (m_mode == MinimapExportMode::SelectedArea) {
-			if (!tile->isSelected()) {
-				continue;
-			}
-		} else if (m_floor != -1 && position.z != m_floor) {
+	std::vector<EncodedBlock> encoded;
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		if (!blocks[i]) {
 			continue;
 		}
 
-		MinimapTile minimapTile;
-		minimapTile.color = tile->getMiniMapColor();
-		minimapTile.flags |= MinimapTileWasSeen;
-		if (tile->isBlocking()) {
-			minimapTile.flags |= MinimapTileNotWalkable;
-		}
-		// if (!tile->isPathable()) {
-		// minimapTile.flags |= MinimapTileNotPathable;
-		//}
-		minimapTile.speed = std::min<int>((int)std::ceil(tile->getGroundSpeed() / 10.f), 0xFF);
-
-		auto &blocks = m_blocks[position.z];
-		uint32_t index = getBlockIndex(position);
-		if (blocks.find(index) == blocks.end()) {
-			blocks.insert({ index, MinimapBlock() });
-		}
+		EncodedBlock &block = encoded.emplace_back();
+		block.x = static_cast<uint16_t>(column_x + (i % BlocksPerSide) * MMBLOCK_SIZE);
+		block.y = static_cast<uint16_t>(column_y + (i / BlocksPerSide % BlocksPerSide) * MMBLOCK_SIZE);
+		block.z = static_cast<uint8_t>(i / (BlocksPerSide * BlocksPerSide));
 
-		auto &block = blocks.at(index);
-		int offset_x = position.x - (position.x % MMBLOCK_SIZE);
-		int offset_y = position.y - (position.y % MMBLOCK_SIZE);
-		block.updateTile(position.x - offset_x, position.y - offset_y, minimapTile);
+		unsigned long len = compressBound(blockSize);
+		block.data.resize(len);
+		int ret = compress2(block.data.data(), &len, (const uint8_t*)&blocks[i]->getTiles(), blockSize, COMPRESS_LEVEL);
+		assert(ret == Z_OK);
+		block.data.resize(len);
 	}
+	return encoded;
 }
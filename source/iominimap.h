@@ -23,7 +23,8 @@
 enum class MinimapExportFormat {
 	Otmm,
 	Png,
-	Bmp
+	Bmp,
+	PngTiles // 256x256 PNG tiles in a zoom/x/y pyramid per floor
 };
 
 enum class MinimapExportMode {
@@ -85,10 +86,25 @@ private:
 	bool saveImage(const std::string &directory, const std::string &name);
 	bool exportMinimap(const std::string &directory);
 	bool exportSelection(const std::string &directory, const std::string &name);
-	void readBlocks();
-	inline uint32_t getBlockIndex(const Position &pos) {
-		return ((pos.y / MMBLOCK_SIZE) * (65536 / MMBLOCK_SIZE)) + (pos.x / MMBLOCK_SIZE);
-	}
+
+	struct EncodedBlock {
+		uint16_t x;
+		uint16_t y;
+		uint8_t z;
+		std::vector<uint8_t> data; // Deflated MinimapBlock tiles
+	};
+
+	struct PyramidFloor;
+	bool exportTiles(const std::string &directory, const std::string &name);
+	// Fills pixels with the pyramid tile and writes it, along with everything below it down to the
+	// native zoom. Returns false when the tile is empty (and wasn't written). With use_jobs, split
+	// zoom tiles are taken from the floor's pool jobs instead of being rendered.
+	bool renderPyramidTile(PyramidFloor &floor, int zoom, int x, int y, std::vector<uint8_t> &pixels, bool use_jobs) const;
+	void writePyramidTile(const PyramidFloor &floor, int zoom, int x, int y, const std::vector<uint8_t> &pixels) const;
+
+	bool includesTile(const Tile* tile) const;
+	// Builds and deflates the blocks of one 256x256 tile area column, only reads the map
+	std::vector<EncodedBlock> encodeColumn(QTreeNode &column, int column_x, int column_y) const;
 
 	Editor* m_editor;
 	MinimapExportFormat m_format;
@@ -96,7 +112,6 @@ private:
 	bool m_updateLoadbar = false;
 	int m_floor = -1;
 	int m_imageSize = 1024;
-	std::unordered_map<uint32_t, MinimapBlock> m_blocks[rme::MapLayers];
 	std::string m_error;
 };
 
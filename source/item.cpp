@@ -85,7 +85,7 @@ Item* Item::deepCopy() const {
 	if (copy) {
 		copy->selected = selected;
 		if (attributes) {
-			copy->attributes = newd ItemAttributeMap(*attributes);
+			copy->attributes = newd ItemAttributeStore(*attributes);
 		}
 	}
 	return copy;
@@ -236,11 +236,7 @@ wxPoint Item::getDrawOffset() const {
 }
 
 uint16_t Item::getGroundSpeed() const {
-	const auto &type = g_items.getItemType(id);
-	if (type.sprite) {
-		return type.sprite->ground_speed;
-	}
-	return 0;
+	return g_items.getGroundSpeed(id);
 }
 
 bool Item::hasLight() const {
@@ -300,11 +296,7 @@ bool Item::canHoldDescription() const {
 }
 
 uint8_t Item::getMiniMapColor() const {
-	GameSprite* sprite = g_items.getItemType(id).sprite;
-	if (sprite) {
-		return sprite->getMiniMapColor();
-	}
-	return 0;
+	return g_items.getMiniMapColor(id);
 }
 
 GroundBrush* Item::getGroundBrush() const {
@@ -223,7 +223,7 @@ public:
 		return getItemType().blockPathfinder;
 	}
 	bool isBlocking() const {
-		return getItemType().unpassable;
+		return g_items.hasHotFlag(id, ItemDatabase::HOT_UNPASSABLE);
 	}
 	bool isStackable() const {
 		return getItemType().stackable;
@@ -244,7 +244,7 @@ public:
 		return getItemType().alwaysOnBottom;
 	}
 	int getTopOrder() const {
-		return getItemType().alwaysOnTopOrder;
+		return g_items.getTopOrder(id);
 	}
 	bool isGroundTile() const {
 		return getItemType().isGroundTile();
@@ -276,7 +276,7 @@ public:
 		return getItemType().charges != 0;
 	}
 	bool isBorder() const {
-		return getItemType().isBorder;
+		return g_items.hasHotFlag(id, ItemDatabase::HOT_BORDER);
 	}
 	bool isOptionalBorder() const {
 		return getItemType().isOptionalBorder;
@@ -294,10 +294,10 @@ public:
 		return getItemType().isBrushDoor;
 	}
 	bool isTable() const {
-		return getItemType().isTable;
+		return g_items.hasHotFlag(id, ItemDatabase::HOT_TABLE);
 	}
 	bool isCarpet() const {
-		return getItemType().isCarpet;
+		return g_items.hasHotFlag(id, ItemDatabase::HOT_CARPET);
 	}
 	bool isMetaItem() const {
 		return getItemType().isMetaItem();
@@ -338,7 +338,7 @@ public:
 
 	// Item properties!
 	virtual bool isComplex() const {
-		return attributes && attributes->size();
+		return attributes && !attributes->empty();
 	} // If this item requires full save (not compact)
 
 	// Weight
@@ -402,7 +402,7 @@ inline int Item::getCount() const {
 }
 
 inline uint16_t Item::getUniqueID() const {
-	const int32_t* a = getIntegerAttribute("uid");
+	const int32_t* a = getIntegerAttribute(ItemAttributeStore::SLOT_UNIQUE_ID);
 	if (a) {
 		return *a;
 	}
@@ -410,7 +410,7 @@ inline uint16_t Item::getUniqueID() const {
 }
 
 inline uint16_t Item::getActionID() const {
-	const int32_t* a = getIntegerAttribute("aid");
+	const int32_t* a = getIntegerAttribute(ItemAttributeStore::SLOT_ACTION_ID);
 	if (a) {
 		return *a;
 	}
@@ -418,7 +418,7 @@ inline uint16_t Item::getActionID() const {
 }
 
 inline std::string Item::getText() const {
-	const std::string* a = getStringAttribute("text");
+	const std::string* a = getStringAttribute(ItemAttributeStore::SLOT_TEXT);
 	if (a) {
 		return *a;
 	}
@@ -426,7 +426,7 @@ inline std::string Item::getText() const {
 }
 
 inline std::string Item::getDescription() const {
-	const std::string* a = getStringAttribute("desc");
+	const std::string* a = getStringAttribute(ItemAttributeStore::SLOT_DESCRIPTION);
 	if (a) {
 		return *a;
 	}
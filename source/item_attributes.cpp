@@ -20,14 +20,18 @@
 #include "item_attributes.h"
 #include "filehandle.h"
 
+#include <deque>
+#include <shared_mutex>
+
 ItemAttributes::ItemAttributes() :
 	attributes(nullptr) {
 	////
 }
 
-ItemAttributes::ItemAttributes(const ItemAttributes &o) {
+ItemAttributes::ItemAttributes(const ItemAttributes &o) :
+	attributes(nullptr) {
 	if (o.attributes) {
-		attributes = newd ItemAttributeMap(*o.attributes);
+		attributes = newd ItemAttributeStore(*o.attributes);
 	}
 }
 
@@ -37,7 +41,7 @@ ItemAttributes::~ItemAttributes() {
 
 void ItemAttributes::createAttributes() {
 	if (!attributes) {
-		attributes = newd ItemAttributeMap;
+		attributes = newd ItemAttributeStore;
 	}
 }
 
@@ -50,94 +54,77 @@ void ItemAttributes::clearAllAttributes() {
 
 ItemAttributeMap ItemAttributes::getAttributes() const {
 	if (attributes) {
-		return *attributes;
+		return attributes->toMap();
 	}
 	return ItemAttributeMap();
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const ItemAttribute &value) {
 	createAttributes();
-	(*attributes)[key] = value;
+	attributes->set(ItemAttributeStore::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const std::string &value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	attributes->set(ItemAttributeStore::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, int32_t value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	attributes->set(ItemAttributeStore::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, double value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	attributes->set(ItemAttributeStore::intern(key), ItemAttribute(value));
 }
 
 void ItemAttributes::setAttribute(const std::string &key, bool value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	ItemAttribute attribute;
+	attribute.set(value);
+	attributes->set(ItemAttributeStore::intern(key), attribute);
 }
 
 void ItemAttributes::eraseAttribute(const std::string &key) {
-	if (!attributes) {
-		return;
-	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-
-	if (iter != attributes->end()) {
-		attributes->erase(iter);
+	ItemAttributeKey id;
+	if (attributes && ItemAttributeStore::find(key, id)) {
+		attributes->erase(id);
 	}
 }
 
 const std::string* ItemAttributes::getStringAttribute(const std::string &key) const {
-	if (!attributes) {
+	ItemAttributeKey id;
+	if (!attributes || !ItemAttributeStore::find(key, id)) {
 		return nullptr;
 	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getString();
-	}
-	return nullptr;
+	return attributes->getString(id);
 }
 
 const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const {
-	if (!attributes) {
+	ItemAttributeKey id;
+	if (!attributes || !ItemAttributeStore::find(key, id)) {
 		return nullptr;
 	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getInteger();
-	}
-	return nullptr;
+	return attributes->getInteger(id);
 }
 
 const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
-	if (!attributes) {
+	ItemAttributeKey id;
+	if (!attributes || !ItemAttributeStore::find(key, id)) {
 		return nullptr;
 	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getFloat();
-	}
-	return nullptr;
+	const ItemAttribute* attribute = attributes->getExtra(id);
+	return attribute ? attribute->getFloat() : nullptr;
 }
 
 const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
-	if (!attributes) {
+	ItemAttributeKey id;
+	if (!attributes || !ItemAttributeStore::find(key, id)) {
 		return nullptr;
 	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getBoolean();
-	}
-	return nullptr;
+	const ItemAttribute* attribute = attributes->getExtra(id);
+	return attribute ? attribute->getBoolean() : nullptr;
 }
 
 bool ItemAttributes::hasStringAttribute(const std::string &key) const {
@@ -156,6 +143,199 @@ bool ItemAttributes::hasBooleanAttribute(const std::string &key) const {
 	return getBooleanAttribute(key) != nullptr;
 }
 
+// Attribute store
+// Keys are interned once for the whole program, names are never released
+
+namespace {
+	struct AttributeKeyTable {
+		AttributeKeyTable() {
+			// Must match the order of ItemAttributeStore::Slot
+			for (const char* name : { "aid", "uid", "subtype", "text", "desc" }) {
+				ids.emplace(name, static_cast<ItemAttributeKey>(names.size()));
+				names.emplace_back(name);
+			}
+		}
+
+		std::shared_mutex mutex;
+		std::deque<std::string> names;
+		std::unordered_map<std::string, ItemAttributeKey> ids;
+	};
+
+	AttributeKeyTable &getAttributeKeyTable() {
+		static AttributeKeyTable table;
+		return table;
+	}
+}
+
+ItemAttributeKey ItemAttributeStore::intern(const std::string &name) {
+	AttributeKeyTable &table = getAttributeKeyTable();
+	{
+		std::shared_lock lock(table.mutex);
+		const auto it = table.ids.find(name);
+		if (it != table.ids.end()) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock lock(table.mutex);
+	const auto [it, inserted] = table.ids.emplace(name, static_cast<ItemAttributeKey>(table.names.size()));
+	if (inserted) {
+		ASSERT(table.names.size() < 0xFFFF);
+		table.names.push_back(name);
+	}
+	return it->second;
+}
+
+bool ItemAttributeStore::find(const std::string &name, ItemAttributeKey &key) {
+	AttributeKeyTable &table = getAttributeKeyTable();
+	std::shared_lock lock(table.mutex);
+	const auto it = table.ids.find(name);
+	if (it == table.ids.end()) {
+		return false;
+	}
+	key = it->second;
+	return true;
+}
+
+const std::string &ItemAttributeStore::getName(ItemAttributeKey key) {
+	AttributeKeyTable &table = getAttributeKeyTable();
+	std::shared_lock lock(table.mutex);
+	return table.names[key];
+}
+
+void ItemAttributeStore::set(ItemAttributeKey key, const ItemAttribute &value) {
+	if (const int32_t* integer = value.getInteger(); integer && isIntegerSlot(key)) {
+		set(key, *integer);
+	} else if (const std::string* string = value.getString(); string && isStringSlot(key)) {
+		set(key, *string);
+	} else {
+		erase(key);
+		extra.emplace_back(key, value);
+	}
+}
+
+void ItemAttributeStore::set(ItemAttributeKey key, int32_t value) {
+	erase(key);
+	if (isIntegerSlot(key)) {
+		integers[key] = value;
+		present |= 1 << key;
+	} else {
+		extra.emplace_back(key, ItemAttribute(value));
+	}
+}
+
+void ItemAttributeStore::set(ItemAttributeKey key, const std::string &value) {
+	erase(key);
+	if (isStringSlot(key)) {
+		strings[key - SLOT_TEXT] = value;
+		present |= 1 << key;
+	} else {
+		extra.emplace_back(key, ItemAttribute(value));
+	}
+}
+
+void ItemAttributeStore::erase(ItemAttributeKey key) {
+	if (key < SLOT_COUNT && (present & (1 << key))) {
+		present &= ~(1 << key);
+		if (isStringSlot(key)) {
+			strings[key - SLOT_TEXT].clear();
+			strings[key - SLOT_TEXT].shrink_to_fit();
+		}
+		return;
+	}
+
+	for (auto it = extra.begin(); it != extra.end(); ++it) {
+		if (it->first == key) {
+			extra.erase(it);
+			return;
+		}
+	}
+}
+
+const int32_t* ItemAttributeStore::getInteger(ItemAttributeKey key) const {
+	if (isIntegerSlot(key) && (present & (1 << key))) {
+		return &integers[key];
+	}
+	const ItemAttribute* attribute = getExtra(key);
+	return attribute ? attribute->getInteger() : nullptr;
+}
+
+const std::string* ItemAttributeStore::getString(ItemAttributeKey key) const {
+	if (isStringSlot(key) && (present & (1 << key))) {
+		return &strings[key - SLOT_TEXT];
+	}
+	const ItemAttribute* attribute = getExtra(key);
+	return attribute ? attribute->getString() : nullptr;
+}
+
+const ItemAttribute* ItemAttributeStore::getExtra(ItemAttributeKey key) const {
+	for (const auto &entry : extra) {
+		if (entry.first == key) {
+			return &entry.second;
+		}
+	}
+	return nullptr;
+}
+
+ItemAttributeMap ItemAttributeStore::toMap() const {
+	ItemAttributeMap map;
+	for (ItemAttributeKey key = 0; key < SLOT_COUNT; ++key) {
+		if (present & (1 << key)) {
+			if (isIntegerSlot(key)) {
+				map.emplace(getName(key), ItemAttribute(integers[key]));
+			} else {
+				map.emplace(getName(key), ItemAttribute(strings[key - SLOT_TEXT]));
+			}
+		}
+	}
+	for (const auto &[key, value] : extra) {
+		map.emplace(getName(key), value);
+	}
+	return map;
+}
+
+void ItemAttributeStore::serialize(const IOMap &maphandle, NodeFileWriteHandle &f) const {
+	// Slots are referenced by key, list entries by SLOT_COUNT + index
+	struct Entry {
+		const std::string* name;
+		size_t index;
+	};
+	std::vector<Entry> entries;
+	entries.reserve(size());
+	for (ItemAttributeKey key = 0; key < SLOT_COUNT; ++key) {
+		if (present & (1 << key)) {
+			entries.push_back({ &getName(key), key });
+		}
+	}
+	for (size_t i = 0; i < extra.size(); ++i) {
+		entries.push_back({ &getName(extra[i].first), SLOT_COUNT + i });
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return *a.name < *b.name; });
+
+	// Maximum of 65535 attributes per item
+	const size_t count = std::min((size_t)0xFFFF, entries.size());
+	f.addU16(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		const Entry &entry = entries[i];
+		if (entry.name->size() > 0xFFFF) {
+			f.addString(entry.name->substr(0, 65535));
+		} else {
+			f.addString(*entry.name);
+		}
+
+		if (entry.index >= SLOT_COUNT) {
+			extra[entry.index - SLOT_COUNT].second.serialize(maphandle, f);
+		} else if (isIntegerSlot(static_cast<ItemAttributeKey>(entry.index))) {
+			f.addU8(ItemAttribute::INTEGER);
+			f.addU32(static_cast<uint32_t>(integers[entry.index]));
+		} else {
+			f.addU8(ItemAttribute::STRING);
+			f.addLongString(strings[entry.index - SLOT_TEXT]);
+		}
+	}
+}
+
 // Attribute type
 // Can hold either int, bool or std::string
 // Without using newd to allocate them
@@ -291,29 +471,14 @@ bool ItemAttributes::unserializeAttributeMap(const IOMap &maphandle, BinaryNode*
 			if (!attrib.unserialize(maphandle, stream)) {
 				return false;
 			}
-			(*attributes)[key] = attrib;
+			attributes->set(ItemAttributeStore::intern(key), attrib);
 		}
 	}
 	return true;
 }
 
 void ItemAttributes::serializeAttributeMap(const IOMap &maphandle, NodeFileWriteHandle &f) const {
-	// Maximum of 65535 attributes per item
-	f.addU16(std::min((size_t)0xFFFF, attributes->size()));
-
-	ItemAttributeMap::const_iterator attribute = attributes->begin();
-	int i = 0;
-	while (attribute != attributes->end() && i <= 0xFFFF) {
-		const std::string &key = attribute->first;
-		if (key.size() > 0xFFFF) {
-			f.addString(key.substr(0, 65535));
-		} else {
-			f.addString(key);
-		}
-
-		attribute->second.serialize(maphandle, f);
-		++attribute, ++i;
-	}
+	attributes->serialize(maphandle, f);
 }
 
 bool ItemAttribute::unserialize(const IOMap &maphandle, BinaryNode* stream) {
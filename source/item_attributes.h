@@ -20,6 +20,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <bit>
 
 #include "filehandle.h"
 
@@ -70,6 +72,65 @@ private:
 
 typedef std::map<std::string, ItemAttribute> ItemAttributeMap;
 
+// Attribute keys are interned, items only store the key id
+typedef uint16_t ItemAttributeKey;
+
+// Compact storage for the attributes of one item. Integer aid/uid/subtype and string
+// text/desc values have fixed slots; any other key, or a slot key holding another type,
+// goes to a small list. Replaces a std::map node per key.
+class ItemAttributeStore {
+public:
+	// The well known keys, interned at these ids before anything else
+	enum Slot : ItemAttributeKey {
+		SLOT_ACTION_ID,
+		SLOT_UNIQUE_ID,
+		SLOT_SUBTYPE,
+		SLOT_TEXT,
+		SLOT_DESCRIPTION,
+		SLOT_COUNT
+	};
+
+	// Thread safe, tile areas are decoded on worker threads
+	static ItemAttributeKey intern(const std::string &name);
+	// Returns false if the name was never used as a key, in which case no item has it
+	static bool find(const std::string &name, ItemAttributeKey &key);
+	static const std::string &getName(ItemAttributeKey key);
+
+	bool empty() const noexcept {
+		return present == 0 && extra.empty();
+	}
+	size_t size() const noexcept {
+		return std::popcount(present) + extra.size();
+	}
+
+	void set(ItemAttributeKey key, const ItemAttribute &value);
+	void set(ItemAttributeKey key, int32_t value);
+	void set(ItemAttributeKey key, const std::string &value);
+	void erase(ItemAttributeKey key);
+
+	const int32_t* getInteger(ItemAttributeKey key) const;
+	const std::string* getString(ItemAttributeKey key) const;
+	// Only looks at the list, slot values aren't stored as ItemAttribute
+	const ItemAttribute* getExtra(ItemAttributeKey key) const;
+
+	ItemAttributeMap toMap() const;
+	// Same layout as the attribute map always had, keys in std::map order
+	void serialize(const IOMap &maphandle, NodeFileWriteHandle &f) const;
+
+private:
+	static constexpr bool isIntegerSlot(ItemAttributeKey key) noexcept {
+		return key <= SLOT_SUBTYPE;
+	}
+	static constexpr bool isStringSlot(ItemAttributeKey key) noexcept {
+		return key == SLOT_TEXT || key == SLOT_DESCRIPTION;
+	}
+
+	uint8_t present = 0; // Bit per slot
+	int32_t integers[SLOT_SUBTYPE + 1] = {};
+	std::string strings[2];
+	std::vector<std::pair<ItemAttributeKey, ItemAttribute>> extra;
+};
+
 class ItemAttributes {
 public:
 	ItemAttributes();
@@ -93,6 +154,14 @@ public:
 	const double* getFloatAttribute(const std::string &key) const;
 	const bool* getBooleanAttribute(const std::string &key) const;
 
+	// Same, without looking up the key name
+	const std::string* getStringAttribute(ItemAttributeKey key) const {
+		return attributes ? attributes->getString(key) : nullptr;
+	}
+	const int32_t* getIntegerAttribute(ItemAttributeKey key) const {
+		return attributes ? attributes->getInteger(key) : nullptr;
+	}
+
 	// Returns true if the attribute (of that type) exists
 	bool hasStringAttribute(const std::string &key) const;
 	bool hasIntegerAttribute(const std::string &key) const;
@@ -103,9 +172,12 @@ public:
 
 	void clearAllAttributes();
 	ItemAttributeMap getAttributes() const;
+	bool hasAttributes() const noexcept {
+		return attributes != nullptr;
+	}
 
 protected:
-	ItemAttributeMap* attributes;
+	ItemAttributeStore* attributes;
 
 	void createAttributes();
 };
@@ -26,6 +26,8 @@
 
 #include <appearances.pb.h>
 
+#include <chrono>
+
 ItemDatabase g_items;
 
 bool ItemType::isFloorChange() const noexcept {
@@ -46,6 +48,8 @@ ItemType &ItemDatabase::operator[](uint16_t id) {
 }
 
 void ItemDatabase::clear() {
+	frozen_types.clear();
+	hot = HotTable();
 	for (size_t i = 0; i < items.size(); i++) {
 		items[i].reset();
 		items.set(i, nullptr);
@@ -740,7 +744,10 @@ bool ItemDatabase::loadFromGameXml(const FileName &identifier, wxString &error,
 		error = "Could not load items.xml (Syntax error?)";
 		return false;
 	}
+	return loadFromGameXml(doc, error, warnings);
+}
 
+bool ItemDatabase::loadFromGameXml(const pugi::xml_document &doc, wxString &error, wxArrayString &warnings) {
 	const auto node = doc.child("items");
 	if (!node) {
 		error = "items.xml, invalid root node.";
@@ -793,7 +800,7 @@ bool ItemDatabase::loadMetaItem(pugi::xml_node node) {
 	return false;
 }
 
-ItemType &ItemDatabase::getItemType(uint16_t id) {
+ItemType &ItemDatabase::lookupItemType(uint16_t id) {
 	if (id == 0 || id > maxItemId) {
 		return dummy;
 	}
@@ -813,6 +820,94 @@ std::shared_ptr<ItemType> ItemDatabase::getRawItemType(uint16_t id) {
 	return items[id];
 }
 
+void ItemDatabase::freeze() {
+	frozen_types.clear();
+	hot = HotTable();
+
+	const size_t count = size_t(maxItemId) + 1;
+	std::vector<ItemType*> types(count, &dummy);
+	hot.flags.resize(count);
+	hot.minimap_color.resize(count);
+	hot.ground_speed.resize(count);
+	hot.top_order.resize(count);
+	for (size_t id = 1; id < count; ++id) {
+		const std::shared_ptr<ItemType> &type = items[id];
+		if (!type) {
+			continue;
+		}
+		types[id] = type.get();
+		hot.flags[id] = getHotFlags(*type);
+		if (type->sprite) {
+			hot.minimap_color[id] = static_cast<uint8_t>(getSpriteMiniMapColor(type->sprite));
+			hot.ground_speed[id] = getSpriteGroundSpeed(type->sprite);
+		}
+		hot.top_order[id] = static_cast<uint8_t>(type->alwaysOnTopOrder);
+	}
+	frozen_types = std::move(types);
+}
+
+wxString ItemDatabase::benchmarkLookups() {
+	if (!isFrozen()) {
+		return "The item types are not loaded.";
+	}
+
+	// Time a few passes over every id through the shared_ptr path and the flat table
+	constexpr int passes = 8;
+	const size_t count = frozen_types.size();
+	// Volatile so the loops aren't optimized away
+	volatile uint64_t sink = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; ++pass) {
+		for (size_t id = 1; id < count; ++id) {
+			sink = sink + lookupItemType(static_cast<uint16_t>(id)).alwaysOnTopOrder;
+		}
+	}
+	const auto shared_done = std::chrono::steady_clock::now();
+
+	for (int pass = 0; pass < passes; ++pass) {
+		for (size_t id = 1; id < count; ++id) {
+			sink = sink + getItemType(static_cast<uint16_t>(id)).alwaysOnTopOrder;
+		}
+	}
+	const auto flat_done = std::chrono::steady_clock::now();
+
+	using std::chrono::microseconds;
+	using std::chrono::duration_cast;
+	const auto shared_us = duration_cast<microseconds>(shared_done - start).count();
+	const auto flat_us = duration_cast<microseconds>(flat_done - shared_done).count();
+	spdlog::info("Item lookup benchmark: {} lookups, shared_ptr {}us, flat {}us", (count - 1) * passes, shared_us, flat_us);
+	return wxString::Format("%zu lookups over %zu item types\nshared_ptr:\t%lld us\nflat table:\t%lld us", (count - 1) * passes, count - 1, static_cast<long long>(shared_us), static_cast<long long>(flat_us));
+}
+
+uint8_t ItemDatabase::getHotFlags(const ItemType &type) {
+	uint8_t flags = 0;
+	if (type.unpassable) {
+		flags |= HOT_UNPASSABLE;
+	}
+	if (type.isBorder) {
+		flags |= HOT_BORDER;
+	}
+	if (type.isOptionalBorder) {
+		flags |= HOT_OPTIONAL_BORDER;
+	}
+	if (type.isTable) {
+		flags |= HOT_TABLE;
+	}
+	if (type.isCarpet) {
+		flags |= HOT_CARPET;
+	}
+	return flags;
+}
+
+uint16_t ItemDatabase::getSpriteMiniMapColor(const GameSprite* sprite) {
+	return sprite->minimap_color;
+}
+
+uint16_t ItemDatabase::getSpriteGroundSpeed(const GameSprite* sprite) {
+	return sprite->ground_speed;
+}
+
 bool ItemDatabase::isValidID(uint16_t id) const {
 	if (id == 0 || id > maxItemId) {
 		return false;
@@ -439,14 +439,64 @@ public:
 	uint16_t getMaxID() const noexcept {
 		return maxItemId;
 	}
-	ItemType &getItemType(uint16_t id);
+	ItemType &getItemType(uint16_t id) {
+		if (id < frozen_types.size()) {
+			return *frozen_types[id];
+		}
+		return lookupItemType(id);
+	}
 	std::shared_ptr<ItemType> getRawItemType(uint16_t id);
 
+	// Builds the flat lookup tables once every loader and brush is done with the types,
+	// from then on until clear() lookups are a single indexed load instead of a shared_ptr copy
+	void freeze();
+	bool isFrozen() const noexcept {
+		return !frozen_types.empty();
+	}
+	// Times lookups through the shared_ptr path against the flat table, for the Debug menu of debug builds
+	wxString benchmarkLookups();
+
+	// Properties tested in hot loops, kept packed per id so they don't pull in whole ItemTypes
+	enum HotFlag : uint8_t {
+		HOT_UNPASSABLE = 1 << 0,
+		HOT_BORDER = 1 << 1,
+		HOT_OPTIONAL_BORDER = 1 << 2,
+		HOT_TABLE = 1 << 3,
+		HOT_CARPET = 1 << 4,
+	};
+	bool hasHotFlag(uint16_t id, uint8_t flag) {
+		if (id < hot.flags.size()) {
+			return (hot.flags[id] & flag) != 0;
+		}
+		return (getHotFlags(getItemType(id)) & flag) != 0;
+	}
+	uint8_t getMiniMapColor(uint16_t id) {
+		if (id < hot.minimap_color.size()) {
+			return hot.minimap_color[id];
+		}
+		const GameSprite* sprite = getItemType(id).sprite;
+		return sprite ? static_cast<uint8_t>(getSpriteMiniMapColor(sprite)) : 0;
+	}
+	uint16_t getGroundSpeed(uint16_t id) {
+		if (id < hot.ground_speed.size()) {
+			return hot.ground_speed[id];
+		}
+		const GameSprite* sprite = getItemType(id).sprite;
+		return sprite ? getSpriteGroundSpeed(sprite) : 0;
+	}
+	int getTopOrder(uint16_t id) {
+		if (id < hot.top_order.size()) {
+			return hot.top_order[id];
+		}
+		return getItemType(id).alwaysOnTopOrder;
+	}
+
 	bool isValidID(uint16_t id) const;
 
 	bool loadFromOtb(const FileName &datafile, wxString &error, wxArrayString &warnings);
 	bool loadFromProtobuf(wxString &error, wxArrayString &warnings, canary::protobuf::appearances::Appearances &appearances);
 	bool loadFromGameXml(const FileName &datafile, wxString &error, wxArrayString &warnings);
+	bool loadFromGameXml(const pugi::xml_document &doc, wxString &error, wxArrayString &warnings);
 	bool loadItemFromGameXml(pugi::xml_node itemNode, uint16_t id);
 	bool loadMetaItem(pugi::xml_node node);
 
@@ -469,9 +519,24 @@ protected:
 
 	bool loadFromOtb(BinaryNode* itemNode, wxString &error, wxArrayString &warnings);
 
+	ItemType &lookupItemType(uint16_t id);
+	static uint8_t getHotFlags(const ItemType &type);
+	// GameSprite is incomplete here
+	static uint16_t getSpriteMiniMapColor(const GameSprite* sprite);
+	static uint16_t getSpriteGroundSpeed(const GameSprite* sprite);
+
 protected:
 	ItemMap items;
 
+	// Built by freeze, indexed by id up to maxItemId, ids without a type point at dummy
+	std::vector<ItemType*> frozen_types;
+	struct HotTable {
+		std::vector<uint8_t> flags;
+		std::vector<uint8_t> minimap_color;
+		std::vector<uint16_t> ground_speed;
+		std::vector<uint8_t> top_order;
+	} hot;
+
 	// Count of GameSprite types
 	uint16_t item_count = 0;
 	uint16_t effect_count = 0;
@@ -24,7 +24,9 @@
 
 LiveClient::LiveClient() :
 	LiveSocket(),
-	readMessage(), queryNodeList(), currentOperation(),
+	readMessage(), queuedNodes(), requestedNodes(),
+	viewStartX(0), viewStartY(0), viewEndX(0), viewEndY(0), viewUnderground(false), viewKnown(false), panX(0), panY(0),
+	currentOperation(),
 	resolver(nullptr), socket(nullptr), editor(nullptr), stopped(false) {
 	//
 }
@@ -131,6 +133,11 @@ void LiveClient::close() {
 		socket->close();
 	}
 
+	clearTileBatches();
+	queuedNodes[0].clear();
+	queuedNodes[1].clear();
+	requestedNodes.clear();
+
 	if (log) {
 		log->Message("Disconnected from server.");
 		log->Disconnect();
@@ -195,8 +202,8 @@ void LiveClient::receive(uint32_t packetSize) {
 }
 
 void LiveClient::send(NetworkMessage &message) {
-	memcpy(&message.buffer[0], &message.size, 4);
-	asio::async_write(*socket, asio::buffer(message.buffer, message.size + 4), [this](const std::error_code &error, size_t bytesTransferred) -> void {
+	const auto buffer = prepareMessage(message);
+	asio::async_write(*socket, asio::buffer(*buffer), [this, buffer](const std::error_code &error, size_t bytesTransferred) -> void {
 		if (error) {
 			logMessage(wxString() + getHostName() + ": " + error.message());
 		}
@@ -246,7 +253,7 @@ void LiveClient::sendHello() {
 	message.write<uint8_t>(PACKET_HELLO_FROM_CLIENT);
 	message.write<uint32_t>(__RME_VERSION_ID__);
 	message.write<uint32_t>(__LIVE_NET_VERSION__);
-	message.write<uint32_t>(0);
+	message.write<uint32_t>(LIVE_FEATURES_SUPPORTED);
 	message.write<std::string>(nstr(name));
 	message.write<std::string>(nstr(password));
 
@@ -254,20 +261,63 @@ void LiveClient::sendHello() {
 }
 
 void LiveClient::sendNodeRequests() {
-	if (queryNodeList.empty()) {
+	if (!editor || requestedNodes.size() >= LiveNodeRequestWindow) {
+		return;
+	}
+
+	prefetchNodes();
+
+	Map &map = editor->getMap();
+	const size_t window = LiveNodeRequestWindow - requestedNodes.size();
+
+	std::vector<uint32_t> nodes;
+	// The layer in view goes first, the other one gets what is left of the window
+	for (const bool underground : { viewUnderground, !viewUnderground }) {
+		std::unordered_set<uint32_t> &queue = queuedNodes[underground ? 1 : 0];
+
+		std::vector<uint32_t> candidates;
+		candidates.reserve(queue.size());
+		for (auto it = queue.begin(); it != queue.end();) {
+			const uint32_t nd = *it;
+			if (isNodeNearView(nd)) {
+				candidates.push_back(nd);
+				++it;
+				continue;
+			}
+
+			// Scrolled far away before it was sent, it is queried again once it is drawn
+			QTreeNode* node = map.getLeaf((nd >> 18) << 2, ((nd >> 4) & 0x3FFF) << 2);
+			if (node) {
+				node->setRequested(underground, false);
+			}
+			it = queue.erase(it);
+		}
+
+		const size_t count = std::min(window - nodes.size(), candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), [this](uint32_t first, uint32_t second) {
+			return getNodePriority(first) < getNodePriority(second);
+		});
+
+		for (size_t index = 0; index < count; ++index) {
+			queue.erase(candidates[index]);
+			requestedNodes.insert(candidates[index]);
+			nodes.push_back(candidates[index]);
+		}
+	}
+
+	if (nodes.empty()) {
 		return;
 	}
 
 	NetworkMessage message;
 	message.write<uint8_t>(PACKET_REQUEST_NODES);
 
-	message.write<uint32_t>(queryNodeList.size());
-	for (uint32_t node : queryNodeList) {
+	message.write<uint32_t>(nodes.size());
+	for (uint32_t node : nodes) {
 		message.write<uint32_t>(node);
 	}
 
 	send(message);
-	queryNodeList.clear();
 }
 
 void LiveClient::sendChanges(DirtyList &dirtyList) {
@@ -317,10 +367,96 @@ void LiveClient::queryNode(int32_t ndx, int32_t ndy, bool underground) {
 	nd |= ((ndx >> 2) << 18);
 	nd |= ((ndy >> 2) << 4);
 	nd |= (underground ? 1 : 0);
-	queryNodeList.insert(nd);
+	queuedNodes[underground ? 1 : 0].insert(nd);
+}
+
+void LiveClient::updateViewport(int32_t startX, int32_t startY, int32_t endX, int32_t endY, bool underground) {
+	// Compared by center, zooming doesn't count as a pan
+	const int32_t moveX = (startX + endX) - (viewStartX + viewEndX);
+	const int32_t moveY = (startY + endY) - (viewStartY + viewEndY);
+	if (!viewKnown || underground != viewUnderground) {
+		panX = 0;
+		panY = 0;
+	} else if (moveX != 0 || moveY != 0) {
+		panX = (moveX > 0) - (moveX < 0);
+		panY = (moveY > 0) - (moveY < 0);
+	}
+
+	viewStartX = startX;
+	viewStartY = startY;
+	viewEndX = endX;
+	viewEndY = endY;
+	viewUnderground = underground;
+	viewKnown = true;
+}
+
+void LiveClient::prefetchNodes() {
+	if (panX == 0 && panY == 0) {
+		return;
+	}
+
+	Map &map = editor->getMap();
+	const auto prefetchArea = [&](int32_t fromX, int32_t fromY, int32_t toX, int32_t toY) {
+		fromX = std::max(fromX, 0) & ~3;
+		fromY = std::max(fromY, 0) & ~3;
+		toX = std::min(toX, map.getWidth() - 1);
+		toY = std::min(toY, map.getHeight() - 1);
+		for (int32_t x = fromX; x <= toX; x += 4) {
+			for (int32_t y = fromY; y <= toY; y += 4) {
+				QTreeNode* node = map.getLeaf(x, y);
+				if (!node) {
+					node = map.createLeaf(x, y);
+					node->setVisible(false, false);
+				}
+
+				if (!node->isVisible(viewUnderground) && !node->isRequested(viewUnderground)) {
+					queryNode(x, y, viewUnderground);
+					node->setRequested(viewUnderground, true);
+				}
+			}
+		}
+	};
+
+	if (panX > 0) {
+		prefetchArea(viewEndX + 1, viewStartY, viewEndX + LiveNodePrefetchDistance, viewEndY);
+	} else if (panX < 0) {
+		prefetchArea(viewStartX - LiveNodePrefetchDistance, viewStartY, viewStartX - 1, viewEndY);
+	}
+
+	if (panY > 0) {
+		prefetchArea(viewStartX, viewEndY + 1, viewEndX, viewEndY + LiveNodePrefetchDistance);
+	} else if (panY < 0) {
+		prefetchArea(viewStartX, viewStartY - LiveNodePrefetchDistance, viewEndX, viewStartY - 1);
+	}
 }
 
-void LiveClient::parsePacket(NetworkMessage message) {
+int64_t LiveClient::getNodePriority(uint32_t nd) const {
+	const int32_t x = (nd >> 18) << 2;
+	const int32_t y = ((nd >> 4) & 0x3FFF) << 2;
+
+	// Doubled coordinates, the view center may fall between tiles
+	const int64_t dx = (x * 2 + 3) - (viewStartX + viewEndX);
+	const int64_t dy = (y * 2 + 3) - (viewStartY + viewEndY);
+	int64_t priority = dx * dx + dy * dy;
+	if (x + 3 < viewStartX || x > viewEndX || y + 3 < viewStartY || y > viewEndY) {
+		priority += static_cast<int64_t>(1) << 40;
+	}
+	return priority;
+}
+
+bool LiveClient::isNodeNearView(uint32_t nd) const {
+	// A view size around the view, plus what prefetching may have queued
+	const int32_t marginX = (viewEndX - viewStartX) + LiveNodePrefetchDistance;
+	const int32_t marginY = (viewEndY - viewStartY) + LiveNodePrefetchDistance;
+
+	const int32_t x = (nd >> 18) << 2;
+	const int32_t y = ((nd >> 4) & 0x3FFF) << 2;
+	return x + 3 >= viewStartX - marginX && x <= viewEndX + marginX && y + 3 >= viewStartY - marginY && y <= viewEndY + marginY;
+}
+
+void LiveClient::parsePacket(NetworkMessage message, bool decompressed) {
+	const size_t requested = requestedNodes.size();
+
 	uint8_t packetType;
 	while (message.position < message.buffer.size()) {
 		packetType = message.read<uint8_t>();
@@ -337,12 +473,18 @@ void LiveClient::parsePacket(NetworkMessage message) {
 			case PACKET_CHANGE_CLIENT_VERSION:
 				parseChangeClientVersion(message);
 				break;
+			case PACKET_PROTOCOL_FEATURES:
+				parseProtocolFeatures(message);
+				break;
 			case PACKET_SERVER_TALK:
 				parseServerTalk(message);
 				break;
 			case PACKET_NODE:
 				parseNode(message);
 				break;
+			case PACKET_NODE_DELTA:
+				parseNodeDelta(message);
+				break;
 			case PACKET_CURSOR_UPDATE:
 				parseCursorUpdate(message);
 				break;
@@ -352,6 +494,9 @@ void LiveClient::parsePacket(NetworkMessage message) {
 			case PACKET_UPDATE_OPERATION:
 				parseUpdateOperation(message);
 				break;
+			case PACKET_COMPRESSED:
+				parseCompressed(message, decompressed);
+				break;
 			default: {
 				log->Message("Unknown packet receieved!");
 				close();
@@ -359,6 +504,13 @@ void LiveClient::parsePacket(NetworkMessage message) {
 			}
 		}
 	}
+	flushTileStreams();
+
+	// Answers free the request window, empty nodes bring no tiles to refresh the view with
+	if (requestedNodes.size() < requested) {
+		sendNodeRequests();
+		g_gui.RefreshView();
+	}
 }
 
 void LiveClient::parseHello(NetworkMessage &message) {
@@ -397,6 +549,10 @@ void LiveClient::parseChangeClientVersion(NetworkMessage &message) {
 	sendReady();
 }
 
+void LiveClient::parseProtocolFeatures(NetworkMessage &message) {
+	features = message.read<uint32_t>() & LIVE_FEATURES_SUPPORTED;
+}
+
 void LiveClient::parseServerTalk(NetworkMessage &message) {
 	const std::string &speaker = message.read<std::string>();
 	const std::string &chatMessage = message.read<std::string>();
@@ -414,8 +570,37 @@ void LiveClient::parseNode(NetworkMessage &message) {
 	int32_t ndy = (ind >> 4) & 0x3FFF;
 	bool underground = ind & 1;
 
+	requestedNodes.erase(ind);
+	receiveNode(message, *editor, ndx, ndy, underground);
+}
+
+void LiveClient::parseNodeDelta(NetworkMessage &message) {
+	uint32_t ind = message.read<uint32_t>();
+
+	int32_t ndx = ind >> 18;
+	int32_t ndy = (ind >> 4) & 0x3FFF;
+
+	receiveNodeDelta(message, *editor, ndx, ndy);
+}
+
+void LiveClient::parseCompressed(NetworkMessage &message, bool decompressed) {
+	// Only when negotiated, and never nested, a compressed run holds plain packets
+	NetworkMessage unpacked;
+	if (!testFlags(features, LIVE_FEATURE_COMPRESSION) || decompressed || !decompressMessage(message, unpacked)) {
+		log->Message("Invalid compressed packet receieved!");
+		close();
+		return;
+	}
+	parsePacket(std::move(unpacked), true);
+}
+
+void LiveClient::applyTiles(std::vector<LiveTile> &tiles) {
+	if (!editor) {
+		return;
+	}
+
 	Action* action = editor->createAction(ACTION_REMOTE);
-	receiveNode(message, *editor, action, ndx, ndy, underground);
+	addTileChanges(editor->getMap(), action, tiles);
 	editor->addAction(action);
 
 	g_gui.RefreshView();
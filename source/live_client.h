@@ -21,7 +21,8 @@
 #include "live_socket.h"
 #include "net_connection.h"
 
-#include <set>
+#include <array>
+#include <unordered_set>
 
 class DirtyList;
 class MapTab;
@@ -61,25 +62,53 @@ public:
 
 	// Flags a node as queried and stores it, need to call SendNodeRequest to send it to server
 	void queryNode(int32_t ndx, int32_t ndy, bool underground);
+	// The tiles drawn in the last frame, the queued nodes are requested nearest to their center first
+	void updateViewport(int32_t startX, int32_t startY, int32_t endX, int32_t endY, bool underground);
 
 protected:
-	void parsePacket(NetworkMessage message);
+	// Queries the nodes just past the edges the view is moving towards
+	void prefetchNodes();
+	// Lower is sooner, nodes in view come before all others
+	int64_t getNodePriority(uint32_t nd) const;
+	bool isNodeNearView(uint32_t nd) const;
+
+	void parsePacket(NetworkMessage message, bool decompressed = false);
 
 	// parse packets
 	void parseHello(NetworkMessage &message);
 	void parseKick(NetworkMessage &message);
 	void parseClientAccepted(NetworkMessage &message);
 	void parseChangeClientVersion(NetworkMessage &message);
+	void parseProtocolFeatures(NetworkMessage &message);
 	void parseServerTalk(NetworkMessage &message);
 	void parseNode(NetworkMessage &message);
+	void parseNodeDelta(NetworkMessage &message);
+	void parseCompressed(NetworkMessage &message, bool decompressed);
 	void parseCursorUpdate(NetworkMessage &message);
 	void parseStartOperation(NetworkMessage &message);
 	void parseUpdateOperation(NetworkMessage &message);
 
+	// One action and refresh for all the tiles received in a frame
+	void applyTiles(std::vector<LiveTile> &tiles);
+
 	//
 	NetworkMessage readMessage;
 
-	std::set<uint32_t> queryNodeList;
+	// Queried nodes of either layer, overground first
+	std::array<std::unordered_set<uint32_t>, 2> queuedNodes;
+	// Sent and not answered yet
+	std::unordered_set<uint32_t> requestedNodes;
+
+	int32_t viewStartX;
+	int32_t viewStartY;
+	int32_t viewEndX;
+	int32_t viewEndY;
+	bool viewUnderground;
+	bool viewKnown;
+	// Last direction the view moved in, -1, 0 or 1 on each axis
+	int32_t panX;
+	int32_t panY;
+
 	wxString currentOperation;
 
 	std::shared_ptr<asio::ip::tcp::resolver> resolver;
@@ -36,12 +36,39 @@ enum LivePacketType {
 	PACKET_ACCEPTED_CLIENT = 0x82,
 	PACKET_CHANGE_CLIENT_VERSION = 0x83,
 	PACKET_SERVER_TALK = 0x84,
+	PACKET_PROTOCOL_FEATURES = 0x85,
 
 	PACKET_NODE = 0x90,
 	PACKET_CURSOR_UPDATE = 0x91,
 	PACKET_START_OPERATION = 0x92,
 	PACKET_UPDATE_OPERATION = 0x93,
 	PACKET_CHAT_MESSAGE = 0x94,
+	PACKET_NODE_DELTA = 0x95,
+
+	// Either direction, holds a deflated run of other packets
+	PACKET_COMPRESSED = 0xA0,
+};
+
+// Optional parts of the protocol. The client offers them in its hello and a server that knows
+// them answers with PACKET_PROTOCOL_FEATURES, so older editors on either side keep the base protocol.
+enum LiveFeature : uint32_t {
+	LIVE_FEATURE_NODE_DELTA = 1 << 0,
+	LIVE_FEATURE_COMPRESSION = 1 << 1,
+
+	LIVE_FEATURES_SUPPORTED = LIVE_FEATURE_NODE_DELTA | LIVE_FEATURE_COMPRESSION,
 };
 
+// Packets smaller than this are sent as they are, deflate doesn't gain much on them
+constexpr uint32_t LiveCompressionThreshold = 512;
+// Largest payload a compressed packet may unpack to, and the best ratio deflate can reach
+constexpr uint32_t LiveMaxDecompressedSize = 64 * 1024 * 1024;
+constexpr uint32_t LiveMaxCompressionRatio = 1032;
+
+// Node requests a client keeps unanswered at once, the rest wait in its queue
+constexpr uint32_t LiveNodeRequestWindow = 64;
+// How many tiles past the edge of the view a client requests in the direction it pans
+constexpr int32_t LiveNodePrefetchDistance = 16;
+// Node replies are packed into messages of about this size
+constexpr uint32_t LiveNodeBatchSize = 64 * 1024;
+
 #endif
@@ -26,7 +26,7 @@
 
 LivePeer::LivePeer(LiveServer* server, asio::ip::tcp::socket socket) :
 	LiveSocket(),
-	readMessage(), server(server), socket(std::move(socket)), color(), id(0), clientId(0), connected(false) {
+	readMessage(), nodeMessage(), server(server), socket(std::move(socket)), color(), id(0), clientId(0), connected(false) {
 	ASSERT(server != nullptr);
 }
 
@@ -94,8 +94,8 @@ void LivePeer::receive(uint32_t packetSize) {
 }
 
 void LivePeer::send(NetworkMessage &message) {
-	memcpy(&message.buffer[0], &message.size, 4);
-	asio::async_write(socket, asio::buffer(message.buffer, message.size + 4), [this](const std::error_code &error, size_t bytesTransferred) -> void {
+	const auto buffer = prepareMessage(message);
+	asio::async_write(socket, asio::buffer(*buffer), [this, buffer](const std::error_code &error, size_t bytesTransferred) -> void {
 		if (error) {
 			logMessage(wxString() + getHostName() + ": " + error.message());
 		}
@@ -122,7 +122,7 @@ void LivePeer::parseLoginPacket(NetworkMessage message) {
 	}
 }
 
-void LivePeer::parseEditorPacket(NetworkMessage message) {
+void LivePeer::parseEditorPacket(NetworkMessage message, bool decompressed) {
 	uint8_t packetType;
 	while (message.position < message.buffer.size()) {
 		packetType = message.read<uint8_t>();
@@ -148,6 +148,17 @@ void LivePeer::parseEditorPacket(NetworkMessage message) {
 			case PACKET_CLIENT_TALK:
 				parseChatMessage(message);
 				break;
+			case PACKET_COMPRESSED: {
+				// Only when negotiated, and never nested, a compressed run holds plain packets
+				NetworkMessage unpacked;
+				if (testFlags(features, LIVE_FEATURE_COMPRESSION) && !decompressed && decompressMessage(message, unpacked)) {
+					parseEditorPacket(std::move(unpacked), true);
+				} else {
+					log->Message("Invalid compressed packet receieved, connection severed.");
+					close();
+				}
+				break;
+			}
 			default: {
 				log->Message("Invalid editor packet receieved, connection severed.");
 				close();
@@ -155,6 +166,7 @@ void LivePeer::parseEditorPacket(NetworkMessage message) {
 			}
 		}
 	}
+	flushTileStreams();
 }
 
 void LivePeer::parseHello(NetworkMessage &message) {
@@ -185,7 +197,8 @@ void LivePeer::parseHello(NetworkMessage &message) {
 		return;
 	}
 
-	uint32_t clientVersion = message.read<uint32_t>();
+	// Older editors always send 0 here
+	uint32_t offeredFeatures = message.read<uint32_t>();
 	std::string nickname = message.read<std::string>();
 	std::string password = message.read<std::string>();
 
@@ -199,8 +212,14 @@ void LivePeer::parseHello(NetworkMessage &message) {
 	log->Message(name + " (" + getHostName() + ") connected.");
 
 	NetworkMessage outMessage;
+	if (offeredFeatures != 0) {
+		outMessage.write<uint8_t>(PACKET_PROTOCOL_FEATURES);
+		outMessage.write<uint32_t>(offeredFeatures & LIVE_FEATURES_SUPPORTED);
+	}
 	outMessage.write<uint8_t>(PACKET_ACCEPTED_CLIENT);
 	send(outMessage);
+
+	features = offeredFeatures & LIVE_FEATURES_SUPPORTED;
 }
 
 void LivePeer::parseReady(NetworkMessage &message) {
@@ -248,34 +267,25 @@ void LivePeer::parseNodeRequest(NetworkMessage &message) {
 
 		QTreeNode* node = map.createLeaf(ndx * 4, ndy * 4);
 		if (node) {
-			sendNode(clientId, node, ndx, ndy, underground ? 0xFF00 : 0x00FF);
+			const uint32_t floorMask = underground ? 0xFF00 : 0x00FF;
+			LiveNode floors;
+			serializeNode(node, floorMask, floors);
+			sendNode(node, ndx, ndy, floorMask, floors, true);
 		}
 	}
+	flushNodes();
 }
 
 void LivePeer::parseReceiveChanges(NetworkMessage &message) {
-	Editor &editor = *server->getEditor();
-
-	// -1 on address since we skip the first START_NODE when sending
-	const std::string &data = message.read<std::string>();
-	mapReader.assign(reinterpret_cast<const uint8_t*>(data.c_str() - 1), data.size());
+	receiveChanges(message);
+}
 
-	BinaryNode* rootNode = mapReader.getRootNode();
-	BinaryNode* tileNode = rootNode->getChild();
+void LivePeer::applyTiles(std::vector<LiveTile> &tiles) {
+	Editor &editor = *server->getEditor();
 
 	NetworkedAction* action = static_cast<NetworkedAction*>(editor.createAction(ACTION_REMOTE));
 	action->owner = clientId;
-
-	if (tileNode) {
-		do {
-			Tile* tile = readTile(tileNode, editor, nullptr);
-			if (tile) {
-				action->addChange(newd Change(tile));
-			}
-		} while (tileNode->advance());
-	}
-	mapReader.close();
-
+	addTileChanges(editor.getMap(), action, tiles);
 	editor.addAction(action);
 
 	g_gui.RefreshView();
@@ -308,3 +318,96 @@ void LivePeer::parseChatMessage(NetworkMessage &message) {
 	const std::string &chatMessage = message.read<std::string>();
 	server->broadcastChat(name, wxstr(chatMessage));
 }
+
+void LivePeer::sendNode(QTreeNode* node, int32_t ndx, int32_t ndy, uint32_t floorMask, const LiveNode &floors, bool full) {
+	const bool underground = (floorMask & 0xFF00) && !(floorMask & 0x00FF);
+	node->setVisible(clientId, underground, true);
+
+	const size_t position = nodeMessage.position;
+	const size_t size = nodeMessage.size;
+	if (!testFlags(features, LIVE_FEATURE_NODE_DELTA)) {
+		writeNode(nodeMessage, ndx, ndy, floorMask, floors);
+	} else if (full) {
+		writeNode(nodeMessage, ndx, ndy, floorMask, floors);
+		for (uint32_t z = 0; z < 16; ++z) {
+			if (floors[z].exists && testFlags(floorMask, static_cast<uint64_t>(1) << z)) {
+				sentFloors[getFloorKey(ndx, ndy, z)] = floors[z].hashes;
+			}
+		}
+	} else if (!writeNodeDelta(nodeMessage, ndx, ndy, floorMask, floors)) {
+		// The peer has all of it already
+		nodeMessage.position = position;
+		nodeMessage.size = size;
+		return;
+	}
+
+	if (nodeMessage.size >= LiveNodeBatchSize) {
+		flushNodes();
+	}
+}
+
+void LivePeer::flushNodes() {
+	if (nodeMessage.size == 0) {
+		return;
+	}
+	send(nodeMessage);
+	nodeMessage.clear();
+}
+
+void LivePeer::forgetNode(int32_t ndx, int32_t ndy, uint32_t floorMask) {
+	for (uint32_t z = 0; z < 16; ++z) {
+		if (testFlags(floorMask, static_cast<uint64_t>(1) << z)) {
+			sentFloors.erase(getFloorKey(ndx, ndy, z));
+		}
+	}
+}
+
+bool LivePeer::writeNodeDelta(NetworkMessage &message, int32_t ndx, int32_t ndy, uint32_t floorMask, const LiveNode &floors) {
+	message.write<uint8_t>(PACKET_NODE_DELTA);
+	message.write<uint32_t>((ndx << 18) | (ndy << 4) | ((floorMask & 0xFF00) ? 1 : 0));
+
+	const size_t maskPosition = message.position;
+	message.write<uint16_t>(0);
+
+	// TCP delivers in order, so the peer has applied everything sent before this once it reads it
+	uint16_t sendMask = 0;
+	for (uint32_t z = 0; z < 16; ++z) {
+		if (!testFlags(floorMask, static_cast<uint64_t>(1) << z)) {
+			continue;
+		}
+
+		const LiveFloor &floor = floors[z];
+		const uint64_t key = getFloorKey(ndx, ndy, z);
+		uint16_t changedBits = 0;
+		auto it = sentFloors.find(key);
+		if (it == sentFloors.end()) {
+			if (!floor.exists) {
+				continue;
+			}
+			// Nothing to compare with, the whole floor goes
+			changedBits = 0xFFFF;
+			sentFloors.emplace(key, floor.hashes);
+		} else {
+			for (uint32_t index = 0; index < 16; ++index) {
+				if (it->second[index] != floor.hashes[index]) {
+					changedBits |= (1 << index);
+				}
+			}
+			if (changedBits == 0) {
+				continue;
+			}
+			it->second = floor.hashes;
+		}
+
+		const uint16_t tileBits = changedBits & floor.tileBits;
+		message.write<uint16_t>(changedBits);
+		message.write<uint16_t>(tileBits);
+		if (tileBits != 0) {
+			message.writeLongString(floor.getTiles(tileBits));
+		}
+		sendMask |= (1 << z);
+	}
+
+	memcpy(&message.buffer[maskPosition], &sendMask, sizeof(sendMask));
+	return sendMask != 0;
+}
@@ -55,9 +55,21 @@ public:
 	//
 	void updateCursor(const Position &position) { }
 
+	// Queues floorMask of a node the caller serialized, as a delta against what the peer got before if it takes those
+	void sendNode(QTreeNode* node, int32_t ndx, int32_t ndy, uint32_t floorMask, const LiveNode &floors, bool full);
+	// Sends the queued nodes as one message, sendNode only does so once they reach LiveNodeBatchSize
+	void flushNodes();
+	// The peer changed these floors itself, so what it was sent before no longer tells what it has
+	void forgetNode(int32_t ndx, int32_t ndy, uint32_t floorMask);
+
 protected:
+	static uint64_t getFloorKey(int32_t ndx, int32_t ndy, uint32_t z) {
+		return (static_cast<uint64_t>(ndx) << 32) | (static_cast<uint64_t>(ndy) << 8) | z;
+	}
+	bool writeNodeDelta(NetworkMessage &message, int32_t ndx, int32_t ndy, uint32_t floorMask, const LiveNode &floors);
+
 	void parseLoginPacket(NetworkMessage message);
-	void parseEditorPacket(NetworkMessage message);
+	void parseEditorPacket(NetworkMessage message, bool decompressed = false);
 
 	// login packets
 	void parseHello(NetworkMessage &message);
@@ -72,8 +84,15 @@ protected:
 	void parseCursorUpdate(NetworkMessage &message);
 	void parseChatMessage(NetworkMessage &message);
 
+	// One action and refresh for all the changes received in a frame
+	void applyTiles(std::vector<LiveTile> &tiles);
+
 	//
 	NetworkMessage readMessage;
+	NetworkMessage nodeMessage;
+
+	// Tile hashes of every floor last sent to the peer, the base of the node deltas
+	std::unordered_map<uint64_t, std::array<uint64_t, 16>> sentFloors;
 
 	LiveServer* server;
 	asio::ip::tcp::socket socket;
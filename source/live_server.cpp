@@ -179,6 +179,7 @@ void LiveServer::broadcastNodes(DirtyList &dirtyList) {
 		return;
 	}
 
+	LiveNode nodeFloors;
 	for (const auto &ind : dirtyList.GetPosList()) {
 		int32_t ndx = ind.pos >> 18;
 		int32_t ndy = (ind.pos >> 4) & 0x3FFF;
@@ -189,23 +190,37 @@ void LiveServer::broadcastNodes(DirtyList &dirtyList) {
 			continue;
 		}
 
+		// Serialized once for all peers, on the first one that can see the node
+		bool serialized = false;
 		for (auto &clientEntry : clients) {
 			LivePeer* peer = clientEntry.second;
 
 			const uint32_t clientId = peer->getClientId();
 			if (dirtyList.owner != 0 && dirtyList.owner == clientId) {
+				peer->forgetNode(ndx, ndy, floors);
 				continue;
 			}
 
-			if (node->isVisible(clientId, true)) {
-				peer->sendNode(clientId, node, ndx, ndy, floors & 0xFF00);
+			const bool underground = node->isVisible(clientId, true);
+			const bool overground = node->isVisible(clientId, false);
+			if ((underground || overground) && !serialized) {
+				serializeNode(node, floors, nodeFloors);
+				serialized = true;
 			}
 
-			if (node->isVisible(clientId, false)) {
-				peer->sendNode(clientId, node, ndx, ndy, floors & 0x00FF);
+			if (underground) {
+				peer->sendNode(node, ndx, ndy, floors & 0xFF00, nodeFloors, false);
+			}
+
+			if (overground) {
+				peer->sendNode(node, ndx, ndy, floors & 0x00FF, nodeFloors, false);
 			}
 		}
 	}
+
+	for (auto &clientEntry : clients) {
+		clientEntry.second->flushNodes();
+	}
 }
 
 void LiveServer::broadcastCursor(const LiveCursor &cursor) {
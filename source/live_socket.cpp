@@ -23,11 +23,58 @@
 #include "iomap_otbm.h"
 #include "live_tab.h"
 #include "editor.h"
+#include "threads.h"
+
+#include <zlib.h>
+
+namespace {
+	// FNV-1a, tells tile versions apart
+	uint64_t hashTile(const uint8_t* data, size_t size) {
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= data[i];
+			hash *= 0x100000001B3ULL;
+		}
+		// 0 is kept for empty tiles
+		return hash != 0 ? hash : 1;
+	}
+
+	// Shared by every socket, a couple of workers keep up with any connection
+	ThreadPool &getTileDecoder() {
+		static ThreadPool pool(std::min<size_t>(ThreadPool::getDefaultThreadCount(), 2));
+		return pool;
+	}
+
+	uint64_t getTileKey(const Position &position) {
+		return (static_cast<uint64_t>(position.x) << 32) | (static_cast<uint64_t>(position.y) << 8) | position.z;
+	}
+}
+
+LiveTileTimer::LiveTileTimer(LiveSocket* socket) :
+	wxTimer(),
+	socket(socket) {
+	////
+}
+
+void LiveTileTimer::Notify() {
+	socket->applyTileBatches();
+}
+
+std::string LiveFloor::getTiles(uint16_t tiles) const {
+	std::string stream;
+	for (uint32_t index = 0; index < 16; ++index) {
+		if (testFlags(tiles, static_cast<uint64_t>(1) << index)) {
+			stream.append(data, offsets[index], offsets[index + 1] - offsets[index]);
+		}
+	}
+	stream.push_back(static_cast<char>(NODE_END));
+	return stream;
+}
 
 LiveSocket::LiveSocket() :
-	cursors(), mapReader(nullptr, 0), mapWriter(),
+	cursors(), tileStreams(), tileBatches(), tileTimer(this), mapWriter(),
 	mapVersion(MapVersion()), log(nullptr),
-	name("User"), password("") {
+	name("User"), password(""), features(0) {
 	//
 }
 
@@ -92,150 +139,132 @@ void LiveSocket::logMessage(const wxString &message) {
 	});
 }
 
-void LiveSocket::receiveNode(NetworkMessage &message, Editor &editor, Action* action, int32_t ndx, int32_t ndy, bool underground) {
+void LiveSocket::receiveNode(NetworkMessage &message, Editor &editor, int32_t ndx, int32_t ndy, bool underground) {
+	// The floors are read either way, the packet may carry more after them
 	QTreeNode* node = editor.getMap().getLeaf(ndx * 4, ndy * 4);
-	if (!node) {
+	if (node) {
+		node->setRequested(underground, false);
+		node->setVisible(underground, true);
+	} else {
 		log->Message("Warning: Received update for unknown tile (" + std::to_string(ndx * 4) + "/" + std::to_string(ndy * 4) + "/" + (underground ? "true" : "false") + ")");
-		return;
 	}
 
-	node->setRequested(underground, false);
-	node->setVisible(underground, true);
-
 	uint16_t floorBits = message.read<uint16_t>();
-	if (floorBits == 0) {
-		return;
-	}
-
 	for (uint_fast8_t z = 0; z < 16; ++z) {
 		if (testFlags(floorBits, static_cast<uint64_t>(1) << z)) {
-			receiveFloor(message, editor, action, ndx, ndy, z, node, node->getFloor(z));
+			receiveFloor(message, ndx, ndy, z, node != nullptr);
 		}
 	}
 }
 
-void LiveSocket::sendNode(uint32_t clientId, QTreeNode* node, int32_t ndx, int32_t ndy, uint32_t floorMask) {
-	bool underground;
-	if (floorMask & 0xFF00) {
-		if (floorMask & 0x00FF) {
-			underground = false;
-		} else {
-			underground = true;
-		}
-	} else {
-		underground = false;
+void LiveSocket::receiveNodeDelta(NetworkMessage &message, Editor &editor, int32_t ndx, int32_t ndy) {
+	// The floors are read either way, the packet may carry more after them
+	QTreeNode* node = editor.getMap().getLeaf(ndx * 4, ndy * 4);
+	if (!node) {
+		log->Message("Warning: Received update for unknown tile (" + std::to_string(ndx * 4) + "/" + std::to_string(ndy * 4) + ")");
 	}
 
-	node->setVisible(clientId, underground, true);
+	uint16_t floorBits = message.read<uint16_t>();
+	for (uint_fast8_t z = 0; z < 16; ++z) {
+		if (testFlags(floorBits, static_cast<uint64_t>(1) << z)) {
+			receiveFloorDelta(message, ndx, ndy, z, node != nullptr);
+		}
+	}
+}
 
-	// Send message
-	NetworkMessage message;
+void LiveSocket::writeNode(NetworkMessage &message, int32_t ndx, int32_t ndy, uint32_t floorMask, const LiveNode &floors) {
 	message.write<uint8_t>(PACKET_NODE);
 	message.write<uint32_t>((ndx << 18) | (ndy << 4) | ((floorMask & 0xFF00) ? 1 : 0));
 
-	if (!node) {
-		message.write<uint8_t>(0x00);
-	} else {
-		Floor** floors = node->getFloors();
-
-		uint16_t sendMask = 0;
-		for (uint32_t z = 0; z < 16; ++z) {
-			uint32_t bit = 1 << z;
-			if (floors[z] && testFlags(floorMask, bit)) {
-				sendMask |= bit;
-			}
+	uint16_t sendMask = 0;
+	for (uint32_t z = 0; z < 16; ++z) {
+		uint32_t bit = 1 << z;
+		if (floors[z].exists && testFlags(floorMask, bit)) {
+			sendMask |= bit;
 		}
+	}
 
-		message.write<uint16_t>(sendMask);
-		for (uint32_t z = 0; z < 16; ++z) {
-			if (testFlags(sendMask, static_cast<uint64_t>(1) << z)) {
-				sendFloor(message, floors[z]);
-			}
+	message.write<uint16_t>(sendMask);
+	for (uint32_t z = 0; z < 16; ++z) {
+		if (testFlags(sendMask, static_cast<uint64_t>(1) << z)) {
+			writeFloor(message, floors[z]);
 		}
 	}
-
-	send(message);
 }
 
-void LiveSocket::receiveFloor(NetworkMessage &message, Editor &editor, Action* action, int32_t ndx, int32_t ndy, int32_t z, QTreeNode* node, Floor* floor) {
-	Map &map = editor.getMap();
-
-	uint16_t tileBits = message.read<uint16_t>();
-	if (tileBits == 0) {
-		for (uint_fast8_t x = 0; x < 4; ++x) {
-			for (uint_fast8_t y = 0; y < 4; ++y) {
-				action->addChange(new Change(map.allocator(node->createTile(ndx * 4 + x, ndy * 4 + y, z))));
-			}
+void LiveSocket::serializeNode(QTreeNode* node, uint32_t floorMask, LiveNode &floors) {
+	Floor** nodeFloors = node->getFloors();
+	for (uint32_t z = 0; z < 16; ++z) {
+		floors[z] = LiveFloor();
+		if (nodeFloors[z] && testFlags(floorMask, static_cast<uint64_t>(1) << z)) {
+			serializeFloor(nodeFloors[z], floors[z]);
 		}
-		return;
 	}
+}
 
-	// -1 on address since we skip the first START_NODE when sending
-	const std::string &data = message.read<std::string>();
-	mapReader.assign(reinterpret_cast<const uint8_t*>(data.c_str() - 1), data.size());
-
-	BinaryNode* rootNode = mapReader.getRootNode();
-	BinaryNode* tileNode = rootNode->getChild();
-
-	Position position(0, 0, z);
-	for (uint_fast8_t x = 0; x < 4; ++x) {
-		for (uint_fast8_t y = 0; y < 4; ++y) {
-			position.x = (ndx * 4) + x;
-			position.y = (ndy * 4) + y;
+void LiveSocket::receiveFloor(NetworkMessage &message, int32_t ndx, int32_t ndy, int32_t z, bool known) {
+	LiveFloorStream floor;
+	floor.origin = Position(ndx * 4, ndy * 4, z);
+	floor.changedBits = 0xFFFF;
+	floor.tileBits = message.read<uint16_t>();
+	if (floor.tileBits != 0) {
+		floor.data = message.read<std::string>();
+	}
 
-			if (testFlags(tileBits, static_cast<uint64_t>(1) << ((x * 4) + y))) {
-				receiveTile(tileNode, editor, action, &position);
-				tileNode->advance();
-			} else {
-				action->addChange(new Change(map.allocator(node->createTile(position.x, position.y, z))));
-			}
-		}
+	if (known) {
+		tileStreams.floors.push_back(std::move(floor));
 	}
-	mapReader.close();
 }
 
-void LiveSocket::sendFloor(NetworkMessage &message, Floor* floor) {
-	uint16_t tileBits = 0;
-	for (uint_fast8_t x = 0; x < 4; ++x) {
-		for (uint_fast8_t y = 0; y < 4; ++y) {
-			uint_fast8_t index = (x * 4) + y;
+void LiveSocket::receiveFloorDelta(NetworkMessage &message, int32_t ndx, int32_t ndy, int32_t z, bool known) {
+	LiveFloorStream floor;
+	floor.origin = Position(ndx * 4, ndy * 4, z);
+	floor.changedBits = message.read<uint16_t>();
+	floor.tileBits = message.read<uint16_t>();
+	if (floor.tileBits != 0) {
+		floor.data = message.readLongString();
+	}
 
-			Tile* tile = floor->locs[index].get();
-			if (tile && tile->size() > 0) {
-				tileBits |= (1 << index);
-			}
-		}
+	if (known) {
+		tileStreams.floors.push_back(std::move(floor));
 	}
+}
 
-	message.write<uint16_t>(tileBits);
-	if (tileBits == 0) {
-		return;
+void LiveSocket::writeFloor(NetworkMessage &message, const LiveFloor &floor) {
+	message.write<uint16_t>(floor.tileBits);
+	if (floor.tileBits != 0) {
+		message.write<std::string>(floor.getTiles(floor.tileBits));
 	}
+}
+
+void LiveSocket::receiveChanges(NetworkMessage &message) {
+	tileStreams.changes.push_back(message.read<std::string>());
+}
+
+void LiveSocket::serializeFloor(Floor* floor, LiveFloor &data) {
+	data.exists = true;
+	data.tileBits = 0;
 
 	mapWriter.reset();
 	for (uint_fast8_t x = 0; x < 4; ++x) {
 		for (uint_fast8_t y = 0; y < 4; ++y) {
 			uint_fast8_t index = (x * 4) + y;
-			if (testFlags(tileBits, static_cast<uint64_t>(1) << index)) {
-				sendTile(mapWriter, floor->locs[index].get(), nullptr);
+			data.offsets[index] = static_cast<uint32_t>(mapWriter.getSize());
+
+			Tile* tile = floor->locs[index].get();
+			if (tile && tile->size() > 0) {
+				data.tileBits |= (1 << index);
+				sendTile(mapWriter, tile, nullptr);
 			}
 		}
 	}
-	mapWriter.endNode();
-
-	std::string stream(
-		reinterpret_cast<char*>(mapWriter.getMemory()),
-		mapWriter.getSize()
-	);
-	message.write<std::string>(stream);
-}
+	data.offsets[16] = static_cast<uint32_t>(mapWriter.getSize());
 
-void LiveSocket::receiveTile(BinaryNode* node, Editor &editor, Action* action, const Position* position) {
-	ASSERT(node != nullptr);
-
-	Tile* tile = readTile(node, editor, position);
-	if (tile) {
-		action->addChange(newd Change(tile));
+	const uint8_t* memory = mapWriter.getMemory();
+	data.data.assign(reinterpret_cast<const char*>(memory), mapWriter.getSize());
+	for (uint32_t index = 0; index < 16; ++index) {
+		const uint32_t size = data.offsets[index + 1] - data.offsets[index];
+		data.hashes[index] = size != 0 ? hashTile(memory + data.offsets[index], size) : 0;
 	}
 }
 
@@ -273,16 +302,141 @@ void LiveSocket::sendTile(MemoryNodeFileWriteHandle &writer, Tile* tile, const P
 	writer.endNode();
 }
 
-Tile* LiveSocket::readTile(BinaryNode* node, Editor &editor, const Position* position) {
-	ASSERT(node != nullptr);
+void LiveSocket::flushTileStreams() {
+	if (tileStreams.empty()) {
+		return;
+	}
+
+	const MapVersion version = mapVersion.version;
+	tileBatches.push_back(getTileDecoder().enqueue([version, streams = std::move(tileStreams)]() {
+		return decodeTiles(version, streams);
+	}));
+	tileStreams = LiveTileStreams();
+
+	if (!tileTimer.IsRunning()) {
+		tileTimer.Start(16);
+	}
+}
+
+void LiveSocket::applyTileBatches() {
+	std::vector<LiveTile> tiles;
+	while (!tileBatches.empty() && tileBatches.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		std::vector<LiveTile> batch = tileBatches.front().get();
+		tileBatches.pop_front();
+		std::move(batch.begin(), batch.end(), std::back_inserter(tiles));
+	}
+
+	if (tileBatches.empty()) {
+		tileTimer.Stop();
+	}
+
+	if (tiles.empty()) {
+		return;
+	}
+
+	// A tile received several times since the last frame is only applied in its latest version
+	std::unordered_map<uint64_t, size_t> indexes;
+	size_t count = 0;
+	for (size_t index = 0; index < tiles.size(); ++index) {
+		const auto [it, inserted] = indexes.try_emplace(getTileKey(tiles[index].position), count);
+		if (!inserted) {
+			tiles[it->second] = std::move(tiles[index]);
+		} else {
+			if (index != count) {
+				tiles[count] = std::move(tiles[index]);
+			}
+			++count;
+		}
+	}
+	tiles.resize(count);
+
+	applyTiles(tiles);
+}
+
+void LiveSocket::clearTileBatches() {
+	// The decoders only own their streams, their results can be dropped unfinished
+	tileStreams = LiveTileStreams();
+	tileBatches.clear();
+	tileTimer.Stop();
+}
 
-	Map &map = editor.getMap();
+void LiveSocket::addTileChanges(Map &map, Action* action, std::vector<LiveTile> &tiles) {
+	for (LiveTile &entry : tiles) {
+		Tile* tile = entry.tile.release();
+		tile->setLocation(map.createTileL(entry.position));
+		if (entry.houseId != 0) {
+			tile->setHouse(map.houses.getHouse(entry.houseId));
+		}
+		action->addChange(newd Change(tile));
+	}
+}
+
+std::vector<LiveTile> LiveSocket::decodeTiles(MapVersion version, const LiveTileStreams &streams) {
+	const VirtualIOMap maphandle(version);
+	MemoryNodeFileReadHandle reader(nullptr, 0);
+
+	std::vector<LiveTile> tiles;
+	for (const LiveFloorStream &floor : streams.floors) {
+		BinaryNode* tileNode = nullptr;
+		if (floor.tileBits != 0) {
+			// -1 on address since we skip the first START_NODE when sending
+			reader.assign(reinterpret_cast<const uint8_t*>(floor.data.c_str() - 1), floor.data.size());
+			tileNode = reader.getRootNode()->getChild();
+		}
+
+		Position position(0, 0, floor.origin.z);
+		for (uint_fast8_t x = 0; x < 4; ++x) {
+			for (uint_fast8_t y = 0; y < 4; ++y) {
+				const uint64_t bit = static_cast<uint64_t>(1) << ((x * 4) + y);
+				if (!testFlags(floor.changedBits, bit)) {
+					continue;
+				}
+
+				position.x = floor.origin.x + x;
+				position.y = floor.origin.y + y;
+				if (!testFlags(floor.tileBits, bit)) {
+					LiveTile tile;
+					tile.position = position;
+					tile.tile.reset(newd Tile(position.x, position.y, position.z));
+					tiles.push_back(std::move(tile));
+				} else if (tileNode) {
+					LiveTile tile;
+					if (readTile(tileNode, maphandle, &position, tile)) {
+						tiles.push_back(std::move(tile));
+					}
+					tileNode->advance();
+				}
+			}
+		}
+		reader.close();
+	}
+
+	for (const std::string &changes : streams.changes) {
+		// -1 on address since we skip the first START_NODE when sending
+		reader.assign(reinterpret_cast<const uint8_t*>(changes.c_str() - 1), changes.size());
+
+		BinaryNode* tileNode = reader.getRootNode()->getChild();
+		if (tileNode) {
+			do {
+				LiveTile tile;
+				if (readTile(tileNode, maphandle, nullptr, tile)) {
+					tiles.push_back(std::move(tile));
+				}
+			} while (tileNode->advance());
+		}
+		reader.close();
+	}
+	return tiles;
+}
+
+bool LiveSocket::readTile(BinaryNode* node, const IOMap &maphandle, const Position* position, LiveTile &result) {
+	ASSERT(node != nullptr);
 
 	uint8_t tileType;
 	node->getByte(tileType);
 
 	if (tileType != OTBM_TILE && tileType != OTBM_HOUSETILE) {
-		return nullptr;
+		return false;
 	}
 
 	Position pos;
@@ -302,24 +456,16 @@ Tile* LiveSocket::readTile(BinaryNode* node, Editor &editor, const Position* pos
 		}
 	}
 
-	Tile* tile = map.allocator(
-		map.createTileL(pos)
-	);
+	std::unique_ptr<Tile> tile(newd Tile(pos.x, pos.y, pos.z));
 
+	uint32_t houseId = 0;
 	if (tileType == OTBM_HOUSETILE) {
-		uint32_t houseId;
 		if (!node->getU32(houseId)) {
 			// warning("House tile without house data, discarding tile");
-			delete tile;
-			return nullptr;
+			return false;
 		}
 
-		if (houseId) {
-			House* house = map.houses.getHouse(houseId);
-			if (house) {
-				tile->setHouse(house);
-			}
-		} else {
+		if (!houseId) {
 			// warning("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z);
 		}
 	}
@@ -336,7 +482,7 @@ Tile* LiveSocket::readTile(BinaryNode* node, Editor &editor, const Position* pos
 				break;
 			}
 			case OTBM_ATTR_ITEM: {
-				Item* item = Item::Create_OTBM(mapVersion, node);
+				Item* item = Item::Create_OTBM(maphandle, node);
 				if (!item) {
 					// warning("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z);
 				}
@@ -356,14 +502,13 @@ Tile* LiveSocket::readTile(BinaryNode* node, Editor &editor, const Position* pos
 			uint8_t itemType;
 			if (!itemNode->getByte(itemType)) {
 				// warning("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z);
-				delete tile;
-				return nullptr;
+				return false;
 			}
 
 			if (itemType == OTBM_ITEM) {
-				Item* item = Item::Create_OTBM(mapVersion, itemNode);
+				Item* item = Item::Create_OTBM(maphandle, itemNode);
 				if (item) {
-					if (!item->unserializeItemNode_OTBM(mapVersion, itemNode)) {
+					if (!item->unserializeItemNode_OTBM(maphandle, itemNode)) {
 						// warning("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z);
 					}
 					tile->addItem(item);
@@ -375,7 +520,10 @@ Tile* LiveSocket::readTile(BinaryNode* node, Editor &editor, const Position* pos
 		} while (itemNode->advance());
 	}
 
-	return tile;
+	result.position = pos;
+	result.tile = std::move(tile);
+	result.houseId = houseId;
+	return true;
 }
 
 LiveCursor LiveSocket::readCursor(NetworkMessage &message) {
@@ -400,3 +548,53 @@ void LiveSocket::writeCursor(NetworkMessage &message, const LiveCursor &cursor)
 	message.write<uint8_t>(cursor.color.Alpha());
 	message.write<Position>(cursor.pos);
 }
+
+bool LiveSocket::compressMessage(const NetworkMessage &message, NetworkMessage &compressed) const {
+	uLongf size = compressBound(message.size);
+	std::string stream(size, '\0');
+	if (compress2(reinterpret_cast<Bytef*>(stream.data()), &size, &message.buffer[4], message.size, Z_BEST_SPEED) != Z_OK || size + 9 >= message.size) {
+		return false;
+	}
+	stream.resize(size);
+
+	compressed.write<uint8_t>(PACKET_COMPRESSED);
+	compressed.write<uint32_t>(message.size);
+	compressed.writeLongString(stream);
+	return true;
+}
+
+bool LiveSocket::decompressMessage(NetworkMessage &message, NetworkMessage &decompressed) const {
+	const uint32_t size = message.read<uint32_t>();
+	uint32_t length;
+	if (message.position + 4 > message.buffer.size()) {
+		return false;
+	}
+	memcpy(&length, &message.buffer[message.position], 4);
+	if (length > message.buffer.size() - message.position - 4) {
+		return false;
+	}
+	const std::string &stream = message.readLongString();
+
+	// The size is the peer's word, no more is allocated than the stream could possibly inflate to
+	if (size > LiveMaxDecompressedSize || size > static_cast<uint64_t>(stream.size()) * LiveMaxCompressionRatio) {
+		return false;
+	}
+
+	decompressed.buffer.resize(4 + size);
+	uLongf unpackedSize = size;
+	if (uncompress(&decompressed.buffer[4], &unpackedSize, reinterpret_cast<const Bytef*>(stream.data()), stream.size()) != Z_OK || unpackedSize != size) {
+		return false;
+	}
+	decompressed.position = 4;
+	decompressed.size = size;
+	return true;
+}
+
+std::shared_ptr<std::vector<uint8_t>> LiveSocket::prepareMessage(NetworkMessage &message) const {
+	NetworkMessage compressed;
+	NetworkMessage &out = (testFlags(features, LIVE_FEATURE_COMPRESSION) && message.size >= LiveCompressionThreshold && compressMessage(message, compressed)) ? compressed : message;
+
+	// Copied, the message usually goes out of scope before the write finishes
+	memcpy(&out.buffer[0], &out.size, 4);
+	return std::make_shared<std::vector<uint8_t>>(out.buffer.begin(), out.buffer.begin() + out.size + 4);
+}
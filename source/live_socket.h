@@ -24,10 +24,14 @@
 #include "filehandle.h"
 #include "iomap.h"
 
+#include <array>
+#include <deque>
+#include <future>
 #include <memory>
 #include <unordered_map>
 
 class LiveLogTab;
+class LiveSocket;
 class Action;
 
 struct LiveCursor {
@@ -36,6 +40,63 @@ struct LiveCursor {
 	Position pos;
 };
 
+// A floor of a node in the tile encoding of the protocol. Every tile is kept apart with a hash,
+// so a peer can be sent only the tiles that differ from what it got last time.
+struct LiveFloor {
+	bool exists = false;
+	uint16_t tileBits = 0;
+	// 0 for an empty tile
+	std::array<uint64_t, 16> hashes {};
+	// Tile i is data[offsets[i], offsets[i + 1])
+	std::array<uint32_t, 17> offsets {};
+	std::string data;
+
+	// The encoded nodes of the given tiles, closed like a floor stream
+	std::string getTiles(uint16_t tiles) const;
+};
+using LiveNode = std::array<LiveFloor, 16>;
+
+// A received floor stream, kept raw until a worker decodes it
+struct LiveFloorStream {
+	// North west tile of the floor
+	Position origin;
+	// Tiles left out of changedBits stay as they are, changed tiles left out of tileBits are cleared
+	uint16_t changedBits;
+	uint16_t tileBits;
+	std::string data;
+};
+
+// The tile streams of the packets parsed in one go
+struct LiveTileStreams {
+	std::vector<LiveFloorStream> floors;
+	// Change lists, their tiles carry their own position
+	std::vector<std::string> changes;
+
+	bool empty() const noexcept {
+		return floors.empty() && changes.empty();
+	}
+};
+
+// A tile decoded by a worker, it is put on the map by the UI thread
+struct LiveTile {
+	Position position;
+	// Detached from the map, an empty tile clears the position
+	std::unique_ptr<Tile> tile;
+	// Looked up when applied, the houses belong to the UI thread
+	uint32_t houseId = 0;
+};
+
+// Applies the decoded tiles once per frame while any are pending
+class LiveTileTimer : public wxTimer {
+public:
+	LiveTileTimer(LiveSocket* socket);
+
+	void Notify();
+
+private:
+	LiveSocket* socket;
+};
+
 class LiveSocket {
 public:
 	LiveSocket();
@@ -67,25 +128,54 @@ public:
 
 protected:
 	// receive / send methods
-	void receiveNode(NetworkMessage &message, Editor &editor, Action* action, int32_t ndx, int32_t ndy, bool underground);
-	void sendNode(uint32_t clientId, QTreeNode* node, int32_t ndx, int32_t ndy, uint32_t floorMask);
+	// The receive methods only queue the tile streams, see flushTileStreams
+	void receiveNode(NetworkMessage &message, Editor &editor, int32_t ndx, int32_t ndy, bool underground);
+	void receiveNodeDelta(NetworkMessage &message, Editor &editor, int32_t ndx, int32_t ndy);
+	void writeNode(NetworkMessage &message, int32_t ndx, int32_t ndy, uint32_t floorMask, const LiveNode &floors);
+
+	void receiveFloor(NetworkMessage &message, int32_t ndx, int32_t ndy, int32_t z, bool known);
+	void receiveFloorDelta(NetworkMessage &message, int32_t ndx, int32_t ndy, int32_t z, bool known);
+	void writeFloor(NetworkMessage &message, const LiveFloor &floor);
+
+	void receiveChanges(NetworkMessage &message);
 
-	void receiveFloor(NetworkMessage &message, Editor &editor, Action* action, int32_t ndx, int32_t ndy, int32_t z, QTreeNode* node, Floor* floor);
-	void sendFloor(NetworkMessage &message, Floor* floor);
+	// Encodes the floors of floorMask once, so every peer can be sent the same bytes
+	void serializeNode(QTreeNode* node, uint32_t floorMask, LiveNode &floors);
+	void serializeFloor(Floor* floor, LiveFloor &data);
 
-	void receiveTile(BinaryNode* node, Editor &editor, Action* action, const Position* position);
 	void sendTile(MemoryNodeFileWriteHandle &writer, Tile* tile, const Position* position);
 
+	// Hands the queued tile streams to a worker
+	void flushTileStreams();
+	// Merges the batches decoded so far, in the order they were received, and passes them to applyTiles
+	void applyTileBatches();
+	void clearTileBatches();
+	// Called on the UI thread with the tiles of a frame, a position is there only once
+	virtual void applyTiles(std::vector<LiveTile> &tiles) { }
+	void addTileChanges(Map &map, Action* action, std::vector<LiveTile> &tiles);
+
+	// Run on the workers, must not touch the map
+	static std::vector<LiveTile> decodeTiles(MapVersion version, const LiveTileStreams &streams);
+
 	// read / write types
-	Tile* readTile(BinaryNode* node, Editor &editor, const Position* position);
+	static bool readTile(BinaryNode* node, const IOMap &maphandle, const Position* position, LiveTile &result);
 
 	LiveCursor readCursor(NetworkMessage &message);
 	void writeCursor(NetworkMessage &message, const LiveCursor &cursor);
 
+	// Wraps a packet run into PACKET_COMPRESSED when that makes it smaller
+	bool compressMessage(const NetworkMessage &message, NetworkMessage &compressed) const;
+	bool decompressMessage(NetworkMessage &message, NetworkMessage &decompressed) const;
+	// The buffer to send, compressed if the other side can read it
+	std::shared_ptr<std::vector<uint8_t>> prepareMessage(NetworkMessage &message) const;
+
 	//
 	std::unordered_map<uint32_t, LiveCursor> cursors;
 
-	MemoryNodeFileReadHandle mapReader;
+	LiveTileStreams tileStreams;
+	std::deque<std::future<std::vector<LiveTile>>> tileBatches;
+	LiveTileTimer tileTimer;
+
 	MemoryNodeFileWriteHandle mapWriter;
 	VirtualIOMap mapVersion;
 
@@ -95,7 +185,11 @@ protected:
 	wxString password;
 	wxString lastError;
 
+	// LiveFeature bits both sides agreed on
+	uint32_t features;
+
 	friend class LiveLogTab;
+	friend class LiveTileTimer;
 };
 
 #endif
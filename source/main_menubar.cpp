@@ -126,6 +126,10 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(MAP_CLEAN_HOUSE_ITEMS, wxITEM_NORMAL, OnMapCleanHouseItems);
 	MAKE_ACTION(MAP_PROPERTIES, wxITEM_NORMAL, OnMapProperties);
 	MAKE_ACTION(MAP_STATISTICS, wxITEM_NORMAL, OnMapStatistics);
+#ifdef __DEBUG__
+	MAKE_ACTION(MAP_RENDER_BENCHMARK, wxITEM_NORMAL, OnMapRenderBenchmark);
+	MAKE_ACTION(MAP_ITEM_LOOKUP_BENCHMARK, wxITEM_NORMAL, OnMapItemLookupBenchmark);
+#endif
 
 	MAKE_ACTION(VIEW_TOOLBARS_BRUSHES, wxITEM_CHECK, OnToolbars);
 	MAKE_ACTION(VIEW_TOOLBARS_POSITION, wxITEM_CHECK, OnToolbars);
@@ -405,6 +409,10 @@ void MainMenuBar::Update() {
 	EnableItem(MAP_CLEANUP, is_local);
 	EnableItem(MAP_PROPERTIES, is_local);
 	EnableItem(MAP_STATISTICS, is_local);
+#ifdef __DEBUG__
+	EnableItem(MAP_RENDER_BENCHMARK, has_map);
+	EnableItem(MAP_ITEM_LOOKUP_BENCHMARK, has_map);
+#endif
 
 	EnableItem(NEW_VIEW, has_map);
 	EnableItem(ZOOM_IN, has_map);
@@ -604,6 +612,14 @@ bool MainMenuBar::Load(const FileName &path, wxArrayString &warnings, wxString &
 
 	// [FEATURES] Menu is now handled in menubar.xml
 
+#ifdef __DEBUG__
+	// Measurement tools for developers, they are not in menubar.xml so release builds never show them
+	wxMenu* debugMenu = newd wxMenu;
+	items[MenuBar::MAP_RENDER_BENCHMARK].push_back(debugMenu->Append(MAIN_FRAME_MENU + MenuBar::MAP_RENDER_BENCHMARK, "Rendering &Benchmark", "Measure the frame time of the current view at several zoom levels."));
+	items[MenuBar::MAP_ITEM_LOOKUP_BENCHMARK].push_back(debugMenu->Append(MAIN_FRAME_MENU + MenuBar::MAP_ITEM_LOOKUP_BENCHMARK, "Item &Lookup Benchmark", "Measure item type lookups through the flat table against the old path."));
+	menubar->Append(debugMenu, "&Debug");
+#endif
+
 #ifdef __LINUX__
 	const int count = 53;
 	wxAcceleratorEntry entries[count];
@@ -1403,7 +1419,7 @@ void MainMenuBar::OnBorderizeMap(wxCommandEvent &WXUNUSED(event)) {
 		return;
 	}
 
-	int ret = g_gui.PopupDialog("Borderize Map", "Are you sure you want to borderize the entire map (this action cannot be undone)?", wxYES | wxNO);
+	int ret = g_gui.PopupDialog("Borderize Map", "Are you sure you want to borderize the entire map?", wxYES | wxNO);
 	if (ret == wxID_YES) {
 		g_gui.GetCurrentEditor()->borderizeMap(true);
 	}
@@ -1425,7 +1441,7 @@ void MainMenuBar::OnRandomizeMap(wxCommandEvent &WXUNUSED(event)) {
 		return;
 	}
 
-	int ret = g_gui.PopupDialog("Randomize Map", "Are you sure you want to randomize the entire map (this action cannot be undone)?", wxYES | wxNO);
+	int ret = g_gui.PopupDialog("Randomize Map", "Are you sure you want to randomize the entire map?", wxYES | wxNO);
 	if (ret == wxID_YES) {
 		g_gui.GetCurrentEditor()->randomizeMap(true);
 	}
@@ -2082,6 +2098,30 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
 	}
 
+	// The arena is shared by every open map, the undo queue and the copybuffer
+	const MapArena::Report arena = MapArena::getReport();
+	os << "\tMemory data (all open maps):\n";
+	os << "\t\tArena reserved: " << (arena.reserved_bytes / 1024) << " KiB\n";
+	os << "\t\tArena in use: " << (arena.live_bytes / 1024) << " KiB by " << arena.live_objects << " objects\n";
+	if (arena.reserved_bytes > 0) {
+		os << "\t\tArena utilization: " << (100.0 * arena.live_bytes / arena.reserved_bytes) << "%\n";
+	}
+	if (map->usesLeafPageTable()) {
+		const size_t page_bytes = LeafPageTable::PageSide * LeafPageTable::PageSide * sizeof(QTreeNode*);
+		os << "\t\tLeaf page table: " << map->getLeafPageCount() << " pages (" << (map->getLeafPageCount() * page_bytes / 1024) << " KiB)\n";
+	}
+	for (const MapArena::SizeClassReport &size_class : arena.classes) {
+		os << "\t\t" << size_class.block_size << " byte blocks";
+		if (size_class.block_size == MapArena::getBlockSize(sizeof(Tile))) {
+			os << " (tiles)";
+		} else if (size_class.block_size == MapArena::getBlockSize(sizeof(Floor))) {
+			os << " (floors)";
+		} else if (size_class.block_size == MapArena::getBlockSize(sizeof(QTreeNode))) {
+			os << " (nodes)";
+		}
+		os << ": " << size_class.live_objects << " live of " << size_class.capacity << " in " << size_class.slabs << " slabs\n";
+	}
+
 	os << "\n";
 	os << "Generated by Canary's Map Editor version " + __RME_VERSION__ + "\n";
 
@@ -2109,6 +2149,25 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 	}
 }
 
+#ifdef __DEBUG__
+void MainMenuBar::OnMapRenderBenchmark(wxCommandEvent &WXUNUSED(event)) {
+	MapTab* tab = g_gui.GetCurrentMapTab();
+	if (!tab) {
+		return;
+	}
+
+	wxBusyCursor busy;
+	const wxString report = tab->GetCanvas()->BenchmarkRendering();
+	g_gui.PopupDialog(frame, "Rendering Benchmark", report, wxOK);
+}
+
+void MainMenuBar::OnMapItemLookupBenchmark(wxCommandEvent &WXUNUSED(event)) {
+	wxBusyCursor busy;
+	const wxString report = g_items.benchmarkLookups();
+	g_gui.PopupDialog(frame, "Item Lookup Benchmark", report, wxOK);
+}
+#endif
+
 void MainMenuBar::OnMapCleanup(wxCommandEvent &WXUNUSED(event)) {
 	int ok = g_gui.PopupDialog("Clean map", "Do you want to remove all invalid items from the map?", wxYES | wxNO);
 
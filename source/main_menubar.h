@@ -92,6 +92,10 @@ namespace MenuBar {
 		MAP_CLEAN_HOUSE_ITEMS,
 		MAP_PROPERTIES,
 		MAP_STATISTICS,
+#ifdef __DEBUG__
+		MAP_RENDER_BENCHMARK,
+		MAP_ITEM_LOOKUP_BENCHMARK,
+#endif
 		VIEW_TOOLBARS_BRUSHES,
 		VIEW_TOOLBARS_POSITION,
 		VIEW_TOOLBARS_SIZES,
@@ -279,6 +283,10 @@ public:
 	void OnMapCleanup(wxCommandEvent &event);
 	void OnMapProperties(wxCommandEvent &event);
 	void OnMapStatistics(wxCommandEvent &event);
+#ifdef __DEBUG__
+	void OnMapRenderBenchmark(wxCommandEvent &event);
+	void OnMapItemLookupBenchmark(wxCommandEvent &event);
+#endif
 
 	// View Menu
 	void OnToolbars(wxCommandEvent &event);
@@ -19,11 +19,12 @@
 
 #include "gui.h"
 #include "map.h"
+#include "settings.h"
 
 #include "client_assets.h"
 
 Map::Map() :
-	BaseMap(),
+	BaseMap(g_settings.getBoolean(Config::MAP_PAGE_TABLE)),
 	width(512),
 	height(512),
 	houses(*this),
@@ -34,6 +35,7 @@ Map::Map() :
 	// Earliest version possible
 	// Caller is responsible for converting us to proper version
 	mapVersion.otbm = MAP_OTBM_1;
+	trackDirtyAreas();
 }
 
 Map::~Map() {
@@ -124,6 +126,9 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 		g_gui.CreateLoadBar("Converting map ...");
 	}
 
+	// Tiles are rewritten in place
+	markAllAreasDirty();
+
 	uint64_t tiles_done = 0;
 	std::vector<uint16_t> id_list;
 
@@ -273,6 +278,7 @@ void Map::cleanInvalidTiles(bool showdialog) {
 			} else {
 				delete *item_iter;
 				item_iter = tile->items.erase(item_iter);
+				markAreaDirty(tile->getPosition());
 			}
 		}
 
@@ -307,6 +313,7 @@ void Map::cleanDeletedZones(bool showdialog) {
 				++iter;
 			} else {
 				iter = tile->zones.erase(iter);
+				markAreaDirty(tile->getPosition());
 			}
 		}
 
@@ -409,6 +416,7 @@ bool Map::addSpawnMonster(Tile* tile) {
 				ctile_loc->increaseSpawnCount();
 			}
 		}
+		markAreasDirty(start_x, start_y, end_x, end_y, z);
 		spawnsMonster.addSpawnMonster(tile);
 		return true;
 	}
@@ -433,6 +441,7 @@ void Map::removeSpawnMonsterInternal(Tile* tile) {
 			}
 		}
 	}
+	markAreasDirty(start_x, start_y, end_x, end_y, z);
 }
 
 void Map::removeSpawnMonster(Tile* tile) {
@@ -453,64 +462,19 @@ SpawnMonsterList Map::getSpawnMonsterList(const Tile* tile) const {
 		return list;
 	}
 
-	uint32_t found = 0;
+	const Position &position = tile->getPosition();
 	if (tile->spawnMonster) {
-		++found;
 		list.push_back(tile->spawnMonster);
 	}
-
-	// Scans the border tiles in an expanding square around the original spawn
-	const Position &position = tile->getPosition();
-	int start_x = position.x - 1;
-	int end_x = position.x + 1;
-	int start_y = position.y - 1;
-	int end_y = position.y + 1;
-
-	while (found != location->getSpawnMonsterCount()) {
-		for (int x = start_x; x <= end_x; ++x) {
-			const Tile* start_tile = getTile(x, start_y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-
-			const Tile* end_tile = getTile(x, end_y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
+	spawnsMonster.forEachCovering(position, [&](const Position &center) {
+		if (center == position) {
+			return;
 		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
+		const Tile* spawn_tile = getTile(center);
+		if (spawn_tile && spawn_tile->spawnMonster) {
+			list.push_back(spawn_tile->spawnMonster);
 		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
-		}
-		--start_x;
-		--start_y;
-		++end_x;
-		++end_y;
-	}
+	});
 	return list;
 }
 
@@ -539,6 +503,7 @@ bool Map::addSpawnNpc(Tile* tile) {
 				ctile_loc->increaseSpawnNpcCount();
 			}
 		}
+		markAreasDirty(start_x, start_y, end_x, end_y, z);
 		spawnsNpc.addSpawnNpc(tile);
 		return true;
 	}
@@ -563,6 +528,7 @@ void Map::removeSpawnNpcInternal(Tile* tile) {
 			}
 		}
 	}
+	markAreasDirty(start_x, start_y, end_x, end_y, z);
 }
 
 void Map::removeSpawnNpc(Tile* tile) {
@@ -583,51 +549,19 @@ SpawnNpcList Map::getSpawnNpcList(const Tile* tile) const {
 		return listNpc;
 	}
 
-	uint32_t found = 0;
+	const Position &position = tile->getPosition();
 	if (tile->spawnNpc) {
-		++found;
 		listNpc.push_back(tile->spawnNpc);
 	}
-
-	// Scans the border tiles in an expanding square around the original spawn
-	const Position &position = tile->getPosition();
-	int start_x = position.x - 1;
-	int end_x = position.x + 1;
-	int start_y = position.y - 1;
-	int end_y = position.y + 1;
-
-	while (found != location->getSpawnNpcCount()) {
-		for (int x = start_x; x <= end_x; ++x) {
-			const Tile* start_tile = getTile(x, start_y, position.z);
-			if (start_tile && start_tile->spawnNpc) {
-				listNpc.push_back(start_tile->spawnNpc);
-				++found;
-			}
-
-			const Tile* end_tile = getTile(x, end_y, position.z);
-			if (end_tile && end_tile->spawnNpc) {
-				listNpc.push_back(end_tile->spawnNpc);
-				++found;
-			}
+	spawnsNpc.forEachCovering(position, [&](const Position &center) {
+		if (center == position) {
+			return;
 		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnNpc) {
-				listNpc.push_back(start_tile->spawnNpc);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnNpc) {
-				listNpc.push_back(end_tile->spawnNpc);
-				++found;
-			}
+		const Tile* spawn_tile = getTile(center);
+		if (spawn_tile && spawn_tile->spawnNpc) {
+			listNpc.push_back(spawn_tile->spawnNpc);
 		}
-		--start_x;
-		--start_y;
-		++end_x;
-		++end_y;
-	}
+	});
 	return listNpc;
 }
 
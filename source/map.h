@@ -189,6 +189,25 @@ protected:
 	bool has_changed; // If the map has changed
 	bool unnamed; // If the map has yet to receive a name
 
+	// Where the tile areas went in the file the map was last saved to, so the next
+	// save can copy the ones that have not changed since (see IOMapOTBM::saveMap)
+	struct SavedTileAreas {
+		std::string filename;
+		uint64_t file_size = 0;
+		int64_t file_time = 0;
+		MapVersionID version = MAP_OTBM_UNKNOWN;
+		// Tile area key -> offset and size of its node, not counting the file identifier
+		std::unordered_map<uint32_t, std::pair<uint64_t, uint64_t>> ranges;
+
+		void clear() {
+			filename.clear();
+			file_size = 0;
+			file_time = 0;
+			version = MAP_OTBM_UNKNOWN;
+			ranges.clear();
+		}
+	} saved_areas;
+
 	friend class IOMapOTBM;
 	friend class IOMapOTMM;
 	friend class Editor;
@@ -297,6 +316,7 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 			++it;
 			continue;
 		}
+		const int64_t removed_before = removed;
 
 		if (tile->ground) {
 			if (condition(map, tile->ground, removed, done)) {
@@ -316,6 +336,9 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 				++iit;
 			}
 		}
+		if (removed != removed_before) {
+			map.markAreaDirty(tile->getPosition());
+		}
 		++it;
 	}
 	return removed;
@@ -339,6 +362,7 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 			++it;
 			continue;
 		}
+		const int64_t removed_before = removed;
 
 		if (tile->ground) {
 			if (condition(map, tile, tile->ground, removed, done)) {
@@ -358,6 +382,9 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 				++iit;
 			}
 		}
+		if (removed != removed_before) {
+			map.markAreaDirty(tile->getPosition());
+		}
 		++it;
 	}
 	return removed;
@@ -0,0 +1,249 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_allocator.h"
+#include "tile.h"
+#include "map_region.h"
+
+#ifdef _WIN32
+	#include <malloc.h>
+#endif
+
+struct MapArena::Slab {
+	// Link in the size class list of slabs with free blocks
+	Slab* prev;
+	Slab* next;
+	void* free_list;
+	uint32_t block_size;
+	uint32_t live;
+	uint32_t capacity;
+	bool listed;
+};
+
+struct MapArena::SizeClass {
+	std::mutex mutex;
+	Slab* available = nullptr;
+	size_t block_size = 0;
+	size_t slabs = 0;
+	size_t live = 0;
+};
+
+namespace {
+	// Blocks start after the header, rounded up so they keep the allocation alignment
+	constexpr size_t SlabHeaderSize = 64;
+
+	void* allocateSlabMemory() {
+#ifdef _WIN32
+		return _aligned_malloc(MapArena::SlabSize, MapArena::SlabSize);
+#else
+		return std::aligned_alloc(MapArena::SlabSize, MapArena::SlabSize);
+#endif
+	}
+
+	void freeSlabMemory(void* memory) {
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+MapArena::SizeClass* MapArena::getSizeClasses() {
+	// Never destroyed, tiles may still be released by static destructors on exit
+	static SizeClass* classes = [] {
+		SizeClass* created = new SizeClass[SizeClassCount];
+		for (size_t i = 0; i < SizeClassCount; ++i) {
+			created[i].block_size = (i + 1) * Granularity;
+		}
+		return created;
+	}();
+	return classes;
+}
+
+MapArena::SizeClass &MapArena::getSizeClass(size_t size) {
+	return getSizeClasses()[getBlockSize(size) / Granularity - 1];
+}
+
+void* MapArena::allocate(size_t size) {
+	static_assert(sizeof(Slab) <= SlabHeaderSize, "Slab header must fit in front of the first block");
+	if (size == 0 || size > MaxBlockSize) {
+		return ::operator new(size);
+	}
+
+	SizeClass &sc = getSizeClass(size);
+	std::scoped_lock lock(sc.mutex);
+
+	Slab* slab = sc.available;
+	if (!slab) {
+		void* memory = allocateSlabMemory();
+		if (!memory) {
+			throw std::bad_alloc();
+		}
+
+		slab = static_cast<Slab*>(memory);
+		slab->prev = nullptr;
+		slab->next = nullptr;
+		slab->block_size = static_cast<uint32_t>(sc.block_size);
+		slab->live = 0;
+		slab->capacity = static_cast<uint32_t>((SlabSize - SlabHeaderSize) / sc.block_size);
+		slab->listed = true;
+
+		// Thread every block into the free list, lowest address first
+		char* first = static_cast<char*>(memory) + SlabHeaderSize;
+		slab->free_list = first;
+		for (uint32_t i = 0; i < slab->capacity; ++i) {
+			char* block = first + i * sc.block_size;
+			*reinterpret_cast<void**>(block) = (i + 1 < slab->capacity ? block + sc.block_size : nullptr);
+		}
+
+		sc.available = slab;
+		++sc.slabs;
+	}
+
+	void* block = slab->free_list;
+	slab->free_list = *static_cast<void**>(block);
+	++slab->live;
+	++sc.live;
+
+	if (!slab->free_list) {
+		// Full, unlink it until something is released
+		sc.available = slab->next;
+		if (slab->next) {
+			slab->next->prev = nullptr;
+		}
+		slab->next = nullptr;
+		slab->listed = false;
+	}
+	return block;
+}
+
+void MapArena::deallocate(void* ptr, size_t size) {
+	if (!ptr) {
+		return;
+	}
+	if (size > MaxBlockSize) {
+		::operator delete(ptr);
+		return;
+	}
+
+	Slab* slab = reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(SlabSize - 1));
+	// The size is unknown when a constructor threw under DEBUG_MEM, recover it from the slab
+	SizeClass &sc = getSizeClass(size != 0 ? size : slab->block_size);
+	std::scoped_lock lock(sc.mutex);
+
+	*static_cast<void**>(ptr) = slab->free_list;
+	slab->free_list = ptr;
+	--slab->live;
+	--sc.live;
+
+	if (!slab->listed) {
+		slab->prev = nullptr;
+		slab->next = sc.available;
+		if (sc.available) {
+			sc.available->prev = slab;
+		}
+		sc.available = slab;
+		slab->listed = true;
+	}
+}
+
+size_t MapArena::releaseUnused() {
+	size_t released = 0;
+	SizeClass* classes = getSizeClasses();
+	for (size_t i = 0; i < SizeClassCount; ++i) {
+		SizeClass &sc = classes[i];
+		std::scoped_lock lock(sc.mutex);
+
+		Slab* slab = sc.available;
+		while (slab) {
+			Slab* next = slab->next;
+			if (slab->live == 0) {
+				if (slab->prev) {
+					slab->prev->next = next;
+				} else {
+					sc.available = next;
+				}
+				if (next) {
+					next->prev = slab->prev;
+				}
+				freeSlabMemory(slab);
+				--sc.slabs;
+				released += SlabSize;
+			}
+			slab = next;
+		}
+	}
+	return released;
+}
+
+MapArena::Report MapArena::getReport() {
+	Report report;
+	SizeClass* classes = getSizeClasses();
+	for (size_t i = 0; i < SizeClassCount; ++i) {
+		SizeClass &sc = classes[i];
+		std::scoped_lock lock(sc.mutex);
+		if (sc.slabs == 0) {
+			continue;
+		}
+
+		SizeClassReport entry;
+		entry.block_size = sc.block_size;
+		entry.slabs = sc.slabs;
+		entry.live_objects = sc.live;
+		entry.capacity = sc.slabs * ((SlabSize - SlabHeaderSize) / sc.block_size);
+		report.classes.push_back(entry);
+
+		report.reserved_bytes += sc.slabs * SlabSize;
+		report.live_bytes += sc.live * sc.block_size;
+		report.live_objects += sc.live;
+	}
+	return report;
+}
+
+//=============================================================================
+// MapAllocator
+
+MapAllocator::~MapAllocator() {
+	releaseUnused();
+}
+
+Tile* MapAllocator::allocateTile(TileLocation* location) {
+	return newd Tile(*location);
+}
+
+void MapAllocator::freeTile(Tile* t) {
+	delete t;
+}
+
+Floor* MapAllocator::allocateFloor(int x, int y, int z) {
+	return newd Floor(x, y, z);
+}
+
+void MapAllocator::freeFloor(Floor* f) {
+	delete f;
+}
+
+QTreeNode* MapAllocator::allocateNode(BaseMap &map) {
+	return newd QTreeNode(map);
+}
+
+void MapAllocator::freeNode(QTreeNode* qt) {
+	delete qt;
+}
@@ -18,16 +18,84 @@
 #ifndef RME_MAP_ALLOCATOR_H
 #define RME_MAP_ALLOCATOR_H
 
-#include "tile.h"
-#include "map_region.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 class BaseMap;
+class Tile;
+class TileLocation;
+class Floor;
+class QTreeNode;
 
-class MapAllocator {
+// Slab allocator for the small objects making up the map structure.
+// Every size class carves 64 KiB slabs into equal blocks with per-slab free lists,
+// so millions of tiles end up packed together instead of scattered over the heap.
+// It's shared by all maps, since tiles move between maps, the undo queue and the copybuffer.
+class MapArena {
+public:
+	static constexpr size_t SlabSize = 64 * 1024;
+	static constexpr size_t Granularity = 16;
+	static constexpr size_t MaxBlockSize = 2048;
+	static constexpr size_t SizeClassCount = MaxBlockSize / Granularity;
+
+	static void* allocate(size_t size);
+	static void deallocate(void* ptr, size_t size);
+
+	// Gives slabs without any live object back to the system, returns the number of bytes released
+	static size_t releaseUnused();
+
+	struct SizeClassReport {
+		size_t block_size = 0;
+		size_t slabs = 0;
+		size_t live_objects = 0;
+		size_t capacity = 0;
+	};
+	struct Report {
+		std::vector<SizeClassReport> classes; // Only the size classes in use
+		size_t reserved_bytes = 0;
+		size_t live_bytes = 0;
+		size_t live_objects = 0;
+	};
+	static Report getReport();
+	static size_t getBlockSize(size_t size) {
+		return (size + Granularity - 1) / Granularity * Granularity;
+	}
+
+private:
+	struct Slab;
+	struct SizeClass;
+
+	static SizeClass &getSizeClass(size_t size);
+	static SizeClass* getSizeClasses();
+};
+
+// Inherit from this to have new/delete of a class served by the MapArena
+class MapArenaObject {
+public:
+	static void* operator new(size_t size) {
+		return MapArena::allocate(size);
+	}
+	static void operator delete(void* ptr, size_t size) {
+		MapArena::deallocate(ptr, size);
+	}
+#ifdef DEBUG_MEM
+	static void* operator new(size_t size, const char*, int) {
+		return MapArena::allocate(size);
+	}
+	static void operator delete(void* ptr, const char*, int) {
+		// Only called if a constructor throws, the size is lost by then
+		MapArena::deallocate(ptr, 0);
+	}
+#endif
+};
 
+class MapAllocator {
 public:
 	MapAllocator() { }
-	~MapAllocator() { }
+	// Runs after the map's QTree has been torn down, so whole slabs can be released at once
+	~MapAllocator();
 
 	// shorthands for tiles
 	Tile* operator()(TileLocation* location) {
@@ -39,27 +107,20 @@ public:
 	}
 
 	//
-	Tile* allocateTile(TileLocation* location) {
-		return newd Tile(*location);
-	}
-	void freeTile(Tile* t) {
-		delete t;
-	}
+	Tile* allocateTile(TileLocation* location);
+	void freeTile(Tile* t);
 
 	//
-	Floor* allocateFloor(int x, int y, int z) {
-		return newd Floor(x, y, z);
-	}
-	void freeFloor(Floor* f) {
-		delete f;
-	}
+	Floor* allocateFloor(int x, int y, int z);
+	void freeFloor(Floor* f);
 
 	//
-	QTreeNode* allocateNode(BaseMap &map) {
-		return newd QTreeNode(map);
-	}
-	void freeNode(QTreeNode* qt) {
-		delete qt;
+	QTreeNode* allocateNode(BaseMap &map);
+	void freeNode(QTreeNode* qt);
+
+	// Bulk release of the slabs emptied by clearing a map
+	size_t releaseUnused() {
+		return MapArena::releaseUnused();
 	}
 };
 
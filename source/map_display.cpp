@@ -21,6 +21,7 @@
 #include "editor.h"
 #include "brush.h"
 #include "sprites.h"
+#include "sprite_appearances.h"
 #include "map.h"
 #include "tile.h"
 #include "old_properties_window.h"
@@ -53,6 +54,7 @@
 
 // Forward declare from map_drawer.cpp for telemetry
 extern int GetTextureBindsLastFrame();
+extern int GetDrawCallsLastFrame();
 
 BEGIN_EVENT_TABLE(MapCanvas, wxGLCanvas)
 EVT_KEY_DOWN(MapCanvas::OnKeyDown)
@@ -376,7 +378,15 @@ void MapCanvas::OnPaint(wxPaintEvent &event) {
 		// Update StatusBar slot 4 with redraws and texture binds (stable, doesn't touch title)
 		if (g_gui.root) {
 			int texBinds = GetTextureBindsLastFrame();
-			wxString telemetry = wxString::Format("Redraws:%d Binds:%d", current_fps, texBinds);
+			int drawCalls = GetDrawCallsLastFrame();
+			wxString telemetry = wxString::Format(
+				"Redraws:%d Binds:%d Draws:%d Atlas:%d Evicted:%llu Upload:%lluKB Decoding:%d",
+				current_fps, texBinds, drawCalls,
+				static_cast<int>(g_gui.gfx.getAtlasPageCount()),
+				static_cast<unsigned long long>(g_gui.gfx.getAtlasEvictions()),
+				static_cast<unsigned long long>(g_gui.gfx.getAtlasUploadBytesLastFrame() / 1024),
+				static_cast<int>(g_spriteAppearances.getPendingSheetCount())
+			);
 			g_gui.root->SetStatusText(telemetry, 4);
 		}
 	}
@@ -402,6 +412,47 @@ void MapCanvas::ShowPositionIndicator(const Position &position) {
 	}
 }
 
+wxString MapCanvas::BenchmarkRendering() {
+	static constexpr double zoom_levels[] = { 0.5, 1.0, 2.0, 4.0, 8.0 };
+	static constexpr int frames = 30;
+
+	SetCurrent(*g_gui.GetGLContext(this));
+	const double old_zoom = zoom;
+
+	wxString report = "Zoom\tFirst frame\tAverage\tDraw calls\n";
+	for (double level : zoom_levels) {
+		SetZoom(level);
+
+		// The first frame walks every tile, the others show what an idle repaint costs
+		drawer->ClearRenderCache();
+		double first_ms = 0.0;
+		double total_ms = 0.0;
+		for (int frame = 0; frame <= frames; ++frame) {
+			const auto start = std::chrono::steady_clock::now();
+			drawer->SetupVars();
+			drawer->SetupGL();
+			drawer->Draw();
+			drawer->Release();
+			glFinish();
+			g_gui.gfx.garbageCollection();
+
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (frame == 0) {
+				first_ms = ms;
+			} else {
+				total_ms += ms;
+			}
+		}
+
+		const double average_ms = total_ms / frames;
+		spdlog::info("Rendering benchmark: zoom {:.2f}, first frame {:.2f} ms, average {:.2f} ms over {} frames, {} draw calls", level, first_ms, average_ms, frames, GetDrawCallsLastFrame());
+		report << wxString::Format("%.2fx\t%.2f ms\t%.2f ms\t%d\n", level, first_ms, average_ms, GetDrawCallsLastFrame());
+	}
+
+	SetZoom(old_zoom);
+	return report;
+}
+
 void MapCanvas::TakeScreenshot(wxFileName path, wxString format) {
 	int screensize_x, screensize_y;
 	GetViewBox(&view_scroll_x, &view_scroll_y, &screensize_x, &screensize_y);
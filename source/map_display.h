@@ -154,6 +154,8 @@ public:
 
 	void ShowPositionIndicator(const Position &position);
 	void TakeScreenshot(wxFileName path, wxString format);
+	// Draws the current view at several zoom levels and returns the frame times
+	wxString BenchmarkRendering();
 
 protected:
 	void getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, PositionVector* tilestodraw, PositionVector* tilestoborder, bool fill = false);
@@ -48,24 +48,18 @@
 #include "zone_brush.h"
 #include "light_drawer.h"
 
-// === Texture State Caching (Redundant State Filter) ===
-// Eliminates redundant glBindTexture calls when tiles use the same texture
-static GLuint g_currentTextureId = 0;
-static int g_textureBindsThisFrame = 0;
+// Sprite batch counters of the last complete frame (for telemetry)
 static int g_textureBindsLastFrame = 0;
+static int g_drawCallsLastFrame = 0;
 
-// Call at start of each frame to reset cache
-static void ResetTextureCache() {
-	g_currentTextureId = 0;
-	g_textureBindsLastFrame = g_textureBindsThisFrame;
-	g_textureBindsThisFrame = 0;
-}
-
-// Get binds from last complete frame (for telemetry)
 int GetTextureBindsLastFrame() {
 	return g_textureBindsLastFrame;
 }
 
+int GetDrawCallsLastFrame() {
+	return g_drawCallsLastFrame;
+}
+
 DrawingOptions::DrawingOptions() {
 	SetDefault();
 }
@@ -263,12 +257,16 @@ void MapDrawer::Release() {
 }
 
 void MapDrawer::Draw() {
-	// Reset texture cache at start of each frame
-	ResetTextureCache();
-	
+	// Pick up sheets the decode workers finished since the last frame
+	g_spriteAppearances.processDecodedSheets();
+	PrefetchSprites();
+
+	sprite_batch.begin();
+
 	DrawBackground();
 	DrawMap();
 	if (options.show_lights) {
+		sprite_batch.flush();
 		light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y);
 	}
 	DrawDraggingShadow();
@@ -289,6 +287,10 @@ void MapDrawer::Draw() {
 	if (should_draw_tooltips) {
 		DrawTooltips();
 	}
+
+	sprite_batch.end();
+	g_textureBindsLastFrame = sprite_batch.getTextureBindsLastFrame();
+	g_drawCallsLastFrame = sprite_batch.getDrawCallsLastFrame();
 }
 
 void MapDrawer::DrawBackground() {
@@ -305,6 +307,11 @@ void MapDrawer::DrawBackground() {
 	// glEnable(GL_ALPHA_TEST);
 }
 
+inline bool isAnimated(const Item* item) {
+	const GameSprite* sprite = g_items.getItemType(item->getID()).sprite;
+	return sprite && sprite->animator;
+}
+
 inline int getFloorAdjustment(int floor) {
 	if (floor > rme::MapGroundLayer) { // Underground
 		return 0; // No adjustment
@@ -315,37 +322,20 @@ inline int getFloorAdjustment(int floor) {
 
 void MapDrawer::DrawShade(int map_z) {
 	if (map_z == end_z && start_z != end_z) {
-		bool only_colors = options.isOnlyColors();
-		if (!only_colors) {
-			glDisable(GL_TEXTURE_2D);
-		}
-
 		// Ensure blending is enabled for transparency
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		float x = screensize_x * zoom;
-		float y = screensize_y * zoom;
-		glColor4ub(0, 0, 0, 128);
-		glBegin(GL_QUADS);
-		glVertex2f(0, y);
-		glVertex2f(x, y);
-		glVertex2f(x, 0);
-		glVertex2f(0, 0);
-		glEnd();
-
-		// Optional: Disable blending if it impacts other operations, though usually harmless/required.
-		// For safety in this specific drawing routine:
-		// glDisable(GL_BLEND); 
-
-		if (!only_colors) {
-			glEnable(GL_TEXTURE_2D);
-		}
+		sprite_batch.addRect(0, 0, screensize_x * zoom, screensize_y * zoom, 0, 0, 0, 128);
 	}
 }
 
 void MapDrawer::DrawMap() {
 	bool live_client = editor.IsLiveClient();
+	if (live_client) {
+		// Orders the node requests of this frame
+		editor.SetNodeViewport(start_x, start_y, end_x, end_y, floor > rme::MapGroundLayer);
+	}
 
 	Brush* brush = g_gui.GetCurrentBrush();
 
@@ -362,11 +352,19 @@ void MapDrawer::DrawMap() {
 	bool only_colors = options.isOnlyColors();
 	bool tile_indicators = options.isTileIndicators();
 
-	// === Z-Axis Occlusion Culling ===
-	// Track tiles that have been covered by opaque ground on higher floors
-	// Key: (X << 32) | Y, Value: presence in set = occluded
-	std::unordered_set<uint64_t> occluded_tiles;
-	occluded_tiles.reserve(8192);  // Pre-allocate for typical viewport
+	const bool use_render_cache = !live_client && canUseRenderCache();
+	if (use_render_cache) {
+		validateRenderCache();
+	} else if (!render_cache.empty()) {
+		render_cache.clear();
+	}
+	++render_frame;
+
+	// Lower floors are drawn first, so what hides them is worked out top-down before drawing anything
+	occlusion_active = !options.transparent_floors && !only_colors && start_z != end_z;
+	if (occlusion_active) {
+		BuildOcclusion();
+	}
 
 	for (int map_z = start_z; map_z >= superend_z; map_z--) {
 		if (options.show_shade) {
@@ -383,7 +381,118 @@ void MapDrawer::DrawMap() {
 			int nd_end_x = (end_x & ~3) + 4;
 			int nd_end_y = (end_y & ~3) + 4;
 
+			// The current floor has nothing above it
+			const bool occluded_floor = occlusion_active && map_z > end_z;
+
+			const auto drawLeaf = [&](QTreeNode* nd, int leaf_x, int leaf_y) {
+				if (occluded_floor && occlusion.isLeafHidden(leaf_x, leaf_y, map_z)) {
+					return;
+				}
+
+				// Only the occupied slots are visited, straight from the leaf's occupancy mask
+				nd->forEachTile(map_z, [&](TileLocation &location) {
+					const Position &pos = location.getPosition();
+					if (occluded_floor && occlusion.isTileHidden(pos.x, pos.y, map_z)) {
+						return;
+					}
+
+					DrawTile(&location);
+					// draw light, but only if not zoomed too far
+					if (options.show_lights && zoom <= 10) {
+						AddLight(&location);
+					}
+				});
+				if (tile_indicators) {
+					nd->forEachTile(map_z, [&](TileLocation &location) {
+						const Position &pos = location.getPosition();
+						if (!occluded_floor || !occlusion.isTileHidden(pos.x, pos.y, map_z)) {
+							DrawTileIndicators(&location);
+						}
+					});
+				}
+			};
+
+			const auto drawChunk = [&](int chunk_x, int chunk_y) {
+				if (g_gui.gfx.getTextureGeneration() != render_cache_state.texture_generation) {
+					// Some recorded quad may point at a deleted texture or a reused atlas slot
+					render_cache.clear();
+					render_cache_state.texture_generation = g_gui.gfx.getTextureGeneration();
+				}
+
+				const uint64_t key = (uint64_t(map_z) << 48) | ((uint64_t(chunk_x >> 2) & 0xFFFFFF) << 24) | (uint64_t(chunk_y / RenderChunkHeight) & 0xFFFFFF);
+				uint64_t fingerprint = fingerprintRenderChunk(chunk_x, chunk_y, map_z);
+				if (occluded_floor) {
+					// Which tiles are hidden depends on the floors above as well
+					fingerprint = (fingerprint ^ occlusion.getAreaHash(chunk_x, chunk_y, map_z, 4, RenderChunkHeight)) * 0x100000001b3ULL;
+				}
+
+				auto it = render_cache.find(key);
+				if (it != render_cache.end() && it->second.fingerprint == fingerprint) {
+					RenderChunk &chunk = it->second;
+					chunk.last_used = render_frame;
+					if (!chunk.animated) {
+						for (GLuint texture : chunk.textures) {
+							g_gui.gfx.touchTexture(texture);
+						}
+						sprite_batch.replay(chunk.quads, chunk.scroll_x - view_scroll_x, chunk.scroll_y - view_scroll_y);
+						return;
+					}
+
+					// Changes with every animation tick, so there is nothing worth keeping
+					for (int leaf_y = chunk_y; leaf_y < chunk_y + RenderChunkHeight; leaf_y += 4) {
+						if (QTreeNode* nd = editor.getMap().getLeaf(chunk_x, leaf_y)) {
+							drawLeaf(nd, chunk_x, leaf_y);
+						}
+					}
+					return;
+				}
+
+				RenderChunk &chunk = render_cache[key];
+				chunk.quads.clear();
+
+				render_chunk_complete = true;
+				render_chunk_animated = false;
+				sprite_batch.startRecording(&chunk.quads);
+				for (int leaf_y = chunk_y; leaf_y < chunk_y + RenderChunkHeight; leaf_y += 4) {
+					if (QTreeNode* nd = editor.getMap().getLeaf(chunk_x, leaf_y)) {
+						drawLeaf(nd, chunk_x, leaf_y);
+					}
+				}
+				sprite_batch.stopRecording();
+
+				if (!render_chunk_complete) {
+					// Placeholders for sheets still decoding, record it again once they're in
+					render_cache.erase(key);
+					return;
+				}
+
+				chunk.fingerprint = fingerprint;
+				chunk.scroll_x = view_scroll_x;
+				chunk.scroll_y = view_scroll_y;
+				chunk.last_used = render_frame;
+				chunk.animated = render_chunk_animated;
+				chunk.textures.clear();
+				if (chunk.animated) {
+					chunk.quads.clear();
+					chunk.quads.vertices.shrink_to_fit();
+				} else {
+					for (const SpriteBatch::Run &run : chunk.quads.runs) {
+						if (run.texture != 0 && std::find(chunk.textures.begin(), chunk.textures.end(), run.texture) == chunk.textures.end()) {
+							chunk.textures.push_back(run.texture);
+						}
+					}
+				}
+			};
+
 			for (int nd_map_x = nd_start_x; nd_map_x <= nd_end_x; nd_map_x += 4) {
+				if (use_render_cache) {
+					// Strips hold whole leaf columns, so drawing them top to bottom keeps the leaf order
+					for (int chunk_y = nd_start_y & ~(RenderChunkHeight - 1); chunk_y <= nd_end_y; chunk_y += RenderChunkHeight) {
+						drawChunk(nd_map_x, chunk_y);
+					}
+					continue;
+				}
+
 				for (int nd_map_y = nd_start_y; nd_map_y <= nd_end_y; nd_map_y += 4) {
 					QTreeNode* nd = editor.getMap().getLeaf(nd_map_x, nd_map_y);
 					if (!nd) {
@@ -395,48 +504,7 @@ void MapDrawer::DrawMap() {
 					}
 
 					if (!live_client || nd->isVisible(map_z > rme::MapGroundLayer)) {
-						for (int map_x = 0; map_x < 4; ++map_x) {
-							for (int map_y = 0; map_y < 4; ++map_y) {
-								TileLocation* location = nd->getTile(map_x, map_y, map_z);
-
-								// === Z-Axis Occlusion Culling ===
-								if (location && location->get()) {
-									Tile* tile = location->get();
-									const Position& pos = location->getPosition();
-									uint64_t tile_key = (uint64_t(pos.x) << 32) | uint64_t(pos.y);
-
-									// Check if this tile is occluded by an opaque ground above
-									bool is_occluded = occluded_tiles.find(tile_key) != occluded_tiles.end();
-
-									// Skip rendering if:
-									// 1. Tile is occluded by floor above
-									// 2. Not the current visible floor (always show current floor)
-									// 3. transparent_floors is disabled (user doesn't want to see through)
-									if (is_occluded && map_z < end_z && !options.transparent_floors) {
-										continue;  // Skip this tile - it's hidden by opaque ground above
-									}
-
-									// Mark this tile as occluding if it has opaque ground
-									// Safety: hasGround() filters out empty tiles (which are also isBlocking())
-									if (tile->hasGround() && tile->isBlocking()) {
-										occluded_tiles.insert(tile_key);
-									}
-								}
-
-								DrawTile(location);
-								// draw light, but only if not zoomed too far
-								if (location && options.show_lights && zoom <= 10) {
-									AddLight(location);
-								}
-							}
-						}
-						if (tile_indicators) {
-							for (int map_x = 0; map_x < 4; ++map_x) {
-								for (int map_y = 0; map_y < 4; ++map_y) {
-									DrawTileIndicators(nd->getTile(map_x, map_y, map_z));
-								}
-							}
-						}
+						drawLeaf(nd, nd_map_x, nd_map_y);
 					} else {
 						if (!nd->isRequested(map_z > rme::MapGroundLayer)) {
 							// Request the node
@@ -446,13 +514,7 @@ void MapDrawer::DrawMap() {
 						int cy = (nd_map_y)*rme::TileSize - view_scroll_y - getFloorAdjustment(floor);
 						int cx = (nd_map_x)*rme::TileSize - view_scroll_x - getFloorAdjustment(floor);
 
-						glColor4ub(255, 0, 255, 128);
-						glBegin(GL_QUADS);
-						glVertex2f(cx, cy + rme::TileSize * 4);
-						glVertex2f(cx + rme::TileSize * 4, cy + rme::TileSize * 4);
-						glVertex2f(cx + rme::TileSize * 4, cy);
-						glVertex2f(cx, cy);
-						glEnd();
+						sprite_batch.addRect(cx, cy, rme::TileSize * 4, rme::TileSize * 4, 255, 0, 255, 128);
 					}
 				}
 			}
@@ -476,6 +538,167 @@ void MapDrawer::DrawMap() {
 	if (!only_colors) {
 		glEnable(GL_TEXTURE_2D);
 	}
+
+	if (use_render_cache) {
+		trimRenderCache();
+	}
+}
+
+void MapDrawer::BuildOcclusion() {
+	// The leaf range of each floor grows by one tile per floor below the current one
+	const int spread = start_z - end_z;
+	const int min_x = (start_x - spread) & ~3;
+	const int min_y = (start_y - spread) & ~3;
+	const int max_x = ((end_x + spread) & ~3) + 7;
+	const int max_y = ((end_y + spread) & ~3) + 7;
+	occlusion.reset(min_x, min_y, max_x, max_y, end_z, start_z);
+
+	// The deepest floor hides nothing
+	for (int map_z = end_z; map_z < start_z; ++map_z) {
+		occlusion.beginFloor(map_z);
+		for (int nd_map_x = min_x; nd_map_x <= max_x; nd_map_x += 4) {
+			for (int nd_map_y = min_y; nd_map_y <= max_y; nd_map_y += 4) {
+				QTreeNode* nd = editor.getMap().getLeaf(nd_map_x, nd_map_y);
+				if (!nd) {
+					continue;
+				}
+				nd->forEachTile(map_z, [&](TileLocation &location) {
+					if (isOpaqueGround(location.get())) {
+						const Position &pos = location.getPosition();
+						occlusion.cover(pos.x, pos.y, map_z);
+					}
+				});
+			}
+		}
+	}
+}
+
+bool MapDrawer::isOpaqueGround(const Tile* tile) const {
+	if (!tile->ground || (options.show_only_modified && !tile->isModified())) {
+		return false;
+	}
+
+	// Translucent grounds and the tinted squares drawn for editor items let the floor below show through
+	const ItemType &type = g_items.getItemType(tile->ground->getID());
+	if (type.id == 0 || !type.sprite || type.isTranslucent || type.isMetaItem()) {
+		return false;
+	}
+	if (options.transparent_items && (type.sprite->getWidth() > 1 || type.sprite->getHeight() > 1)) {
+		return false;
+	}
+	return options.ingame || (type.id != ITEM_STAIRS && type.id != ITEM_NOTHING_SPECIAL);
+}
+
+bool MapDrawer::canUseRenderCache() const {
+	if (!g_settings.getBoolean(Config::MAP_RENDER_CACHE)) {
+		return false;
+	}
+	// Tooltips, lights and hook indicators are produced next to the quads and can't be replayed
+	if (options.isTooltips() || options.show_containers_with_items || options.show_hooks) {
+		return false;
+	}
+	return !options.show_lights || zoom > 10;
+}
+
+void MapDrawer::validateRenderCache() {
+	editor.getMap().trackAreaRevisions();
+
+	RenderCacheState state;
+	state.options = options;
+	state.zoom = zoom;
+	state.floor = floor;
+	state.house_id = current_house_id;
+	state.zone_id = g_gui.zone_brush ? g_gui.zone_brush->getZone() : 0;
+	state.texture_generation = g_gui.gfx.getTextureGeneration();
+	if (!(state == render_cache_state)) {
+		render_cache.clear();
+		render_cache_state = state;
+	}
+}
+
+uint64_t MapDrawer::fingerprintRenderChunk(int x, int y, int z) {
+	// Strips are aligned inside one tile area, whose revision is bumped by every edit that changes
+	// what is drawn there: tile swaps, selection, spawn radii, waypoints and house exits
+	const Map &map = editor.getMap();
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hash = (hash ^ map.getInstanceId()) * 0x100000001b3ULL;
+	hash = (hash ^ map.getAreaRevision(BaseMap::getTileAreaKey(x, y, z))) * 0x100000001b3ULL;
+	return hash;
+}
+
+void MapDrawer::trimRenderCache() {
+	if (render_cache.size() <= RenderCacheMaxChunks) {
+		return;
+	}
+
+	// Drop the strips that went longest without being drawn
+	std::vector<uint64_t> stamps;
+	stamps.reserve(render_cache.size());
+	for (const auto &entry : render_cache) {
+		stamps.push_back(entry.second.last_used);
+	}
+	const size_t excess = render_cache.size() - RenderCacheMaxChunks / 2;
+	std::nth_element(stamps.begin(), stamps.begin() + (excess - 1), stamps.end());
+	const uint64_t cutoff = stamps[excess - 1];
+
+	for (auto it = render_cache.begin(); it != render_cache.end();) {
+		if (it->second.last_used <= cutoff && it->second.last_used != render_frame) {
+			it = render_cache.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void MapDrawer::PrefetchSprites() {
+	const int range = g_settings.getInteger(Config::SPRITE_PREFETCH_RANGE);
+	if (range <= 0 || options.isOnlyColors() || !g_settings.getBoolean(Config::SPRITE_ASYNC_DECODE)) {
+		return;
+	}
+
+	const int area_start_x = std::max(0, start_x - range) & ~3;
+	const int area_start_y = std::max(0, start_y - range) & ~3;
+	const int area_end_x = std::min(rme::MapMaxWidth, end_x + range) & ~3;
+	const int area_end_y = std::min(rme::MapMaxHeight, end_y + range) & ~3;
+
+	// Only walk the area again once the view has moved into other leaves
+	const wxRect area(area_start_x, area_start_y, area_end_x - area_start_x, area_end_y - area_start_y);
+	if (area == prefetch_area && floor == prefetch_floor) {
+		return;
+	}
+	prefetch_area = area;
+	prefetch_floor = floor;
+
+	std::unordered_set<const GameSprite*> requested;
+	const auto prefetch = [&requested](const Item* item) {
+		const GameSprite* sprite = g_items.getItemType(item->getID()).sprite;
+		if (!sprite || !requested.insert(sprite).second) {
+			return;
+		}
+		for (const auto* image : sprite->spriteList) {
+			g_spriteAppearances.requestSpriteSheet(image->id, SheetPriority::Prefetch);
+		}
+	};
+
+	for (int map_z = start_z; map_z >= end_z; --map_z) {
+		for (int nd_map_x = area_start_x; nd_map_x <= area_end_x; nd_map_x += 4) {
+			for (int nd_map_y = area_start_y; nd_map_y <= area_end_y; nd_map_y += 4) {
+				QTreeNode* nd = editor.getMap().getLeaf(nd_map_x, nd_map_y);
+				if (!nd) {
+					continue;
+				}
+				nd->forEachTile(map_z, [&](TileLocation &location) {
+					const Tile* tile = location.get();
+					if (tile->ground) {
+						prefetch(tile->ground);
+					}
+					for (const Item* item : tile->items) {
+						prefetch(item);
+					}
+				});
+			}
+		}
+	}
 }
 
 void MapDrawer::DrawSecondaryMap(int map_z) {
@@ -643,24 +866,20 @@ void MapDrawer::DrawIngameBox() {
 }
 
 void MapDrawer::DrawGrid() {
-	glDisable(GL_TEXTURE_2D);
-	glColor4ub(255, 255, 255, 128);
-	glBegin(GL_LINES);
+	// Lines are batched as quads one screen pixel thick
+	const float thickness = zoom;
+	const float left = start_x * rme::TileSize - view_scroll_x;
+	const float top = start_y * rme::TileSize - view_scroll_y;
+	const float width = (end_x - start_x) * rme::TileSize;
+	const float height = (end_y - start_y) * rme::TileSize;
 
 	for (int y = start_y; y < end_y; ++y) {
-		int py = y * rme::TileSize - view_scroll_y;
-		glVertex2f(start_x * rme::TileSize - view_scroll_x, py);
-		glVertex2f(end_x * rme::TileSize - view_scroll_x, py);
+		sprite_batch.addRect(left, y * rme::TileSize - view_scroll_y, width, thickness, 255, 255, 255, 128);
 	}
 
 	for (int x = start_x; x < end_x; ++x) {
-		int px = x * rme::TileSize - view_scroll_x;
-		glVertex2f(px, start_y * rme::TileSize - view_scroll_y);
-		glVertex2f(px, end_y * rme::TileSize - view_scroll_y);
+		sprite_batch.addRect(x * rme::TileSize - view_scroll_x, top, thickness, height, 255, 255, 255, 128);
 	}
-
-	glEnd();
-	glEnable(GL_TEXTURE_2D);
 }
 
 void MapDrawer::DrawDraggingShadow() {
@@ -803,6 +1022,7 @@ void MapDrawer::DrawSelectionBox() {
 	lines[3][2] = last_click_rx;
 	lines[3][3] = last_click_ry;
 
+	sprite_batch.flush();
 	glDisable(GL_TEXTURE_2D);
 	glEnable(GL_LINE_STIPPLE);
 	glLineStipple(2, 0xAAAA);
@@ -852,13 +1072,7 @@ void MapDrawer::DrawLiveCursors() {
 		float draw_x = ((cursor.pos.x * rme::TileSize) - view_scroll_x) - offset;
 		float draw_y = ((cursor.pos.y * rme::TileSize) - view_scroll_y) - offset;
 
-		glColor(cursor.color);
-		glBegin(GL_QUADS);
-		glVertex2f(draw_x, draw_y);
-		glVertex2f(draw_x + rme::TileSize, draw_y);
-		glVertex2f(draw_x + rme::TileSize, draw_y + rme::TileSize);
-		glVertex2f(draw_x, draw_y + rme::TileSize);
-		glEnd();
+		sprite_batch.addRect(draw_x, draw_y, rme::TileSize, rme::TileSize, cursor.color.Red(), cursor.color.Green(), cursor.color.Blue(), cursor.color.Alpha());
 	}
 }
 
@@ -903,36 +1117,20 @@ void MapDrawer::DrawBrush() {
 			int delta_x = last_click_end_sx - last_click_start_sx;
 			int delta_y = last_click_end_sy - last_click_start_sy;
 
-			glColor(brushColor);
-			glBegin(GL_QUADS);
-			{
-				glVertex2f(last_click_start_sx, last_click_start_sy + rme::TileSize);
-				glVertex2f(last_click_end_sx, last_click_start_sy + rme::TileSize);
-				glVertex2f(last_click_end_sx, last_click_start_sy);
-				glVertex2f(last_click_start_sx, last_click_start_sy);
-			}
+			const wxColor color = getBrushColor(brushColor);
+			drawFilledRect(last_click_start_sx, last_click_start_sy, delta_x, rme::TileSize, color);
 
 			if (delta_y > rme::TileSize) {
-				glVertex2f(last_click_start_sx, last_click_end_sy - rme::TileSize);
-				glVertex2f(last_click_start_sx + rme::TileSize, last_click_end_sy - rme::TileSize);
-				glVertex2f(last_click_start_sx + rme::TileSize, last_click_start_sy + rme::TileSize);
-				glVertex2f(last_click_start_sx, last_click_start_sy + rme::TileSize);
+				drawFilledRect(last_click_start_sx, last_click_start_sy + rme::TileSize, rme::TileSize, delta_y - 2 * rme::TileSize, color);
 			}
 
 			if (delta_x > rme::TileSize && delta_y > rme::TileSize) {
-				glVertex2f(last_click_end_sx - rme::TileSize, last_click_start_sy + rme::TileSize);
-				glVertex2f(last_click_end_sx, last_click_start_sy + rme::TileSize);
-				glVertex2f(last_click_end_sx, last_click_end_sy - rme::TileSize);
-				glVertex2f(last_click_end_sx - rme::TileSize, last_click_end_sy - rme::TileSize);
+				drawFilledRect(last_click_end_sx - rme::TileSize, last_click_start_sy + rme::TileSize, rme::TileSize, delta_y - 2 * rme::TileSize, color);
 			}
 
 			if (delta_y > rme::TileSize) {
-				glVertex2f(last_click_start_sx, last_click_end_sy - rme::TileSize);
-				glVertex2f(last_click_end_sx, last_click_end_sy - rme::TileSize);
-				glVertex2f(last_click_end_sx, last_click_end_sy);
-				glVertex2f(last_click_start_sx, last_click_end_sy);
+				drawFilledRect(last_click_start_sx, last_click_end_sy - rme::TileSize, delta_x, rme::TileSize, color);
 			}
-			glEnd();
 		} else {
 			if (brush->isRaw()) {
 				glEnable(GL_TEXTURE_2D);
@@ -985,13 +1183,7 @@ void MapDrawer::DrawBrush() {
 					int last_click_end_sx = last_click_end_map_x * rme::TileSize - view_scroll_x - adjustment;
 					int last_click_end_sy = last_click_end_map_y * rme::TileSize - view_scroll_y - adjustment;
 
-					glColor(brushColor);
-					glBegin(GL_QUADS);
-					glVertex2f(last_click_start_sx, last_click_start_sy);
-					glVertex2f(last_click_end_sx, last_click_start_sy);
-					glVertex2f(last_click_end_sx, last_click_end_sy);
-					glVertex2f(last_click_start_sx, last_click_end_sy);
-					glEnd();
+					drawFilledRect(last_click_start_sx, last_click_start_sy, last_click_end_sx - last_click_start_sx, last_click_end_sy - last_click_start_sy, getBrushColor(brushColor));
 				}
 			} else if (g_gui.GetBrushShape() == BRUSHSHAPE_CIRCLE) {
 				// Calculate drawing offsets
@@ -1040,13 +1232,7 @@ void MapDrawer::DrawBrush() {
 							if (brush->isRaw()) {
 								BlitSpriteType(cx, cy, raw_brush->getItemType()->sprite, 160, 160, 160, 160);
 							} else {
-								glColor(brushColor);
-								glBegin(GL_QUADS);
-								glVertex2f(cx, cy + rme::TileSize);
-								glVertex2f(cx + rme::TileSize, cy + rme::TileSize);
-								glVertex2f(cx + rme::TileSize, cy);
-								glVertex2f(cx, cy);
-								glEnd();
+								drawFilledRect(cx, cy, rme::TileSize, rme::TileSize, getBrushColor(brushColor));
 							}
 						}
 					}
@@ -1072,47 +1258,25 @@ void MapDrawer::DrawBrush() {
 			int delta_x = end_sx - start_sx;
 			int delta_y = end_sy - start_sy;
 
-			glColor(brushColor);
-			glBegin(GL_QUADS);
-			{
-				glVertex2f(start_sx, start_sy + rme::TileSize);
-				glVertex2f(end_sx, start_sy + rme::TileSize);
-				glVertex2f(end_sx, start_sy);
-				glVertex2f(start_sx, start_sy);
-			}
+			const wxColor color = getBrushColor(brushColor);
+			drawFilledRect(start_sx, start_sy, delta_x, rme::TileSize, color);
 
 			if (delta_y > rme::TileSize) {
-				glVertex2f(start_sx, end_sy - rme::TileSize);
-				glVertex2f(start_sx + rme::TileSize, end_sy - rme::TileSize);
-				glVertex2f(start_sx + rme::TileSize, start_sy + rme::TileSize);
-				glVertex2f(start_sx, start_sy + rme::TileSize);
+				drawFilledRect(start_sx, start_sy + rme::TileSize, rme::TileSize, delta_y - 2 * rme::TileSize, color);
 			}
 
 			if (delta_x > rme::TileSize && delta_y > rme::TileSize) {
-				glVertex2f(end_sx - rme::TileSize, start_sy + rme::TileSize);
-				glVertex2f(end_sx, start_sy + rme::TileSize);
-				glVertex2f(end_sx, end_sy - rme::TileSize);
-				glVertex2f(end_sx - rme::TileSize, end_sy - rme::TileSize);
+				drawFilledRect(end_sx - rme::TileSize, start_sy + rme::TileSize, rme::TileSize, delta_y - 2 * rme::TileSize, color);
 			}
 
 			if (delta_y > rme::TileSize) {
-				glVertex2f(start_sx, end_sy - rme::TileSize);
-				glVertex2f(end_sx, end_sy - rme::TileSize);
-				glVertex2f(end_sx, end_sy);
-				glVertex2f(start_sx, end_sy);
+				drawFilledRect(start_sx, end_sy - rme::TileSize, delta_x, rme::TileSize, color);
 			}
-			glEnd();
 		} else if (brush->isDoor()) {
 			int cx = (mouse_map_x)*rme::TileSize - view_scroll_x - adjustment;
 			int cy = (mouse_map_y)*rme::TileSize - view_scroll_y - adjustment;
 
-			glColorCheck(brush, Position(mouse_map_x, mouse_map_y, floor));
-			glBegin(GL_QUADS);
-			glVertex2f(cx, cy + rme::TileSize);
-			glVertex2f(cx + rme::TileSize, cy + rme::TileSize);
-			glVertex2f(cx + rme::TileSize, cy);
-			glVertex2f(cx, cy);
-			glEnd();
+			drawFilledRect(cx, cy, rme::TileSize, rme::TileSize, getCheckColor(brush, Position(mouse_map_x, mouse_map_y, floor)));
 		} else if (brush->isMonster()) {
 			glEnable(GL_TEXTURE_2D);
 			int cy = (mouse_map_y)*rme::TileSize - view_scroll_y - adjustment;
@@ -1159,17 +1323,10 @@ void MapDrawer::DrawBrush() {
 									DrawBrushIndicator(cx, cy, brush, r, g, b);
 								} else {
 									if (brush->isHouseExit() || brush->isOptionalBorder()) {
-										glColorCheck(brush, Position(mouse_map_x + x, mouse_map_y + y, floor));
+										drawFilledRect(cx, cy, rme::TileSize, rme::TileSize, getCheckColor(brush, Position(mouse_map_x + x, mouse_map_y + y, floor)));
 									} else {
-										glColor(brushColor);
+										drawFilledRect(cx, cy, rme::TileSize, rme::TileSize, getBrushColor(brushColor));
 									}
-
-									glBegin(GL_QUADS);
-									glVertex2f(cx, cy + rme::TileSize);
-									glVertex2f(cx + rme::TileSize, cy + rme::TileSize);
-									glVertex2f(cx + rme::TileSize, cy);
-									glVertex2f(cx, cy);
-									glEnd();
 								}
 							}
 						}
@@ -1185,17 +1342,10 @@ void MapDrawer::DrawBrush() {
 									DrawBrushIndicator(cx, cy, brush, r, g, b);
 								} else {
 									if (brush->isHouseExit() || brush->isOptionalBorder()) {
-										glColorCheck(brush, Position(mouse_map_x + x, mouse_map_y + y, floor));
+										drawFilledRect(cx, cy, rme::TileSize, rme::TileSize, getCheckColor(brush, Position(mouse_map_x + x, mouse_map_y + y, floor)));
 									} else {
-										glColor(brushColor);
+										drawFilledRect(cx, cy, rme::TileSize, rme::TileSize, getBrushColor(brushColor));
 									}
-
-									glBegin(GL_QUADS);
-									glVertex2f(cx, cy + rme::TileSize);
-									glVertex2f(cx + rme::TileSize, cy + rme::TileSize);
-									glVertex2f(cx + rme::TileSize, cy);
-									glVertex2f(cx, cy);
-									glEnd();
 								}
 							}
 						}
@@ -1301,8 +1451,10 @@ void MapDrawer::BlitItem(int &draw_x, int &draw_y, const Tile* tile, const Item*
 	}
 
 	int frame = item->getFrame();
-	int texnum = sprite->getHardwareID(0, subtype, pattern_x, pattern_y, pattern_z, frame);
-	glBlitTexture(screenx, screeny, texnum, red, green, blue, alpha);
+	AtlasRegion region;
+	if (sprite->getAtlasRegion(0, subtype, pattern_x, pattern_y, pattern_z, frame, region)) {
+		glBlitAtlas(screenx, screeny, region, red, green, blue, alpha);
+	}
 
 	if (options.show_hooks && (type.hookSouth || type.hookEast || type.hook != ITEM_HOOK_NONE)) {
 		DrawHookIndicator(draw_x, draw_y, type);
@@ -1399,8 +1551,10 @@ void MapDrawer::BlitItem(int &draw_x, int &draw_y, const Position &pos, const It
 	}
 
 	int frame = item->getFrame();
-	int texnum = sprite->getHardwareID(0, subtype, pattern_x, pattern_y, pattern_z, frame);
-	glBlitTexture(screenx, screeny, texnum, red, green, blue, alpha);
+	AtlasRegion region;
+	if (sprite->getAtlasRegion(0, subtype, pattern_x, pattern_y, pattern_z, frame, region)) {
+		glBlitAtlas(screenx, screeny, region, red, green, blue, alpha);
+	}
 
 	if (options.show_hooks && (type.hookSouth || type.hookEast) && zoom <= 3.0) {
 		DrawHookIndicator(draw_x, draw_y, type);
@@ -1425,9 +1579,10 @@ void MapDrawer::BlitSpriteType(int screenx, int screeny, uint32_t spriteid, int
 	screenx -= sprite->getDrawOffset().x;
 	screeny -= sprite->getDrawOffset().y;
 
-	int frame = 0;
-	int texnum = sprite->getHardwareID(0, -1, 0, 0, 0, 0);
-	glBlitTexture(screenx, screeny, texnum, red, green, blue, alpha);
+	AtlasRegion region;
+	if (sprite->getAtlasRegion(0, -1, 0, 0, 0, 0, region)) {
+		glBlitAtlas(screenx, screeny, region, red, green, blue, alpha);
+	}
 }
 
 void MapDrawer::BlitSpriteType(int screenx, int screeny, GameSprite* sprite, int red, int green, int blue, int alpha) {
@@ -1438,9 +1593,10 @@ void MapDrawer::BlitSpriteType(int screenx, int screeny, GameSprite* sprite, int
 	screenx -= sprite->getDrawOffset().x;
 	screeny -= sprite->getDrawOffset().y;
 
-	int frame = 0;
-	int texnum = sprite->getHardwareID(0, -1, 0, 0, 0, 0);
-	glBlitTexture(screenx, screeny, texnum, red, green, blue, alpha);
+	AtlasRegion region;
+	if (sprite->getAtlasRegion(0, -1, 0, 0, 0, 0, region)) {
+		glBlitAtlas(screenx, screeny, region, red, green, blue, alpha);
+	}
 }
 
 void MapDrawer::BlitCreature(int screenx, int screeny, const Outfit &outfit, const Direction &dir, int red, int green, int blue, int alpha) {
@@ -1693,6 +1849,7 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		} else {
 			if (options.show_preview && zoom <= 2.0) {
 				tile->ground->animate();
+				render_chunk_animated = render_chunk_animated || isAnimated(tile->ground);
 			}
 
 			BlitItem(draw_x, draw_y, tile, tile->ground, false, r, g, b);
@@ -1728,6 +1885,7 @@ void MapDrawer::DrawTile(TileLocation* location) {
 
 			if (options.show_preview && zoom <= 2.0) {
 				item->animate();
+				render_chunk_animated = render_chunk_animated || isAnimated(item);
 			}
 
 			if (item->isBorder()) {
@@ -1789,6 +1947,8 @@ void MapDrawer::DrawBrushIndicator(int x, int y, Brush* brush, uint8_t r, uint8_
 		{ -15, -20 }, // 0
 	};
 
+	sprite_batch.flush();
+
 	// circle
 	glBegin(GL_TRIANGLE_FAN);
 	glColor4ub(0x00, 0x00, 0x00, 0x50);
@@ -1819,6 +1979,7 @@ void MapDrawer::DrawBrushIndicator(int x, int y, Brush* brush, uint8_t r, uint8_
 }
 
 void MapDrawer::DrawHookIndicator(int x, int y, const ItemType &type) {
+	sprite_batch.flush();
 	glDisable(GL_TEXTURE_2D);
 	glColor4ub(uint8_t(0), uint8_t(0), uint8_t(255), uint8_t(200));
 	glBegin(GL_QUADS);
@@ -1970,6 +2131,7 @@ void MapDrawer::DrawTooltips() {
 		return;
 	}
 
+	sprite_batch.flush();
 	glDisable(GL_TEXTURE_2D);
 
 	for (MapTooltip* tooltip : tooltips) {
@@ -2200,52 +2362,25 @@ void MapDrawer::glBlitTexture(int sx, int sy, int textureId, int red, int green,
 		spdlog::debug("Blitting outfit {} at ({}, {})", outfit.name, sx, sy);
 	}
 
-	// Texture State Caching: Only bind if different from current
-	if (g_currentTextureId != textureId) {
-		glBindTexture(GL_TEXTURE_2D, textureId);
-		g_currentTextureId = textureId;
-		g_textureBindsThisFrame++;
-	}
-	
-	glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.f, 0.f);
-	glVertex2f(sx, sy);
-	glTexCoord2f(1.f, 0.f);
-	glVertex2f(sx + width, sy);
-	glTexCoord2f(1.f, 1.f);
-	glVertex2f(sx + width, sy + height);
-	glTexCoord2f(0.f, 1.f);
-	glVertex2f(sx, sy + height);
-	glEnd();
+	sprite_batch.add(textureId, sx, sy, width, height, red, green, blue, alpha);
 }
 
-void MapDrawer::glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size /* = rme::TileSize */) const {
-	const auto dx = static_cast<double>(x);
-	const auto dy = static_cast<double>(y);
-	const auto dSize = static_cast<double>(size);
-
-	glColor4ub(red, green, blue, alpha);
-	glBegin(GL_QUADS);
-	glVertex2f(dx, dy);
-	glVertex2f(dx + dSize, dy);
-	glVertex2f(dx + dSize, dy + dSize);
-	glVertex2f(dx, dy + dSize);
-	glEnd();
+void MapDrawer::glBlitAtlas(int x, int y, const AtlasRegion &region, int red, int green, int blue, int alpha) {
+	if (region.texture == 0) {
+		// Sheet is still decoding, hold the sprite's place with a faint box
+		render_chunk_complete = false;
+		sprite_batch.addRect(x, y, region.width, region.height, red / 2, green / 2, blue / 2, alpha / 4);
+		return;
+	}
+	sprite_batch.add(region.texture, x, y, region.width, region.height, red, green, blue, alpha, region.u0, region.v0, region.u1, region.v1);
 }
 
-void MapDrawer::glBlitSquare(int x, int y, const wxColor &color, int size /* = rme::TileSize */) const {
-	const auto dx = static_cast<double>(x);
-	const auto dy = static_cast<double>(y);
-	const auto dSize = static_cast<double>(size);
+void MapDrawer::glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size /* = rme::TileSize */) {
+	sprite_batch.addRect(x, y, size, size, red, green, blue, alpha);
+}
 
-	glColor4ub(color.Red(), color.Green(), color.Blue(), color.Alpha());
-	glBegin(GL_QUADS);
-	glVertex2f(dx, dy);
-	glVertex2f(dx + dSize, dy);
-	glVertex2f(dx + dSize, dy + dSize);
-	glVertex2f(dx, dy + dSize);
-	glEnd();
+void MapDrawer::glBlitSquare(int x, int y, const wxColor &color, int size /* = rme::TileSize */) {
+	sprite_batch.addRect(x, y, size, size, color.Red(), color.Green(), color.Blue(), color.Alpha());
 }
 
 void MapDrawer::glColor(const wxColor &color) {
@@ -2253,61 +2388,55 @@ void MapDrawer::glColor(const wxColor &color) {
 }
 
 void MapDrawer::glColor(MapDrawer::BrushColor color) {
+	glColor(getBrushColor(color));
+}
+
+void MapDrawer::glColorCheck(Brush* brush, const Position &pos) {
+	glColor(getCheckColor(brush, pos));
+}
+
+wxColor MapDrawer::getBrushColor(MapDrawer::BrushColor color) const {
 	switch (color) {
 		case COLOR_BRUSH:
-			glColor4ub(
+			return wxColor(
 				g_settings.getInteger(Config::CURSOR_RED),
 				g_settings.getInteger(Config::CURSOR_GREEN),
 				g_settings.getInteger(Config::CURSOR_BLUE),
 				g_settings.getInteger(Config::CURSOR_ALPHA)
 			);
-			break;
 
 		case COLOR_FLAG_BRUSH:
 		case COLOR_HOUSE_BRUSH:
-			glColor4ub(
+			return wxColor(
 				g_settings.getInteger(Config::CURSOR_ALT_RED),
 				g_settings.getInteger(Config::CURSOR_ALT_GREEN),
 				g_settings.getInteger(Config::CURSOR_ALT_BLUE),
 				g_settings.getInteger(Config::CURSOR_ALT_ALPHA)
 			);
-			break;
 
 		case COLOR_SPAWN_BRUSH:
-			glColor4ub(166, 0, 0, 128);
-			break;
-
 		case COLOR_SPAWN_NPC_BRUSH:
-			glColor4ub(166, 0, 0, 128);
-			break;
-
 		case COLOR_ERASER:
-			glColor4ub(166, 0, 0, 128);
-			break;
+		case COLOR_INVALID:
+			return wxColor(166, 0, 0, 128);
 
 		case COLOR_VALID:
-			glColor4ub(0, 166, 0, 128);
-			break;
-
-		case COLOR_INVALID:
-			glColor4ub(166, 0, 0, 128);
-			break;
+			return wxColor(0, 166, 0, 128);
 
 		default:
-			glColor4ub(255, 255, 255, 128);
-			break;
+			return wxColor(255, 255, 255, 128);
 	}
 }
 
-void MapDrawer::glColorCheck(Brush* brush, const Position &pos) {
+wxColor MapDrawer::getCheckColor(Brush* brush, const Position &pos) {
 	if (brush->canDraw(&editor.getMap(), pos)) {
-		glColor(COLOR_VALID);
-	} else {
-		glColor(COLOR_INVALID);
+		return getBrushColor(COLOR_VALID);
 	}
+	return getBrushColor(COLOR_INVALID);
 }
 
 void MapDrawer::drawRect(int x, int y, int w, int h, const wxColor &color, int width) {
+	sprite_batch.flush();
 	glLineWidth(width);
 	glColor4ub(color.Red(), color.Green(), color.Blue(), color.Alpha());
 	glBegin(GL_LINE_STRIP);
@@ -2320,13 +2449,7 @@ void MapDrawer::drawRect(int x, int y, int w, int h, const wxColor &color, int w
 }
 
 void MapDrawer::drawFilledRect(int x, int y, int w, int h, const wxColor &color) {
-	glColor4ub(color.Red(), color.Green(), color.Blue(), color.Alpha());
-	glBegin(GL_QUADS);
-	glVertex2f(x, y);
-	glVertex2f(x + w, y);
-	glVertex2f(x + w, y + h);
-	glVertex2f(x, y + h);
-	glEnd();
+	sprite_batch.addRect(x, y, w, h, color.Red(), color.Green(), color.Blue(), color.Alpha());
 }
 
 void MapDrawer::getDrawPosition(const Position &position, int &x, int &y) {
@@ -18,7 +18,11 @@
 #ifndef RME_MAP_DRAWER_H_
 #define RME_MAP_DRAWER_H_
 
+#include "sprite_batch.h"
+#include "occlusion_grid.h"
+
 class GameSprite;
+struct AtlasRegion;
 
 struct MapTooltip {
 	enum TextLength {
@@ -55,6 +59,8 @@ public:
 	bool isTileIndicators() const noexcept;
 	bool isTooltips() const noexcept;
 
+	bool operator==(const DrawingOptions &other) const = default;
+
 	bool transparent_floors;
 	bool transparent_items;
 	bool show_ingame_box;
@@ -97,6 +103,7 @@ class MapDrawer {
 	Editor &editor;
 	DrawingOptions options;
 	std::shared_ptr<LightDrawer> light_drawer;
+	SpriteBatch sprite_batch;
 
 	float zoom;
 
@@ -110,6 +117,45 @@ class MapDrawer {
 	int tile_size;
 	int floor;
 
+	// Area last walked for sprite prefetching, in 4x4 leaf steps
+	wxRect prefetch_area;
+	int prefetch_floor = -1;
+
+	// Quads of a 4x32 tile strip of one floor, strips are drawn in the same order as the leaves they cover
+	struct RenderChunk {
+		SpriteBatch::Recording quads;
+		std::vector<GLuint> textures;
+		uint64_t fingerprint = 0;
+		int scroll_x = 0;
+		int scroll_y = 0;
+		uint64_t last_used = 0;
+		bool animated = false;
+	};
+	// Everything outside the tiles themselves that changes how a strip is drawn
+	struct RenderCacheState {
+		DrawingOptions options;
+		float zoom = 0.f;
+		int floor = -1;
+		uint32_t house_id = 0;
+		unsigned int zone_id = 0;
+		uint32_t texture_generation = 0;
+
+		bool operator==(const RenderCacheState &other) const = default;
+	};
+	static constexpr int RenderChunkHeight = 32;
+	static constexpr size_t RenderCacheMaxChunks = 4096;
+
+	std::unordered_map<uint64_t, RenderChunk> render_cache;
+	RenderCacheState render_cache_state;
+	uint64_t render_frame = 0;
+	// Tiles of the lower floors hidden under opaque ground, rebuilt every frame
+	OcclusionGrid occlusion;
+	bool occlusion_active = false;
+
+	// Cleared while a strip is recorded if it can't be replayed later
+	bool render_chunk_complete = true;
+	bool render_chunk_animated = false;
+
 protected:
 	std::vector<MapTooltip*> tooltips;
 	std::ostringstream tooltip;
@@ -141,6 +187,7 @@ public:
 	void DrawIngameBox();
 	void DrawGrid();
 	void DrawTooltips();
+	void PrefetchSprites();
 
 	void TakeScreenshot(uint8_t* screenshot_buffer);
 
@@ -156,6 +203,9 @@ public:
 	DrawingOptions &getOptions() noexcept {
 		return options;
 	}
+	void ClearRenderCache() {
+		render_cache.clear();
+	}
 
 protected:
 	void BlitItem(int &screenx, int &screeny, const Tile* tile, const Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255);
@@ -193,16 +243,27 @@ protected:
 
 	void getColor(Brush* brush, const Position &position, uint8_t &r, uint8_t &g, uint8_t &b);
 	void glBlitTexture(int x, int y, int textureId, int red, int green, int blue, int alpha, bool adjustZoom = false, bool isEditorSprite = false, const Outfit &outfit = {}, int spriteId = 0);
-	void glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size = rme::TileSize) const;
-	void glBlitSquare(int x, int y, const wxColor &color, int size = rme::TileSize) const;
+	void glBlitAtlas(int x, int y, const AtlasRegion &region, int red, int green, int blue, int alpha);
+	void glBlitSquare(int x, int y, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, int size = rme::TileSize);
+	void glBlitSquare(int x, int y, const wxColor &color, int size = rme::TileSize);
 	void glColor(const wxColor &color);
 	void glColor(BrushColor color);
 	void glColorCheck(Brush* brush, const Position &pos);
+	wxColor getBrushColor(BrushColor color) const;
+	wxColor getCheckColor(Brush* brush, const Position &pos);
 	void drawRect(int x, int y, int w, int h, const wxColor &color, int width = 1);
 	void drawFilledRect(int x, int y, int w, int h, const wxColor &color);
 
 private:
 	void getDrawPosition(const Position &position, int &x, int &y);
+
+	void BuildOcclusion();
+	bool isOpaqueGround(const Tile* tile) const;
+
+	bool canUseRenderCache() const;
+	void validateRenderCache();
+	uint64_t fingerprintRenderChunk(int x, int y, int z);
+	void trimRenderCache();
 };
 
 #endif
@@ -79,6 +79,7 @@ QTreeNode::QTreeNode(BaseMap &map) :
 	// Doesn't matter if we're leaf or node
 	for (int i = 0; i < rme::MapLayers; ++i) {
 		child[i] = nullptr;
+		occupied[i] = 0;
 	}
 }
 
@@ -129,11 +130,11 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 
 		} else {
 			if (level == 0) {
-				qt = newd QTreeNode(map);
+				qt = map.allocator.allocateNode(map);
 				qt->isLeaf = true;
 				return qt;
 			} else {
-				qt = newd QTreeNode(map);
+				qt = map.allocator.allocateNode(map);
 			}
 		}
 		node = node->child[index];
@@ -148,7 +149,7 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 Floor* QTreeNode::createFloor(int x, int y, int z) {
 	ASSERT(isLeaf);
 	if (!array[z]) {
-		array[z] = newd Floor(x, y, z);
+		array[z] = map.allocator.allocateFloor(x, y, z);
 	}
 	return array[z];
 }
@@ -243,6 +244,13 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	Tile* oldtile = tmp->tile;
 	tmp->tile = newtile;
 
+	const uint16_t bit = 1 << (offset_x * 4 + offset_y);
+	if (newtile) {
+		occupied[z] |= bit;
+	} else {
+		occupied[z] &= ~bit;
+	}
+
 	if (newtile && !oldtile) {
 		++map.tilecount;
 	} else if (oldtile && !newtile) {
@@ -262,4 +270,32 @@ void QTreeNode::clearTile(int x, int y, int z) {
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
 	delete tmp->tile;
 	tmp->tile = map.allocator(tmp);
+	occupied[z] |= 1 << (offset_x * 4 + offset_y);
+}
+
+//**************** LeafPageTable **********************
+
+LeafPageTable::LeafPageTable() :
+	directory(newd QTreeNode**[DirectorySide * DirectorySide]()),
+	pages(0) {
+	////
+}
+
+LeafPageTable::~LeafPageTable() {
+	// The leaves are owned by the QTree
+	for (int i = 0; i < DirectorySide * DirectorySide; ++i) {
+		delete[] directory[i];
+	}
+	delete[] directory;
+}
+
+void LeafPageTable::set(int x, int y, QTreeNode* leaf) {
+	const uint32_t lx = (static_cast<uint32_t>(x) & 0xFFFF) >> 2;
+	const uint32_t ly = (static_cast<uint32_t>(y) & 0xFFFF) >> 2;
+	QTreeNode**&page = directory[(lx >> PageBits) * DirectorySide + (ly >> PageBits)];
+	if (!page) {
+		page = newd QTreeNode*[PageSide * PageSide]();
+		++pages;
+	}
+	page[(lx & (PageSide - 1)) * PageSide + (ly & (PageSide - 1))] = leaf;
 }
@@ -20,6 +20,9 @@
 
 #include "const.h"
 #include "position.h"
+#include "map_allocator.h"
+
+#include <bit>
 
 class Tile;
 class Floor;
@@ -107,14 +110,14 @@ public:
 	friend class Waypoints;
 };
 
-class Floor {
+class Floor : public MapArenaObject {
 public:
 	Floor(int x, int y, int z);
 	TileLocation locs[rme::MapLayers];
 };
 
 // This is not a QuadTree, but a HexTree (16 child nodes to every node), so the name is abit misleading
-class QTreeNode {
+class QTreeNode : public MapArenaObject {
 public:
 	QTreeNode(BaseMap &map);
 	virtual ~QTreeNode();
@@ -140,6 +143,36 @@ public:
 		return array;
 	}
 
+	// Occupied tile slots of a floor, bit (x & 3) * 4 + (y & 3) is set when the slot holds a tile
+	uint16_t getOccupancy(uint32_t z) const {
+		ASSERT(isLeaf);
+		return occupied[z];
+	}
+	// Calls fn(TileLocation&) for every slot on floor z that holds a tile, in the same x/y order as a 4x4 scan
+	template <typename F>
+	void forEachTile(uint32_t z, F &&fn) {
+		ASSERT(isLeaf);
+		uint32_t mask = occupied[z];
+		while (mask != 0) {
+			fn(array[z]->locs[std::countr_zero(mask)]);
+			mask &= mask - 1;
+		}
+	}
+
+	// Visits every leaf below this node in tree order
+	template <typename F>
+	void forEachLeaf(F &&fn) {
+		if (isLeaf) {
+			fn(*this);
+			return;
+		}
+		for (QTreeNode* node : child) {
+			if (node) {
+				node->forEachLeaf(fn);
+			}
+		}
+	}
+
 	void setVisible(bool overground, bool underground);
 	void setVisible(uint32_t client, bool underground, bool value);
 	bool isVisible(uint32_t client, bool underground);
@@ -162,9 +195,47 @@ protected:
 		// #    error "You need to rewrite the QuadTree in order to handle more or less than 16 floors"
 		// #endif
 	};
+	// Kept next to the floor pointers so iterating a leaf never has to touch empty floors or slots
+	uint16_t occupied[rme::MapLayers];
 
 	friend class BaseMap;
 	friend class MapIterator;
 };
 
+// Direct-indexed lookup of QTree leaves, an alternative to descending the tree for every tile.
+// Leaf coordinates (16-bit tile coordinates >> 2) are split into a directory index and a page index,
+// so a lookup is at most two dependent loads. Pages are only allocated where leaves exist.
+class LeafPageTable {
+public:
+	static constexpr int PageBits = 7; // 128x128 leaves (512x512 tiles) per page
+	static constexpr int PageSide = 1 << PageBits;
+	static constexpr int DirectorySide = (0x10000 >> 2) / PageSide;
+
+	LeafPageTable();
+	~LeafPageTable();
+
+	LeafPageTable(const LeafPageTable &) = delete;
+	LeafPageTable &operator=(const LeafPageTable &) = delete;
+
+	// Coordinates are tile coordinates, like QTreeNode::getLeaf
+	QTreeNode* get(int x, int y) const noexcept {
+		const uint32_t lx = (static_cast<uint32_t>(x) & 0xFFFF) >> 2;
+		const uint32_t ly = (static_cast<uint32_t>(y) & 0xFFFF) >> 2;
+		QTreeNode** page = directory[(lx >> PageBits) * DirectorySide + (ly >> PageBits)];
+		if (!page) {
+			return nullptr;
+		}
+		return page[(lx & (PageSide - 1)) * PageSide + (ly & (PageSide - 1))];
+	}
+	void set(int x, int y, QTreeNode* leaf);
+
+	size_t getPageCount() const noexcept {
+		return pages;
+	}
+
+private:
+	QTreeNode*** directory;
+	size_t pages;
+};
+
 #endif
@@ -44,17 +44,57 @@ void Materials::clear() {
 	}
 
 	tilesets.clear();
+	prefetched.clear();
+}
+
+FileName Materials::getIncludeFileName(const FileName &filename, pugi::xml_node node) {
+	FileName includeName;
+	includeName.SetPath(filename.GetPath());
+	includeName.SetName(wxString(node.attribute("file").as_string(), wxConvUTF8));
+	return includeName;
+}
+
+void Materials::prefetchMaterials(const FileName &identifier) {
+	std::vector<FileName> pending = { identifier };
+	while (!pending.empty()) {
+		const FileName filename = pending.back();
+		pending.pop_back();
+		const std::string path = filename.GetFullPath().ToStdString();
+		if (prefetched.contains(path)) {
+			continue;
+		}
+
+		auto doc = std::make_unique<pugi::xml_document>();
+		if (!doc->load_file(filename.GetFullPath().mb_str())) {
+			// loadMaterials reads it again and reports the error
+			continue;
+		}
+
+		for (pugi::xml_node childNode = doc->child("materials").first_child(); childNode; childNode = childNode.next_sibling()) {
+			if (as_lower_str(childNode.name()) == "include" && childNode.attribute("file")) {
+				pending.push_back(getIncludeFileName(filename, childNode));
+			}
+		}
+		prefetched[path] = std::move(doc);
+	}
 }
 
 bool Materials::loadMaterials(const FileName &identifier, wxString &error, wxArrayString &warnings) {
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(identifier.GetFullPath().mb_str());
-	if (!result) {
-		warnings.push_back("Could not open " + identifier.GetFullName() + " (file not found or syntax error)");
-		return false;
+	std::unique_ptr<pugi::xml_document> doc;
+	const auto it = prefetched.find(identifier.GetFullPath().ToStdString());
+	if (it != prefetched.end()) {
+		doc = std::move(it->second);
+		prefetched.erase(it);
+	} else {
+		doc = std::make_unique<pugi::xml_document>();
+		pugi::xml_parse_result result = doc->load_file(identifier.GetFullPath().mb_str());
+		if (!result) {
+			warnings.push_back("Could not open " + identifier.GetFullName() + " (file not found or syntax error)");
+			return false;
+		}
 	}
 
-	pugi::xml_node node = doc.child("materials");
+	pugi::xml_node node = doc->child("materials");
 	if (!node) {
 		warnings.push_back(identifier.GetFullName() + ": Invalid rootheader.");
 		return false;
@@ -74,9 +114,7 @@ bool Materials::unserializeMaterials(const FileName &filename, pugi::xml_node no
 				continue;
 			}
 
-			FileName includeName;
-			includeName.SetPath(filename.GetPath());
-			includeName.SetName(wxString(attribute.as_string(), wxConvUTF8));
+			const FileName includeName = getIncludeFileName(filename, childNode);
 
 			wxString subError;
 			if (!loadMaterials(includeName, subError, warnings)) {
@@ -32,6 +32,8 @@ public:
 	TilesetContainer tilesets;
 
 	bool loadMaterials(const FileName &identifier, wxString &error, wxArrayString &warnings);
+	// Parses identifier and everything it includes ahead of loadMaterials, touches nothing else so it can run on a worker thread
+	void prefetchMaterials(const FileName &identifier);
 	void createOtherTileset();
 	void addToTileset(std::string tilesetName, int itemId, TilesetCategoryType categoryType);
 	void createNpcTileset();
@@ -51,7 +53,11 @@ protected:
 	bool unserializeTileset(pugi::xml_node node, wxArrayString &warnings);
 
 private:
+	static FileName getIncludeFileName(const FileName &filename, pugi::xml_node node);
+
 	bool modified = false;
+	// Parsed by prefetchMaterials, keyed by full path, each one is taken by the loadMaterials call for its file
+	std::map<std::string, std::unique_ptr<pugi::xml_document>> prefetched;
 	Materials(const Materials &);
 	Materials &operator=(const Materials &);
 };
@@ -39,14 +39,15 @@ MinimapWindow::MinimapWindow(wxWindow* parent) :
 	wxPanel(parent, wxID_ANY, wxDefaultPosition, wxSize(205, 130)),
 	update_timer(this) {
 	for (int i = 0; i < 256; ++i) {
-		pens[i] = new wxPen(colorFromEightBit(i));
+		const wxColor color = colorFromEightBit(i);
+		palette[i][0] = color.Red();
+		palette[i][1] = color.Green();
+		palette[i][2] = color.Blue();
 	}
 }
 
 MinimapWindow::~MinimapWindow() {
-	for (int i = 0; i < 256; ++i) {
-		delete pens[i];
-	}
+	////
 }
 
 void MinimapWindow::OnSize(wxSizeEvent &event) {
@@ -77,7 +78,7 @@ void MinimapWindow::OnPaint(wxPaintEvent &event) {
 		return;
 	}
 	Editor &editor = *g_gui.GetCurrentEditor();
-	const Map &map = editor.getMap();
+	Map &map = editor.getMap();
 
 	int window_width = GetSize().GetWidth();
 	int window_height = GetSize().GetHeight();
@@ -120,23 +121,37 @@ void MinimapWindow::OnPaint(wxPaintEvent &event) {
 
 	int floor = g_gui.GetCurrentFloor();
 
-	// printf("Draw from %d:%d to %d:%d\n", start_x, start_y, end_x, end_y);
-	uint8_t last = 0;
 	if (g_gui.IsRenderingEnabled()) {
-		for (int y = start_y, window_y = 0; y <= end_y; ++y, ++window_y) {
-			for (int x = start_x, window_x = 0; x <= end_x; ++x, ++window_x) {
-				const Tile* tile = map.getTile(x, y, floor);
-				if (tile) {
-					uint8_t color = tile->getMiniMapColor();
-					if (color) {
-						if (last != color) {
-							pdc.SetPen(*pens[color]);
-							last = color;
-						}
-						pdc.DrawPoint(window_x, window_y);
+		if (cached_map_id != map.getInstanceId()) {
+			blocks.clear();
+			cached_map_id = map.getInstanceId();
+			map.trackAreaRevisions();
+		}
+		++frame;
+
+		// Compose the visible part of the cached blocks and draw it in one go
+		const int width = std::max(0, end_x - start_x);
+		const int height = std::max(0, end_y - start_y);
+		if (width > 0 && height > 0) {
+			frame_pixels.assign(static_cast<size_t>(width) * height * 3, 0);
+			for (int block_y = start_y / BlockSize; block_y * BlockSize < start_y + height; ++block_y) {
+				for (int block_x = start_x / BlockSize; block_x * BlockSize < start_x + width; ++block_x) {
+					const CachedBlock &block = getBlock(map, block_x, block_y, floor);
+					const int from_x = std::max(start_x, block_x * BlockSize);
+					const int to_x = std::min(start_x + width, (block_x + 1) * BlockSize);
+					const int from_y = std::max(start_y, block_y * BlockSize);
+					const int to_y = std::min(start_y + height, (block_y + 1) * BlockSize);
+					for (int y = from_y; y < to_y; ++y) {
+						const uint8_t* source = &block.pixels[((y % BlockSize) * BlockSize + from_x % BlockSize) * 3];
+						uint8_t* target = &frame_pixels[((y - start_y) * width + (from_x - start_x)) * 3];
+						std::copy_n(source, (to_x - from_x) * 3, target);
 					}
 				}
 			}
+			trimCache();
+
+			wxImage image(width, height, frame_pixels.data(), true);
+			pdc.DrawBitmap(wxBitmap(image), 0, 0);
 		}
 
 		if (g_settings.getInteger(Config::MINIMAP_VIEW_BOX)) {
@@ -175,6 +190,51 @@ void MinimapWindow::OnPaint(wxPaintEvent &event) {
 	}
 }
 
+const MinimapWindow::CachedBlock &MinimapWindow::getBlock(Map &map, int block_x, int block_y, int floor) {
+	const int base_x = block_x * BlockSize;
+	const int base_y = block_y * BlockSize;
+	const uint32_t key = BaseMap::getTileAreaKey(base_x, base_y, floor);
+	const uint32_t revision = map.getAreaRevision(key);
+
+	CachedBlock &block = blocks[key];
+	block.last_used = frame;
+	if (!block.pixels.empty() && block.revision == revision) {
+		return block;
+	}
+
+	block.revision = revision;
+	block.pixels.assign(BlockSize * BlockSize * 3, 0);
+	for (int y = 0; y < BlockSize; y += 4) {
+		for (int x = 0; x < BlockSize; x += 4) {
+			QTreeNode* leaf = map.getLeaf(base_x + x, base_y + y);
+			if (!leaf) {
+				continue;
+			}
+			leaf->forEachTile(floor, [&](TileLocation &location) {
+				const Tile* tile = location.get();
+				const uint8_t color = tile ? tile->getMiniMapColor() : 0;
+				if (color == 0) {
+					return;
+				}
+				const Position &position = location.getPosition();
+				std::copy_n(palette[color], 3, &block.pixels[((position.y % BlockSize) * BlockSize + position.x % BlockSize) * 3]);
+			});
+		}
+	}
+	return block;
+}
+
+void MinimapWindow::trimCache() {
+	// Drop the least recently drawn blocks, the visible ones were all touched this frame
+	while (blocks.size() > MaxCachedBlocks) {
+		auto oldest = std::ranges::min_element(blocks, {}, [](const auto &entry) { return entry.second.last_used; });
+		if (oldest->second.last_used == frame) {
+			break;
+		}
+		blocks.erase(oldest);
+	}
+}
+
 void MinimapWindow::OnMouseClick(wxMouseEvent &event) {
 	if (!g_gui.IsEditorOpen()) {
 		return;
@@ -18,6 +18,8 @@
 #ifndef RME_MINIMAP_WINDOW_H_
 #define RME_MINIMAP_WINDOW_H_
 
+class Map;
+
 class MinimapWindow : public wxPanel {
 public:
 	MinimapWindow(wxWindow* parent);
@@ -34,11 +36,28 @@ public:
 	void OnKey(wxKeyEvent &event);
 
 protected:
-	wxPen* pens[256];
+	// One 256x256 tile area of a floor rasterized to RGB, rebuilt when the area's revision moves on
+	struct CachedBlock {
+		uint32_t revision = 0;
+		uint64_t last_used = 0;
+		std::vector<uint8_t> pixels;
+	};
+	static constexpr int BlockSize = 256;
+	static constexpr size_t MaxCachedBlocks = 64;
+
+	const CachedBlock &getBlock(Map &map, int block_x, int block_y, int floor);
+	void trimCache();
+
+	uint8_t palette[256][3];
 	wxTimer update_timer;
 	int last_start_x;
 	int last_start_y;
 
+	std::unordered_map<uint32_t, CachedBlock> blocks;
+	uint64_t cached_map_id = 0;
+	uint64_t frame = 0;
+	std::vector<uint8_t> frame_pixels;
+
 	DECLARE_EVENT_TABLE()
 };
 
@@ -231,7 +231,10 @@ bool MonsterDatabase::loadFromXML(const FileName &filename, bool standard, wxStr
 		error = "Couldn't open file \"" + filename.GetFullName() + "\", invalid format?";
 		return false;
 	}
+	return loadFromXML(doc, standard, error, warnings);
+}
 
+bool MonsterDatabase::loadFromXML(const pugi::xml_document &doc, bool standard, wxString &error, wxArrayString &warnings) {
 	pugi::xml_node node = doc.child("monsters");
 	if (!node) {
 		error = "Invalid file signature, this file is not a valid monsters file.";
@@ -69,6 +69,22 @@ void NetworkMessage::write<Position>(const Position &value) {
 	write<uint8_t>(value.z);
 }
 
+void NetworkMessage::writeLongString(const std::string &value) {
+	const size_t length = value.length();
+	write<uint32_t>(length);
+
+	expand(length);
+	memcpy(&buffer[position], value.data(), length);
+	position += length;
+}
+
+std::string NetworkMessage::readLongString() {
+	const uint32_t length = read<uint32_t>();
+	char* strBuffer = reinterpret_cast<char*>(&buffer[position]);
+	position += length;
+	return std::string(strBuffer, length);
+}
+
 // NetworkConnection
 NetworkConnection::NetworkConnection() :
 	service(nullptr), thread(), stopped(false) {
@@ -47,6 +47,10 @@ struct NetworkMessage {
 		position += sizeof(T);
 	}
 
+	// 32 bit length prefix, for payloads that can outgrow a string
+	void writeLongString(const std::string &value);
+	std::string readLongString();
+
 	//
 	std::vector<uint8_t> buffer;
 	size_t position;
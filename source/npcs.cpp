@@ -219,7 +219,10 @@ bool NpcDatabase::loadFromXML(const FileName &filename, bool standard, wxString
 		error = "Couldn't open file \"" + filename.GetFullName() + "\", invalid format?";
 		return false;
 	}
+	return loadFromXML(doc, standard, error, warnings);
+}
 
+bool NpcDatabase::loadFromXML(const pugi::xml_document &doc, bool standard, wxString &error, wxArrayString &warnings) {
 	pugi::xml_node node = doc.child("npcs");
 	if (!node) {
 		error = "Invalid file signature, this file is not a valid npc file.";
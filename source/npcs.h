@@ -54,6 +54,7 @@ public:
 	}
 
 	bool loadFromXML(const FileName &filename, bool standard, wxString &error, wxArrayString &warnings);
+	bool loadFromXML(const pugi::xml_document &doc, bool standard, wxString &error, wxArrayString &warnings);
 	bool importXMLFromOT(const FileName &filename, wxString &error, wxArrayString &warnings);
 
 	bool saveToXML(const FileName &filename);
@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "occlusion_grid.h"
+
+void OcclusionGrid::reset(int min_x, int min_y, int max_x, int max_y, int top_z, int bottom_z) {
+	first_z = top_z;
+	layers = std::max(0, bottom_z - first_z + 1);
+	// One extra cell on the top left for the neighbours of the first tiles
+	origin_x = min_x + first_z - 1;
+	origin_y = min_y + first_z - 1;
+	width = std::max(0, max_x - min_x + 2 + layers);
+	height = std::max(0, max_y - min_y + 2 + layers);
+	words_per_row = (width + 63) / 64;
+	bits.assign(static_cast<size_t>(layers) * height * words_per_row, 0);
+}
+
+void OcclusionGrid::beginFloor(int z) {
+	const int layer = z - first_z;
+	if (layer < 0 || layer + 1 >= layers) {
+		return;
+	}
+	const size_t layer_size = static_cast<size_t>(height) * words_per_row;
+	std::copy_n(bits.begin() + layer * layer_size, layer_size, bits.begin() + (layer + 1) * layer_size);
+}
+
+void OcclusionGrid::cover(int x, int y, int z) {
+	const int layer = z - first_z + 1;
+	const int cell_x = x + z - origin_x;
+	const int cell_y = y + z - origin_y;
+	if (layer < 1 || layer >= layers || cell_x < 0 || cell_x >= width || cell_y < 0 || cell_y >= height) {
+		return;
+	}
+	bits[(static_cast<size_t>(layer) * height + cell_y) * words_per_row + (cell_x >> 6)] |= uint64_t(1) << (cell_x & 63);
+}
+
+uint32_t OcclusionGrid::getRowBits(int cell_x, int cell_y, int layer, int count) const {
+	if (layer < 0 || layer >= layers || cell_y < 0 || cell_y >= height) {
+		return 0;
+	}
+
+	const uint64_t* row = &bits[(static_cast<size_t>(layer) * height + cell_y) * words_per_row];
+	uint32_t result = 0;
+	for (int i = 0; i < count; ++i) {
+		const int cell = cell_x + i;
+		if (cell >= 0 && cell < width && (row[cell >> 6] >> (cell & 63)) & 1) {
+			result |= 1u << i;
+		}
+	}
+	return result;
+}
+
+bool OcclusionGrid::isTileHidden(int x, int y, int z) const {
+	const int layer = z - first_z;
+	const int cell_x = x + z - origin_x;
+	const int cell_y = y + z - origin_y;
+	return getRowBits(cell_x - 1, cell_y - 1, layer, 2) == 0x3 && getRowBits(cell_x - 1, cell_y, layer, 2) == 0x3;
+}
+
+bool OcclusionGrid::isLeafHidden(int x, int y, int z) const {
+	const int layer = z - first_z;
+	const int cell_x = x + z - origin_x;
+	const int cell_y = y + z - origin_y;
+	for (int row = cell_y - 1; row < cell_y + 4; ++row) {
+		if (getRowBits(cell_x - 1, row, layer, 5) != 0x1F) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t OcclusionGrid::getAreaHash(int x, int y, int z, int area_width, int area_height) const {
+	const int layer = z - first_z;
+	const int cell_x = x + z - origin_x;
+	const int cell_y = y + z - origin_y;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int row = cell_y - 1; row < cell_y + area_height; ++row) {
+		hash = (hash ^ getRowBits(cell_x - 1, row, layer, area_width + 1)) * 0x100000001b3ULL;
+	}
+	return hash;
+}
@@ -0,0 +1,54 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_OCCLUSION_GRID_H_
+#define RME_OCCLUSION_GRID_H_
+
+// Screen cells hidden by opaque ground of the floors above, one bit per tile and one layer per drawn floor.
+// The perspective puts tile (x, y, z) on cell (x + z, y + z), so every floor reads the same grid shifted by its z.
+// Sprites reach one tile up and left of their own, so a tile only counts as hidden when those cells are hidden too.
+class OcclusionGrid {
+public:
+	// Empties the grid for tiles min..max on floors top_z (the topmost one drawn) down to bottom_z
+	void reset(int min_x, int min_y, int max_x, int max_y, int top_z, int bottom_z);
+
+	// Starts the coverage of floor z, which inherits everything that already hides z
+	void beginFloor(int z);
+	// Marks the cell of tile (x, y, z) as hidden for every floor below z, between beginFloor(z) and the next one
+	void cover(int x, int y, int z);
+
+	bool isTileHidden(int x, int y, int z) const;
+	// True if no tile of the 4x4 leaf at (x, y) can show
+	bool isLeafHidden(int x, int y, int z) const;
+	// Hash of the cells deciding which tiles of the area are hidden
+	uint64_t getAreaHash(int x, int y, int z, int width, int height) const;
+
+private:
+	// Bits of count (up to 32) consecutive cells of a row, cells outside the grid are never hidden
+	uint32_t getRowBits(int cell_x, int cell_y, int layer, int count) const;
+
+	int origin_x = 0;
+	int origin_y = 0;
+	int width = 0;
+	int height = 0;
+	int first_z = 0;
+	int layers = 0;
+	int words_per_row = 0;
+	std::vector<uint64_t> bits;
+};
+
+#endif
@@ -96,6 +96,21 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	use_old_item_properties_window->SetToolTip("Enables the use of the old item properties window");
 	sizer->Add(use_old_item_properties_window, 0, wxLEFT | wxTOP, 5);
 
+	map_page_table_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Use direct tile lookup table");
+	map_page_table_chkbox->SetValue(g_settings.getInteger(Config::MAP_PAGE_TABLE) == 1);
+	map_page_table_chkbox->SetToolTip("Indexes the map in a page table for faster tile lookups, at the cost of some memory. Applies to maps opened or created afterwards.");
+	sizer->Add(map_page_table_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	undo_disk_spill_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Move old undo steps to disk");
+	undo_disk_spill_chkbox->SetValue(g_settings.getInteger(Config::UNDO_DISK_SPILL) == 1);
+	undo_disk_spill_chkbox->SetToolTip("When the undo queue exceeds its memory limit, old steps are compressed and moved to a temporary file instead of being discarded.");
+	sizer->Add(undo_disk_spill_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	datapack_cache_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Cache loaded data files");
+	datapack_cache_chkbox->SetValue(g_settings.getInteger(Config::DATAPACK_CACHE) == 1);
+	datapack_cache_chkbox->SetToolTip("Keeps what items.xml, monsters.xml and npcs.xml define in a binary file so startup doesn't parse them again until they change. Applies on the next start.");
+	sizer->Add(datapack_cache_chkbox, 0, wxLEFT | wxTOP, 5);
+
 	sizer->AddSpacer(10);
 
 	auto* grid_sizer = newd wxFlexGridSizer(2, 10, 10);
@@ -255,6 +270,21 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	sizer->Add(hide_items_when_zoomed_chkbox, 0, wxLEFT | wxTOP, 5);
 	SetWindowToolTip(hide_items_when_zoomed_chkbox, "When this option is checked, \"loose\" items will be hidden when you zoom very far out.");
 
+	sprite_async_decode_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Decode sprite sheets in the background");
+	sprite_async_decode_chkbox->SetValue(g_settings.getBoolean(Config::SPRITE_ASYNC_DECODE));
+	sizer->Add(sprite_async_decode_chkbox, 0, wxLEFT | wxTOP, 5);
+	SetWindowToolTip(sprite_async_decode_chkbox, "Sprites whose sheet isn't decoded yet are drawn as placeholders instead of stalling the map view.");
+
+	sprite_disk_cache_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Cache decoded sprite sheets on disk");
+	sprite_disk_cache_chkbox->SetValue(g_settings.getBoolean(Config::SPRITE_DISK_CACHE));
+	sizer->Add(sprite_disk_cache_chkbox, 0, wxLEFT | wxTOP, 5);
+	SetWindowToolTip(sprite_disk_cache_chkbox, "Stores every decoded sprite sheet in the local data directory so it loads instantly next time. Takes about 600 KB per sheet. Applies the next time the client assets are loaded.");
+
+	map_render_cache_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Cache drawn map areas");
+	map_render_cache_chkbox->SetValue(g_settings.getBoolean(Config::MAP_RENDER_CACHE));
+	sizer->Add(map_render_cache_chkbox, 0, wxLEFT | wxTOP, 5);
+	SetWindowToolTip(map_render_cache_chkbox, "Keeps the sprites of unchanged map areas between frames, so scrolling and redrawing an idle view is much cheaper.");
+
 	icon_selection_shadow_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Use icon selection shadow");
 	icon_selection_shadow_chkbox->SetValue(g_settings.getBoolean(Config::USE_GUI_SELECTION_SHADOW));
 	sizer->Add(icon_selection_shadow_chkbox, 0, wxLEFT | wxTOP, 5);
@@ -294,6 +324,11 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	subsizer->Add(icon_background_choice, 0);
 	SetWindowToolTip(icon_background_choice, tmp, "This will change the background color on icons in all windows.");
 
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Sprite prefetch range: "), 0);
+	sprite_prefetch_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::SPRITE_PREFETCH_RANGE)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 64);
+	subsizer->Add(sprite_prefetch_spin, 0);
+	SetWindowToolTip(sprite_prefetch_spin, tmp, "Sprite sheets of items up to this many tiles outside the view are decoded in the background ahead of time. 0 disables prefetching.");
+
 	// Cursor colors
 	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Cursor color: "), 0);
 	subsizer->Add(cursor_color_pick = newd wxColourPickerCtrl(graphics_page, wxID_ANY, wxColor(g_settings.getInteger(Config::CURSOR_RED), g_settings.getInteger(Config::CURSOR_GREEN), g_settings.getInteger(Config::CURSOR_BLUE), g_settings.getInteger(Config::CURSOR_ALPHA))), 0);
@@ -608,6 +643,9 @@ void PreferencesWindow::Apply() {
 	g_settings.setInteger(Config::UNDO_SIZE, undo_size_spin->GetValue());
 	g_settings.setInteger(Config::UNDO_MEM_SIZE, undo_mem_size_spin->GetValue());
 	g_settings.setInteger(Config::WORKER_THREADS, worker_threads_spin->GetValue());
+	g_settings.setInteger(Config::MAP_PAGE_TABLE, map_page_table_chkbox->GetValue());
+	g_settings.setInteger(Config::UNDO_DISK_SPILL, undo_disk_spill_chkbox->GetValue());
+	g_settings.setInteger(Config::DATAPACK_CACHE, datapack_cache_chkbox->GetValue());
 	g_settings.setInteger(Config::REPLACE_SIZE, replace_size_spin->GetValue());
 	g_settings.setInteger(Config::DELETE_BACKUP_DAYS, delete_backup_days_spin->GetValue());
 	g_settings.setInteger(Config::COPY_POSITION_FORMAT, position_format->GetSelection());
@@ -678,6 +716,10 @@ void PreferencesWindow::Apply() {
 	// g_settings.setInteger(Config::CURSOR_ALT_ALPHA, clr.Alpha());
 
 	g_settings.setInteger(Config::HIDE_ITEMS_WHEN_ZOOMED, hide_items_when_zoomed_chkbox->GetValue());
+	g_settings.setInteger(Config::SPRITE_ASYNC_DECODE, sprite_async_decode_chkbox->GetValue());
+	g_settings.setInteger(Config::SPRITE_DISK_CACHE, sprite_disk_cache_chkbox->GetValue());
+	g_settings.setInteger(Config::MAP_RENDER_CACHE, map_render_cache_chkbox->GetValue());
+	g_settings.setInteger(Config::SPRITE_PREFETCH_RANGE, sprite_prefetch_spin->GetValue());
 	/*
 	g_settings.setInteger(Config::TEXTURE_MANAGEMENT, texture_managment_chkbox->GetValue());
 	g_settings.setInteger(Config::TEXTURE_CLEAN_PULSE, clean_interval_spin->GetValue());
@@ -49,6 +49,9 @@ protected:
 	wxCheckBox* show_welcome_dialog_chkbox;
 	wxCheckBox* enable_tileset_editing_chkbox;
 	wxCheckBox* use_old_item_properties_window;
+	wxCheckBox* map_page_table_chkbox;
+	wxCheckBox* undo_disk_spill_chkbox;
+	wxCheckBox* datapack_cache_chkbox;
 	wxSpinCtrl* undo_size_spin;
 	wxSpinCtrl* undo_mem_size_spin;
 	wxSpinCtrl* worker_threads_spin;
@@ -78,6 +81,10 @@ protected:
 	wxDirPickerCtrl* screenshot_directory_picker;
 	wxChoice* screenshot_format_choice;
 	wxCheckBox* hide_items_when_zoomed_chkbox;
+	wxCheckBox* sprite_async_decode_chkbox;
+	wxCheckBox* sprite_disk_cache_chkbox;
+	wxCheckBox* map_render_cache_chkbox;
+	wxSpinCtrl* sprite_prefetch_spin;
 	wxColourPickerCtrl* cursor_color_pick;
 	wxColourPickerCtrl* cursor_alt_color_pick;
 	wxTextCtrl* palette_icons_col_size;
@@ -324,6 +324,7 @@ void Selection::clear() {
 	} else {
 		for (Tile* tile : tiles) {
 			tile->deselect();
+			editor.getMap().markAreaDirty(tile->getPosition());
 		}
 		tiles.clear();
 	}
@@ -231,10 +231,13 @@ void Settings::IO(IOMode mode) {
 	section("Editor");
 	String(RECENT_FILES, "");
 	Int(WORKER_THREADS, 1);
+	Int(MAP_PAGE_TABLE, 1);
+	Int(DATAPACK_CACHE, 1); // Binary snapshot of items, monsters and npcs in the local data directory
 	Int(MERGE_MOVE, 0);
 	Int(MERGE_PASTE, 0);
 	Int(UNDO_SIZE, 2000); // Increased for modern systems (was 400)
 	Int(UNDO_MEM_SIZE, 2048); // 2GB for modern systems (was 40MB)
+	Int(UNDO_DISK_SPILL, 1);
 	Int(GROUP_ACTIONS, 1);
 	Int(SELECTION_TYPE, SELECT_CURRENT_FLOOR);
 	Int(COMPENSATED_SELECT, 1);
@@ -282,6 +285,11 @@ void Settings::IO(IOMode mode) {
 	Int(TEXTURE_CLEAN_PULSE, 15);
 	Int(TEXTURE_LONGEVITY, 20);
 	Int(TEXTURE_CLEAN_THRESHOLD, 2500);
+	Int(TEXTURE_ATLAS_PAGES, 64); // 1024x1024 pages kept before the least recently used one is evicted
+	Int(SPRITE_ASYNC_DECODE, 1);
+	Int(SPRITE_PREFETCH_RANGE, 0); // Tiles around the viewport whose sprite sheets are decoded ahead of time
+	Int(SPRITE_DISK_CACHE, 1); // Keep decoded sprite sheets in the local data directory
+	Int(MAP_RENDER_CACHE, 1);
 	Int(SOFTWARE_CLEAN_THRESHOLD, 1800);
 	Int(SOFTWARE_CLEAN_SIZE, 500);
 	Int(ICON_BACKGROUND, 0);
@@ -33,6 +33,11 @@ namespace Config {
 		TEXTURE_CLEAN_PULSE,
 		TEXTURE_CLEAN_THRESHOLD,
 		TEXTURE_LONGEVITY,
+		TEXTURE_ATLAS_PAGES,
+		SPRITE_ASYNC_DECODE,
+		SPRITE_PREFETCH_RANGE,
+		SPRITE_DISK_CACHE,
+		MAP_RENDER_CACHE,
 		HARD_REFRESH_RATE,
 		SOFTWARE_CLEAN_THRESHOLD,
 		SOFTWARE_CLEAN_SIZE,
@@ -70,6 +75,7 @@ namespace Config {
 		ZOOM_SPEED,
 		UNDO_SIZE,
 		UNDO_MEM_SIZE,
+		UNDO_DISK_SPILL,
 		MERGE_PASTE,
 		SELECTION_TYPE,
 		COMPENSATED_SELECT,
@@ -144,6 +150,8 @@ namespace Config {
 		LISTBOX_EATS_ALL_EVENTS,
 		RAW_LIKE_SIMONE,
 		WORKER_THREADS,
+		MAP_PAGE_TABLE,
+		DATAPACK_CACHE,
 		COPY_POSITION_FORMAT,
 		COPY_AREA_FORMAT,
 
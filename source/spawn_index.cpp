@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "spawn_index.h"
+
+template <typename F>
+void SpawnIndex::forEachCell(const Position &center, int radius, F &&fn) {
+	// Arithmetic shift, areas may reach past the map's top left edge
+	const int start_x = (center.x - radius) >> CellShift;
+	const int start_y = (center.y - radius) >> CellShift;
+	const int end_x = (center.x + radius) >> CellShift;
+	const int end_y = (center.y + radius) >> CellShift;
+	for (int y = start_y; y <= end_y; ++y) {
+		for (int x = start_x; x <= end_x; ++x) {
+			fn(getCellKey(x, y, center.z));
+		}
+	}
+}
+
+void SpawnIndex::insert(const Position &center, int radius) {
+	erase(center);
+	radii.emplace(center, radius);
+	forEachCell(center, radius, [&](uint64_t key) {
+		cells[key].push_back({ center, radius });
+	});
+}
+
+void SpawnIndex::erase(const Position &center) {
+	const auto it = radii.find(center);
+	if (it == radii.end()) {
+		return;
+	}
+
+	forEachCell(center, it->second, [&](uint64_t key) {
+		const auto cell = cells.find(key);
+		if (cell == cells.end()) {
+			return;
+		}
+		std::erase_if(cell->second, [&center](const Entry &entry) { return entry.center == center; });
+		if (cell->second.empty()) {
+			cells.erase(cell);
+		}
+	});
+	radii.erase(it);
+}
+
+void SpawnIndex::clear() {
+	cells.clear();
+	radii.clear();
+}
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPAWN_INDEX_H_
+#define RME_SPAWN_INDEX_H_
+
+#include "position.h"
+
+// Uniform grid of spawn areas per floor. Each spawn is listed in every cell its square touches,
+// so the spawns covering a tile are one cell lookup away instead of a scan of the tiles around it.
+class SpawnIndex {
+public:
+	void insert(const Position &center, int radius);
+	void erase(const Position &center);
+	void clear();
+
+	// Calls fn(center) for every spawn whose area covers position
+	template <typename F>
+	void forEachCovering(const Position &position, F &&fn) const;
+
+private:
+	static constexpr int CellShift = 5; // 32x32 tiles
+
+	struct Entry {
+		Position center;
+		int radius;
+	};
+
+	static uint64_t getCellKey(int cell_x, int cell_y, int z) noexcept {
+		return (static_cast<uint64_t>(z & 0xFF) << 48) | (static_cast<uint64_t>(static_cast<uint32_t>(cell_y) & 0xFFFFFF) << 24) | (static_cast<uint32_t>(cell_x) & 0xFFFFFF);
+	}
+
+	template <typename F>
+	void forEachCell(const Position &center, int radius, F &&fn);
+
+	std::unordered_map<uint64_t, std::vector<Entry>> cells;
+	std::map<Position, int> radii;
+};
+
+template <typename F>
+void SpawnIndex::forEachCovering(const Position &position, F &&fn) const {
+	const auto it = cells.find(getCellKey(position.x >> CellShift, position.y >> CellShift, position.z));
+	if (it == cells.end()) {
+		return;
+	}
+	for (const Entry &entry : it->second) {
+		if (std::abs(entry.center.x - position.x) <= entry.radius && std::abs(entry.center.y - position.y) <= entry.radius) {
+			fn(entry.center);
+		}
+	}
+}
+
+#endif
@@ -37,11 +37,13 @@ void SpawnsMonster::addSpawnMonster(Tile* tile) {
 
 	auto it = spawnsMonster.insert(tile->getPosition());
 	ASSERT(it.second);
+	index.insert(tile->getPosition(), tile->spawnMonster->getSize());
 }
 
 void SpawnsMonster::removeSpawnMonster(Tile* tile) {
 	ASSERT(tile->spawnMonster);
 	spawnsMonster.erase(tile->getPosition());
+	index.erase(tile->getPosition());
 #if 0
 	SpawnMonsterPositionList::iterator iter = begin();
 	while(iter != end()) {
@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_MONSTER_H_
 #define RME_SPAWN_MONSTER_H_
 
+#include "spawn_index.h"
+
 class Tile;
 
 class SpawnMonster {
@@ -78,15 +80,23 @@ public:
 	SpawnMonsterPositionList::const_iterator end() const noexcept {
 		return spawnsMonster.end();
 	}
-	void erase(SpawnMonsterPositionList::iterator iter) noexcept {
+	void erase(SpawnMonsterPositionList::iterator iter) {
+		index.erase(*iter);
 		spawnsMonster.erase(iter);
 	}
 	SpawnMonsterPositionList::iterator find(Position &pos) {
 		return spawnsMonster.find(pos);
 	}
 
+	// Calls fn(center) for every spawn whose area covers position
+	template <typename F>
+	void forEachCovering(const Position &position, F &&fn) const {
+		index.forEachCovering(position, std::forward<F>(fn));
+	}
+
 private:
 	SpawnMonsterPositionList spawnsMonster;
+	SpawnIndex index;
 };
 
 #endif
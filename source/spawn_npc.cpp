@@ -37,11 +37,13 @@ void SpawnsNpc::addSpawnNpc(Tile* tile) {
 
 	auto it = spawnsNpc.insert(tile->getPosition());
 	ASSERT(it.second);
+	index.insert(tile->getPosition(), tile->spawnNpc->getSize());
 }
 
 void SpawnsNpc::removeSpawnNpc(Tile* tile) {
 	ASSERT(tile->spawnNpc);
 	spawnsNpc.erase(tile->getPosition());
+	index.erase(tile->getPosition());
 #if 0
 	SpawnNpcPositionList::iterator iter = begin();
 	while(iter != end()) {
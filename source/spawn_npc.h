@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_NPC_H_
 #define RME_SPAWN_NPC_H_
 
+#include "spawn_index.h"
+
 class Tile;
 
 class SpawnNpc {
@@ -78,15 +80,23 @@ public:
 	SpawnNpcPositionList::const_iterator end() const noexcept {
 		return spawnsNpc.end();
 	}
-	void erase(SpawnNpcPositionList::iterator iter) noexcept {
+	void erase(SpawnNpcPositionList::iterator iter) {
+		index.erase(*iter);
 		spawnsNpc.erase(iter);
 	}
 	SpawnNpcPositionList::iterator find(Position &pos) {
 		return spawnsNpc.find(pos);
 	}
 
+	// Calls fn(center) for every spawn whose area covers position
+	template <typename F>
+	void forEachCovering(const Position &position, F &&fn) const {
+		index.forEachCovering(position, std::forward<F>(fn));
+	}
+
 private:
 	SpawnNpcPositionList spawnsNpc;
+	SpawnIndex index;
 };
 
 #endif
@@ -28,12 +28,17 @@ namespace fs = std::filesystem;
 
 SpriteAppearances g_spriteAppearances;
 
+SpriteAppearances::~SpriteAppearances() {
+	stopDecodeWorkers();
+}
+
 void SpriteAppearances::init() {
 	// in tibia 12.81 there is currently 3482 sheets
 	sheets.reserve(4000);
 }
 
 void SpriteAppearances::terminate() {
+	stopDecodeWorkers();
 	unload();
 }
 
@@ -45,48 +50,65 @@ bool SpriteAppearances::loadCatalogContent(const std::string &dir, bool loadData
 		return false;
 	}
 
-	std::ifstream file(catalogPath, std::ios::in);
-	if (!file.is_open()) {
-		spdlog::error("Unable to open catalog-content.json.");
-		return false;
+	if (g_settings.getBoolean(Config::SPRITE_DISK_CACHE)) {
+		diskCache.open(dir);
+	} else {
+		diskCache.close();
 	}
 
-	json document = json::parse(file, nullptr, false);
+	std::vector<SpriteSheetCache::CatalogEntry> entries;
+	if (!diskCache.readCatalog(appearanceFile, entries)) {
+		std::ifstream file(catalogPath, std::ios::in);
+		if (!file.is_open()) {
+			spdlog::error("Unable to open catalog-content.json.");
+			return false;
+		}
 
-	file.close();
+		json document = json::parse(file, nullptr, false);
+
+		file.close();
+
+		for (const auto &obj : document) {
+			const auto &type = obj["type"];
+			if (type == "appearances") {
+				appearanceFile = obj["file"];
+			} else if (type == "sprite") {
+				SpriteSheetCache::CatalogEntry entry;
+				entry.firstId = obj["firstspriteid"].get<int>();
+				entry.lastId = obj["lastspriteid"].get<int>();
+				entry.layout = static_cast<uint8_t>(obj["spritetype"].get<int>());
+				entry.file = obj["file"].get<std::string>();
+				entries.push_back(std::move(entry));
+			}
+		}
 
-	for (const auto &obj : document) {
-		const auto &type = obj["type"];
-		if (type == "appearances") {
-			appearanceFile = obj["file"];
-		} else if (type == "sprite") {
-			int lastSpriteId = obj["lastspriteid"].get<int>();
+		if (!entries.empty()) {
+			diskCache.writeCatalog(appearanceFile, entries);
+		}
+	}
 
-			SpriteSheetPtr sheet = SpriteSheetPtr(new SpriteSheet(obj["firstspriteid"].get<int>(), lastSpriteId, static_cast<SpriteLayout>(obj["spritetype"].get<int>()), (fs::path(dir) / fs::path(obj["file"].get<std::string>())).string()));
-			sheets.push_back(sheet);
+	for (const SpriteSheetCache::CatalogEntry &entry : entries) {
+		SpriteSheetPtr sheet = SpriteSheetPtr(new SpriteSheet(entry.firstId, entry.lastId, static_cast<SpriteLayout>(entry.layout), (fs::path(dir) / fs::path(entry.file)).string()));
+		addSpriteSheet(sheet);
 
-			spritesCount = std::max<int>(spritesCount, lastSpriteId);
+		spritesCount = std::max<int>(spritesCount, entry.lastId);
 
-			if (loadData) {
-				if (!loadSpriteSheet(sheet)) {
-					spdlog::error("[SpriteAppearances::loadCatalogContent] - Unable to load sprite sheet");
-					return false;
-				}
+		if (loadData) {
+			if (!loadSpriteSheet(sheet)) {
+				spdlog::error("[SpriteAppearances::loadCatalogContent] - Unable to load sprite sheet");
+				return false;
 			}
 		}
 	}
 	return true;
 }
 
-bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
-	if (sheet->loaded) {
-		return false;
-	}
-
-	std::ifstream file(sheet->path, std::ios::binary | std::ios::in);
+// Only touches its arguments, so the decode workers can run it concurrently
+std::unique_ptr<uint8_t[]> SpriteAppearances::decodeSpriteSheet(const std::string &path) {
+	std::ifstream file(path, std::ios::binary | std::ios::in);
 	if (!file.is_open()) {
-		spdlog::error("[SpriteAppearances::loadSpriteSheet] - Unable to open given sheets files");
-		return false;
+		spdlog::error("[SpriteAppearances::decodeSpriteSheet] - Unable to open given sheets files");
+		return nullptr;
 	}
 
 	std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), (std::istreambuf_iterator<char>()));
@@ -138,20 +160,21 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	lzma_ret ret = lzma_raw_decoder(&stream, filters);
 	if (ret != LZMA_OK) {
 		spdlog::error("Failed to initialize lzma raw decoder result: {}", static_cast<int>(ret));
-		return false;
+		return nullptr;
 	}
 
 	std::unique_ptr<uint8_t[]> decompressed = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE); // uncompressed size, bmp file + 122 bytes header
 
 	stream.next_in = &buffer[pos];
 	stream.next_out = decompressed.get();
-	stream.avail_in = buffer.size();
+	stream.avail_in = buffer.size() - pos;
 	stream.avail_out = LZMA_UNCOMPRESSED_SIZE;
 
 	ret = lzma_code(&stream, LZMA_RUN);
 	if (ret != LZMA_STREAM_END) {
 		spdlog::error("Failed to decode lzma buffer result: {}", static_cast<int>(ret));
-		return false;
+		lzma_end(&stream);
+		return nullptr;
 	}
 
 	lzma_end(&stream); // free memory
@@ -170,28 +193,236 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 		std::swap_ranges(itr1, itr1 + SPRITE_SHEET_WIDTH_BYTES, itr2);
 	}
 
-	sheet->data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
-	std::memcpy(sheet->data.get(), bufferStart, BYTES_IN_SPRITE_SHEET);
+	std::unique_ptr<uint8_t[]> data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
+	std::memcpy(data.get(), bufferStart, BYTES_IN_SPRITE_SHEET);
+	return data;
+}
+
+// Safe to call from the decode workers, the sheet's id and path never change
+SpriteSheetData SpriteAppearances::loadSheetData(const SpriteSheet &sheet) const {
+	SpriteSheetData data;
+	data.mapping = diskCache.mapSheet(sheet.firstId, BYTES_IN_SPRITE_SHEET);
+	if (data.mapping) {
+		return data;
+	}
+
+	data.buffer = decodeSpriteSheet(sheet.path);
+	if (data.buffer) {
+		diskCache.storeSheet(sheet.firstId, data.buffer.get(), BYTES_IN_SPRITE_SHEET);
+	}
+	return data;
+}
+
+bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
+	if (sheet->loaded) {
+		return false;
+	}
+
+	// Don't let a worker decode it a second time
+	if (sheet->pending) {
+		std::scoped_lock lock(decodeMutex);
+		if (decodeQueue.erase(DecodeRequest { sheet->decode_priority, sheet->decode_sequence, nullptr }) > 0) {
+			sheet->pending = false;
+			--pendingSheets;
+		}
+	}
+
+	sheet->data = loadSheetData(*sheet);
+	if (!sheet->data) {
+		return false;
+	}
 
 	sheet->loaded = true;
 	return true;
 }
 
+bool SpriteAppearances::requestSpriteSheet(int spriteId, SheetPriority priority) {
+	const auto it = findSheet(spriteId);
+	if (it == sheets.end()) {
+		return true;
+	}
+
+	const SpriteSheetPtr &sheet = *it;
+	if (sheet->loaded || sheet->failed) {
+		return true;
+	}
+
+	if (!g_settings.getBoolean(Config::SPRITE_ASYNC_DECODE)) {
+		loadSpriteSheet(sheet);
+		return true;
+	}
+
+	// Mapping a cached sheet is cheap enough to do right here
+	if (!sheet->pending) {
+		sheet->data.mapping = diskCache.mapSheet(sheet->firstId, BYTES_IN_SPRITE_SHEET);
+		if (sheet->data) {
+			sheet->loaded = true;
+			return true;
+		}
+	}
+
+	if (decodeWorkers.empty()) {
+		startDecodeWorkers();
+	}
+
+	const uint8_t level = static_cast<uint8_t>(priority);
+	{
+		std::scoped_lock lock(decodeMutex);
+		if (sheet->pending) {
+			const auto queued = decodeQueue.find(DecodeRequest { sheet->decode_priority, sheet->decode_sequence, nullptr });
+			if (queued == decodeQueue.end() || level < sheet->decode_priority) {
+				// Already taken by a worker, or waiting with a higher priority
+				return false;
+			}
+			decodeQueue.erase(queued);
+		} else {
+			sheet->pending = true;
+			++pendingSheets;
+		}
+
+		// Requeued with a fresh sequence, so what is on screen now goes first
+		sheet->decode_priority = level;
+		sheet->decode_sequence = ++decodeSequence;
+		decodeQueue.insert(DecodeRequest { level, sheet->decode_sequence, sheet });
+
+		if (decodeQueue.size() > MaxQueuedSheets) {
+			// Dropped sheets are simply requested again when they are needed
+			const auto last = std::prev(decodeQueue.end());
+			last->sheet->pending = false;
+			--pendingSheets;
+			decodeQueue.erase(last);
+		}
+	}
+	decodeCondition.notify_one();
+	return false;
+}
+
+size_t SpriteAppearances::processDecodedSheets() {
+	std::vector<std::pair<SpriteSheetPtr, SpriteSheetData>> finished;
+	{
+		std::scoped_lock lock(decodeMutex);
+		finished.swap(decodedSheets);
+		refreshPosted = false;
+	}
+
+	size_t installed = 0;
+	for (auto &[sheet, data] : finished) {
+		if (sheet->pending) {
+			sheet->pending = false;
+			--pendingSheets;
+		}
+		if (sheet->loaded) {
+			continue;
+		}
+		if (!data) {
+			// Let the synchronous path report it from now on
+			sheet->failed = true;
+			continue;
+		}
+		sheet->data = std::move(data);
+		sheet->loaded = true;
+		++installed;
+	}
+	return installed;
+}
+
+void SpriteAppearances::startDecodeWorkers() {
+	// Leave room for the GUI thread, a handful of workers keeps up with scrolling
+	const size_t count = std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, 4);
+	decodeStopping = false;
+	decodeWorkers.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		decodeWorkers.emplace_back([this]() { runDecodeWorker(); });
+	}
+}
+
+void SpriteAppearances::stopDecodeWorkers() {
+	{
+		std::scoped_lock lock(decodeMutex);
+		decodeStopping = true;
+		decodeQueue.clear();
+	}
+	decodeCondition.notify_all();
+	for (std::thread &worker : decodeWorkers) {
+		worker.join();
+	}
+	decodeWorkers.clear();
+}
+
+void SpriteAppearances::runDecodeWorker() {
+	while (true) {
+		SpriteSheetPtr sheet;
+		{
+			std::unique_lock lock(decodeMutex);
+			decodeCondition.wait(lock, [this]() { return decodeStopping || !decodeQueue.empty(); });
+			if (decodeStopping) {
+				return;
+			}
+			sheet = decodeQueue.begin()->sheet;
+			decodeQueue.erase(decodeQueue.begin());
+		}
+
+		SpriteSheetData data = loadSheetData(*sheet);
+
+		bool post = false;
+		{
+			std::scoped_lock lock(decodeMutex);
+			decodedSheets.emplace_back(std::move(sheet), std::move(data));
+			post = !refreshPosted;
+			refreshPosted = true;
+		}
+
+		// One pending repaint is enough for any number of finished sheets
+		if (post && wxTheApp) {
+			wxTheApp->CallAfter([this]() {
+				if (processDecodedSheets() > 0) {
+					g_gui.RefreshView();
+				}
+			});
+		}
+	}
+}
+
+
 void SpriteAppearances::unload() {
+	{
+		std::scoped_lock lock(decodeMutex);
+		decodeQueue.clear();
+		decodedSheets.clear();
+	}
+	// Decodes still in flight find their sheet orphaned and are dropped
+	for (const SpriteSheetPtr &sheet : sheets) {
+		sheet->pending = false;
+	}
+	pendingSheets = 0;
+
 	spritesCount = 0;
 	sheets.clear();
 }
 
+void SpriteAppearances::addSpriteSheet(SpriteSheetPtr sheet) {
+	const auto it = std::upper_bound(sheets.begin(), sheets.end(), sheet->firstId, [](int id, const SpriteSheetPtr &other) {
+		return id < other->firstId;
+	});
+	sheets.insert(it, std::move(sheet));
+}
+
+std::vector<SpriteSheetPtr>::const_iterator SpriteAppearances::findSheet(int id) const {
+	auto it = std::upper_bound(sheets.begin(), sheets.end(), id, [](int id, const SpriteSheetPtr &sheet) {
+		return id < sheet->firstId;
+	});
+	if (it == sheets.begin() || id > (*std::prev(it))->lastId) {
+		return sheets.end();
+	}
+	return std::prev(it);
+}
+
 SpriteSheetPtr SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true */) {
 	if (id == 0) {
 		return nullptr;
 	}
 
-	// find sheet
-	auto sheetIt = std::find_if(sheets.begin(), sheets.end(), [=](const SpriteSheetPtr &sheet) {
-		return id >= sheet->firstId && id <= sheet->lastId;
-	});
-
+	const auto sheetIt = findSheet(id);
 	if (sheetIt == sheets.end()) {
 		return nullptr;
 	}
@@ -334,7 +565,7 @@ SpritePtr SpriteAppearances::getSprite(int spriteId) {
 			return nullptr;
 		}
 
-		auto bufferData = &sheet->data[bufferDataStart];
+		auto bufferData = sheet->data.get() + bufferDataStart;
 		auto dest = &sprite->pixels[offset * spriteWidthBytes];
 
 		// Copy data using std::ranges::copy
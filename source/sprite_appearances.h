@@ -21,6 +21,11 @@
 #include "definitions.h"
 #include "main.h"
 #include "graphics.h"
+#include "sprite_cache.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 class GameSprite;
 
@@ -90,6 +95,19 @@ public:
 	SpritesSize size;
 };
 
+// Pixels of a decoded sheet, either owned or mapped straight from the disk cache
+struct SpriteSheetData {
+	std::unique_ptr<uint8_t[]> buffer;
+	std::unique_ptr<FileMapping> mapping;
+
+	const uint8_t* get() const noexcept {
+		return mapping ? mapping->getData() : buffer.get();
+	}
+	explicit operator bool() const noexcept {
+		return get() != nullptr;
+	}
+};
+
 class SpriteSheet {
 public:
 	SpriteSheet(int firstId, int lastId, SpriteLayout spriteLayout, const std::string &path) :
@@ -136,24 +154,38 @@ public:
 	}
 
 	bool exportSheetImage(const std::string &file, bool fixMagenta = false) {
-		wxImage image(384, 384, data.get(), true);
+		wxImage image(384, 384, const_cast<uint8_t*>(data.get()), true);
 		return image.SaveFile(wxString(file), wxBITMAP_TYPE_PNG);
 	};
 
 	int firstId = 0;
 	int lastId = 0;
 	SpriteLayout spriteLayout = SpriteLayout::ONE_BY_ONE;
-	std::unique_ptr<uint8_t[]> data;
+	SpriteSheetData data;
 	std::string path;
 	bool loaded = false;
+
+	// Background decoding state, only touched from the GUI thread
+	bool pending = false;
+	bool failed = false;
+	uint8_t decode_priority = 0;
+	uint64_t decode_sequence = 0;
 };
 
 using SpritePtr = std::shared_ptr<Sprites>;
 using SpriteSheetPtr = std::shared_ptr<SpriteSheet>;
 
+// Sheets wanted by the current frame are decoded before prefetched ones
+enum class SheetPriority : uint8_t {
+	Prefetch = 0,
+	Visible = 1,
+};
+
 //@bindsingleton g_spriteAppearances
 class SpriteAppearances {
 public:
+	~SpriteAppearances();
+
 	void init();
 	void terminate();
 
@@ -194,17 +226,62 @@ public:
 	void saveSheetToFile(const SpriteSheetPtr &sheet, const std::string &file);
 	SpriteSheetPtr getSheetBySpriteId(int id, bool load = true);
 
-	void addSpriteSheet(SpriteSheetPtr sheet) {
-		sheets.push_back(sheet);
-	}
+	void addSpriteSheet(SpriteSheetPtr sheet);
 
 	void saveSpriteToFile(int id, const std::string &file);
 
+	// Background decoding
+	// Returns true if the sheet holding the sprite can be used right away, otherwise queues
+	// it for the decode workers. Falls back to decoding in place when async decoding is off.
+	bool requestSpriteSheet(int spriteId, SheetPriority priority);
+	// Hands finished decodes over to their sheets, returns how many were installed
+	size_t processDecodedSheets();
+	size_t getPendingSheetCount() const {
+		return pendingSheets;
+	}
+
 private:
+	struct DecodeRequest {
+		uint8_t priority;
+		uint64_t sequence;
+		SpriteSheetPtr sheet;
+
+		bool operator<(const DecodeRequest &other) const {
+			// Highest priority first, newest request first within a priority
+			if (priority != other.priority) {
+				return priority > other.priority;
+			}
+			return sequence > other.sequence;
+		}
+	};
+
+	// Requests beyond this are dropped, oldest and least important first
+	static constexpr size_t MaxQueuedSheets = 256;
+
+	static std::unique_ptr<uint8_t[]> decodeSpriteSheet(const std::string &path);
+	SpriteSheetData loadSheetData(const SpriteSheet &sheet) const;
+	std::vector<SpriteSheetPtr>::const_iterator findSheet(int id) const;
+
+	void startDecodeWorkers();
+	void stopDecodeWorkers();
+	void runDecodeWorker();
+
 	int spritesCount = 0;
+	// Sorted by firstId
 	std::vector<SpriteSheetPtr> sheets;
 	std::map<int, SpritePtr> sprites;
 	std::string appearanceFile;
+	SpriteSheetCache diskCache;
+
+	std::vector<std::thread> decodeWorkers;
+	std::set<DecodeRequest> decodeQueue;
+	std::vector<std::pair<SpriteSheetPtr, SpriteSheetData>> decodedSheets;
+	std::mutex decodeMutex;
+	std::condition_variable decodeCondition;
+	bool decodeStopping = false;
+	bool refreshPosted = false;
+	uint64_t decodeSequence = 0;
+	size_t pendingSheets = 0;
 };
 
 extern SpriteAppearances g_spriteAppearances;
@@ -0,0 +1,149 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "sprite_batch.h"
+
+SpriteBatch::SpriteBatch() {
+	vertices.reserve(MaxQuads * 4);
+}
+
+void SpriteBatch::begin() {
+	vertices.clear();
+	runs.clear();
+	draw_calls = 0;
+	texture_binds = 0;
+	quads = 0;
+}
+
+void SpriteBatch::end() {
+	flush();
+	last_draw_calls = draw_calls;
+	last_texture_binds = texture_binds;
+	last_quads = quads;
+}
+
+void SpriteBatch::add(GLuint texture, float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, float u0, float v0, float u1, float v1) {
+	if (vertices.size() >= MaxQuads * 4) {
+		flush();
+	}
+
+	if (runs.empty() || runs.back().texture != texture) {
+		runs.push_back({ texture, static_cast<GLint>(vertices.size()), 0 });
+	}
+	runs.back().count += 4;
+
+	vertices.push_back({ x, y, u0, v0, red, green, blue, alpha });
+	vertices.push_back({ x + width, y, u1, v0, red, green, blue, alpha });
+	vertices.push_back({ x + width, y + height, u1, v1, red, green, blue, alpha });
+	vertices.push_back({ x, y + height, u0, v1, red, green, blue, alpha });
+	++quads;
+
+	if (recording) {
+		if (recording->runs.empty() || recording->runs.back().texture != texture) {
+			recording->runs.push_back({ texture, static_cast<GLint>(recording->vertices.size()), 0 });
+		}
+		recording->runs.back().count += 4;
+		recording->vertices.insert(recording->vertices.end(), vertices.end() - 4, vertices.end());
+	}
+}
+
+void SpriteBatch::replay(const Recording &source, float offset_x, float offset_y) {
+	for (const Run &run : source.runs) {
+		GLint first = run.first;
+		GLsizei remaining = run.count;
+		while (remaining > 0) {
+			if (vertices.size() >= MaxQuads * 4) {
+				flush();
+			}
+
+			// Runs are made of whole quads and the limit is a multiple of 4, so quads are never split
+			const GLsizei count = std::min<GLsizei>(remaining, static_cast<GLsizei>(MaxQuads * 4 - vertices.size()));
+			if (runs.empty() || runs.back().texture != run.texture) {
+				runs.push_back({ run.texture, static_cast<GLint>(vertices.size()), 0 });
+			}
+			runs.back().count += count;
+
+			for (GLint i = first; i < first + count; ++i) {
+				Vertex vertex = source.vertices[i];
+				vertex.x += offset_x;
+				vertex.y += offset_y;
+				vertices.push_back(vertex);
+			}
+			quads += count / 4;
+			first += count;
+			remaining -= count;
+		}
+	}
+}
+
+void SpriteBatch::flush() {
+	if (runs.empty()) {
+		return;
+	}
+
+	const GLboolean texturing = glIsEnabled(GL_TEXTURE_2D);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vertices[0].r);
+
+	// Textures may have been bound by uploads since the last flush, so don't trust the previous binding
+	GLuint bound_texture = 0;
+	bool textured = texturing == GL_TRUE;
+	for (const Run &run : runs) {
+		if (run.texture == 0) {
+			if (textured) {
+				glDisable(GL_TEXTURE_2D);
+				textured = false;
+			}
+		} else {
+			if (!textured) {
+				glEnable(GL_TEXTURE_2D);
+				textured = true;
+			}
+			if (bound_texture != run.texture) {
+				glBindTexture(GL_TEXTURE_2D, run.texture);
+				bound_texture = run.texture;
+				++texture_binds;
+			}
+		}
+		glDrawArrays(GL_QUADS, run.first, run.count);
+		++draw_calls;
+	}
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if (textured != (texturing == GL_TRUE)) {
+		if (texturing) {
+			glEnable(GL_TEXTURE_2D);
+		} else {
+			glDisable(GL_TEXTURE_2D);
+		}
+	}
+	// The current color is undefined after drawing with a color array
+	glColor4ub(255, 255, 255, 255);
+
+	vertices.clear();
+	runs.clear();
+}
@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_BATCH_H_
+#define RME_SPRITE_BATCH_H_
+
+#include "main.h"
+
+// Collects tinted quads and draws them with a handful of glDrawArrays calls instead of one glBegin/glEnd per quad.
+// Quads keep their submission order, consecutive quads sharing a texture (or an atlas page) become a single draw call.
+// Only uses OpenGL 1.1 client-side vertex arrays, so it works on any driver including Mesa llvmpipe.
+// Anything drawn in immediate mode must call flush() first, or it ends up below the pending quads.
+class SpriteBatch {
+public:
+	struct Vertex {
+		float x, y;
+		float u, v;
+		uint8_t r, g, b, a;
+	};
+	struct Run {
+		GLuint texture;
+		GLint first;
+		GLsizei count;
+	};
+
+	// Copy of the quads added while it was being recorded, runs index into its own vertices
+	struct Recording {
+		std::vector<Vertex> vertices;
+		std::vector<Run> runs;
+
+		void clear() {
+			vertices.clear();
+			runs.clear();
+		}
+	};
+
+	SpriteBatch();
+
+	SpriteBatch(const SpriteBatch &) = delete;
+	SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+	// Starts a new frame, the counters of the previous one are kept for telemetry
+	void begin();
+	// Flushes and closes the frame
+	void end();
+
+	// Textured quad, texture 0 draws a flat colored quad
+	void add(GLuint texture, float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, float u0 = 0.f, float v0 = 0.f, float u1 = 1.f, float v1 = 1.f);
+	void addRect(float x, float y, float width, float height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+		add(0, x, y, width, height, red, green, blue, alpha);
+	}
+
+	void flush();
+
+	// Quads added between these calls are also copied into the recording
+	void startRecording(Recording* target) {
+		recording = target;
+	}
+	void stopRecording() {
+		recording = nullptr;
+	}
+	// Adds the quads of a recording again, moved by the given offset
+	void replay(const Recording &source, float offset_x, float offset_y);
+
+	bool empty() const noexcept {
+		return runs.empty();
+	}
+
+	uint32_t getDrawCallsLastFrame() const noexcept {
+		return last_draw_calls;
+	}
+	uint32_t getTextureBindsLastFrame() const noexcept {
+		return last_texture_binds;
+	}
+	uint32_t getQuadsLastFrame() const noexcept {
+		return last_quads;
+	}
+
+private:
+	// Keeps the client-side arrays around 1 MiB
+	static constexpr size_t MaxQuads = 13107;
+
+	std::vector<Vertex> vertices;
+	std::vector<Run> runs;
+	Recording* recording = nullptr;
+
+	uint32_t draw_calls = 0;
+	uint32_t texture_binds = 0;
+	uint32_t quads = 0;
+	uint32_t last_draw_calls = 0;
+	uint32_t last_texture_binds = 0;
+	uint32_t last_quads = 0;
+};
+
+#endif
@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "sprite_cache.h"
+#include "gui.h"
+
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+	constexpr uint32_t CatalogMagic = 0x43534D52; // "RMSC"
+	constexpr uint32_t CatalogVersion = 1;
+
+	// FNV-1a, only used to tell asset sets apart
+	uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	uint64_t hashValue(uint64_t hash, const T &value) {
+		return hashBytes(hash, &value, sizeof(value));
+	}
+}
+
+bool SpriteSheetCache::open(const std::string &assetsDirectory) {
+	close();
+
+	std::error_code error;
+	const fs::path catalogPath = fs::path(assetsDirectory) / "catalog-content.json";
+	std::ifstream catalog(catalogPath, std::ios::binary | std::ios::in);
+	if (!catalog.is_open()) {
+		return false;
+	}
+	const std::string content((std::istreambuf_iterator<char>(catalog)), std::istreambuf_iterator<char>());
+
+	// The catalog itself plus the name, size and modification time of every asset file.
+	// Hashing the sheet contents would cost as much as decoding them.
+	uint64_t hash = hashBytes(0xCBF29CE484222325ULL, content.data(), content.size());
+	std::vector<std::tuple<std::string, uintmax_t, int64_t>> files;
+	for (const fs::directory_entry &entry : fs::directory_iterator(assetsDirectory, error)) {
+		if (!entry.is_regular_file(error)) {
+			continue;
+		}
+		const auto modified = static_cast<int64_t>(entry.last_write_time(error).time_since_epoch().count());
+		files.emplace_back(entry.path().filename().string(), entry.file_size(error), modified);
+	}
+	std::sort(files.begin(), files.end());
+	for (const auto &[name, size, modified] : files) {
+		hash = hashBytes(hash, name.data(), name.size());
+		hash = hashValue(hash, size);
+		hash = hashValue(hash, modified);
+	}
+
+	const fs::path root = fs::path(nstr(g_gui.GetLocalDataDirectory())) / "sprite-cache";
+	const std::string key = fmt::format("{:016x}", hash);
+
+	// Sheets of older asset sets are never read again
+	for (const fs::directory_entry &entry : fs::directory_iterator(root, error)) {
+		if (entry.is_directory(error) && entry.path().filename().string() != key) {
+			fs::remove_all(entry.path(), error);
+		}
+	}
+
+	const fs::path path = root / key;
+	fs::create_directories(path, error);
+	if (!fs::is_directory(path, error)) {
+		spdlog::warn("[SpriteSheetCache::open] - Unable to create sprite cache directory {}", path.string());
+		return false;
+	}
+
+	directory = path.string();
+	return true;
+}
+
+void SpriteSheetCache::close() {
+	directory.clear();
+}
+
+bool SpriteSheetCache::readCatalog(std::string &appearanceFile, std::vector<CatalogEntry> &entries) const {
+	if (!isOpen()) {
+		return false;
+	}
+
+	FileReadHandle file((fs::path(directory) / "catalog.bin").string());
+	if (!file.isOk()) {
+		return false;
+	}
+
+	uint32_t magic, version, count;
+	if (!file.getU32(magic) || magic != CatalogMagic || !file.getU32(version) || version != CatalogVersion) {
+		return false;
+	}
+	if (!file.getString(appearanceFile) || !file.getU32(count)) {
+		return false;
+	}
+
+	entries.clear();
+	entries.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		CatalogEntry entry;
+		uint32_t firstId, lastId;
+		if (!file.getU32(firstId) || !file.getU32(lastId) || !file.getU8(entry.layout) || !file.getString(entry.file)) {
+			entries.clear();
+			return false;
+		}
+		entry.firstId = static_cast<int>(firstId);
+		entry.lastId = static_cast<int>(lastId);
+		entries.push_back(std::move(entry));
+	}
+	return true;
+}
+
+void SpriteSheetCache::writeCatalog(const std::string &appearanceFile, const std::vector<CatalogEntry> &entries) const {
+	if (!isOpen()) {
+		return;
+	}
+
+	const std::string path = (fs::path(directory) / "catalog.bin").string();
+	{
+		FileWriteHandle file(path + ".tmp");
+		if (!file.isOk()) {
+			return;
+		}
+
+		file.addU32(CatalogMagic);
+		file.addU32(CatalogVersion);
+		file.addString(appearanceFile);
+		file.addU32(static_cast<uint32_t>(entries.size()));
+		for (const CatalogEntry &entry : entries) {
+			file.addU32(static_cast<uint32_t>(entry.firstId));
+			file.addU32(static_cast<uint32_t>(entry.lastId));
+			file.addU8(entry.layout);
+			file.addString(entry.file);
+		}
+		if (!file.isOk()) {
+			return;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(path + ".tmp", path, error);
+	if (error) {
+		fs::remove(path + ".tmp", error);
+	}
+}
+
+std::string SpriteSheetCache::getSheetPath(int firstId) const {
+	return (fs::path(directory) / fmt::format("{}.sheet", firstId)).string();
+}
+
+std::unique_ptr<FileMapping> SpriteSheetCache::mapSheet(int firstId, size_t size) const {
+	if (!isOpen()) {
+		return nullptr;
+	}
+
+	auto mapping = std::make_unique<FileMapping>();
+	if (!mapping->open(getSheetPath(firstId)) || mapping->getSize() != size) {
+		return nullptr;
+	}
+	return mapping;
+}
+
+void SpriteSheetCache::storeSheet(int firstId, const uint8_t* pixels, size_t size) const {
+	if (!isOpen()) {
+		return;
+	}
+
+	// Written under a temporary name so a crash never leaves a truncated sheet behind
+	const std::string path = getSheetPath(firstId);
+	{
+		FileWriteHandle file(path + ".tmp");
+		if (!file.isOk() || !file.addRAW(pixels, size)) {
+			return;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(path + ".tmp", path, error);
+	if (error) {
+		fs::remove(path + ".tmp", error);
+	}
+}
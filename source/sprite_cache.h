@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_CACHE_H_
+#define RME_SPRITE_CACHE_H_
+
+#include "main.h"
+#include "filehandle.h"
+
+// On-disk cache of decoded sprite sheets and of the parsed catalog, so later runs
+// neither parse catalog-content.json nor LZMA-decode sheets they have seen before.
+// Everything lives in a directory named after a hash of the asset files, changing
+// the assets simply selects a new directory and the old ones are removed.
+class SpriteSheetCache {
+public:
+	struct CatalogEntry {
+		int firstId = 0;
+		int lastId = 0;
+		uint8_t layout = 0;
+		std::string file;
+	};
+
+	// Selects the cache directory for the assets in the given directory
+	bool open(const std::string &assetsDirectory);
+	void close();
+
+	bool isOpen() const noexcept {
+		return !directory.empty();
+	}
+
+	bool readCatalog(std::string &appearanceFile, std::vector<CatalogEntry> &entries) const;
+	void writeCatalog(const std::string &appearanceFile, const std::vector<CatalogEntry> &entries) const;
+
+	// These two are called from the decode workers, the directory doesn't change while they run
+	std::unique_ptr<FileMapping> mapSheet(int firstId, size_t size) const;
+	void storeSheet(int firstId, const uint8_t* pixels, size_t size) const;
+
+private:
+	std::string getSheetPath(int firstId) const;
+
+	std::string directory;
+};
+
+#endif
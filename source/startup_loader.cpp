@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "startup_loader.h"
+#include "threads.h"
+
+size_t StartupLoader::addStage(std::string name, std::vector<size_t> dependencies, StageFunction function, uint32_t flags) {
+	Stage &stage = stages.emplace_back();
+	stage.name = std::move(name);
+	stage.dependencies = std::move(dependencies);
+	stage.function = std::move(function);
+	stage.flags = flags;
+	return stages.size() - 1;
+}
+
+void StartupLoader::runStage(Stage &stage) {
+	const auto start = std::chrono::steady_clock::now();
+	try {
+		stage.succeeded = stage.function(stage.error, stage.warnings);
+	} catch (const std::exception &exception) {
+		stage.succeeded = false;
+		stage.error = wxString::FromUTF8(exception.what());
+	}
+	stage.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool StartupLoader::run(wxString &error, wxArrayString &warnings, const ProgressFunction &progress) {
+	const auto start = std::chrono::steady_clock::now();
+
+	size_t workers = 0;
+	for (const Stage &stage : stages) {
+		if (!(stage.flags & STAGE_MAIN_THREAD)) {
+			++workers;
+		}
+	}
+	ThreadPool pool(std::min(std::max<size_t>(workers, 1), ThreadPool::getDefaultThreadCount()));
+
+	size_t finished = 0;
+	bool aborted = false;
+	const auto finish = [&](Stage &stage) {
+		stage.state = State::Done;
+		++finished;
+		if (!stage.succeeded && (stage.flags & STAGE_REQUIRED) && !aborted) {
+			aborted = true;
+			error = stage.error;
+		}
+		if (progress) {
+			progress(finished, stages.size(), stage.name);
+		}
+	};
+
+	while (finished < stages.size()) {
+		bool changed = false;
+		for (Stage &stage : stages) {
+			if (stage.state == State::Running && stage.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				stage.result.get();
+				finish(stage);
+				changed = true;
+			}
+		}
+
+		for (Stage &stage : stages) {
+			if (stage.state != State::Pending) {
+				continue;
+			}
+			if (aborted) {
+				stage.state = State::Skipped;
+				++finished;
+				changed = true;
+				continue;
+			}
+
+			const bool ready = std::all_of(stage.dependencies.begin(), stage.dependencies.end(), [this](size_t dependency) {
+				return stages[dependency].state == State::Done;
+			});
+			if (!ready) {
+				continue;
+			}
+
+			changed = true;
+			if (stage.flags & STAGE_MAIN_THREAD) {
+				runStage(stage);
+				finish(stage);
+			} else {
+				stage.state = State::Running;
+				stage.result = pool.enqueue([&stage]() { runStage(stage); });
+			}
+		}
+
+		if (!changed) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+	}
+
+	for (const Stage &stage : stages) {
+		for (const wxString &warning : stage.warnings) {
+			warnings.push_back(warning);
+		}
+	}
+
+	logTimings(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return !aborted;
+}
+
+void StartupLoader::logTimings(double total_milliseconds) const {
+	double sum = 0.0;
+	for (const Stage &stage : stages) {
+		if (stage.state == State::Skipped) {
+			spdlog::info("[StartupLoader] {:<24} skipped", stage.name);
+			continue;
+		}
+		spdlog::info("[StartupLoader] {:<24} {:>9.1f} ms{}", stage.name, stage.milliseconds, stage.succeeded ? "" : " (failed)");
+		sum += stage.milliseconds;
+	}
+	spdlog::info("[StartupLoader] {} stages in {:.1f} ms, {:.1f} ms one after another", stages.size(), total_milliseconds, sum);
+}
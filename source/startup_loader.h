@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_STARTUP_LOADER_H_
+#define RME_STARTUP_LOADER_H_
+
+#include "main.h"
+
+#include <future>
+
+// Runs the loading stages of the data files as a dependency graph, every stage starts on a thread pool
+// as soon as the stages it depends on are finished. Dependencies only order stages, a stage still runs
+// when one of them failed and has to check that itself. Every stage writes to its own warning list and
+// the lists are merged in the order the stages were added, so the result doesn't depend on timing.
+class StartupLoader {
+public:
+	using StageFunction = std::function<bool(wxString &error, wxArrayString &warnings)>;
+	using ProgressFunction = std::function<void(size_t finished, size_t total, const std::string &name)>;
+
+	enum StageFlags : uint32_t {
+		STAGE_NONE = 0,
+		// Loading stops if it fails, its error is the one returned by run
+		STAGE_REQUIRED = 1 << 0,
+		// Touches the GUI or shared editor state, runs on the thread calling run
+		STAGE_MAIN_THREAD = 1 << 1,
+	};
+
+	// Returns the id to list the stage as a dependency of later ones
+	size_t addStage(std::string name, std::vector<size_t> dependencies, StageFunction function, uint32_t flags = STAGE_NONE);
+
+	// Blocks until every stage ran, or a required stage failed and the running ones are done.
+	// progress is called on the calling thread whenever a stage finishes.
+	bool run(wxString &error, wxArrayString &warnings, const ProgressFunction &progress = nullptr);
+
+private:
+	enum class State {
+		Pending,
+		Running,
+		Done,
+		Skipped,
+	};
+
+	struct Stage {
+		std::string name;
+		std::vector<size_t> dependencies;
+		StageFunction function;
+		uint32_t flags = STAGE_NONE;
+
+		State state = State::Pending;
+		std::future<void> result;
+		bool succeeded = false;
+		wxString error;
+		wxArrayString warnings;
+		double milliseconds = 0.0;
+	};
+
+	static void runStage(Stage &stage);
+	void logTimings(double total_milliseconds) const;
+
+	std::vector<Stage> stages;
+};
+
+#endif
@@ -20,6 +20,12 @@
 
 #include "main.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
 class Thread : public wxThread {
 public:
 	Thread(wxThreadKind);
@@ -39,6 +45,106 @@ public:
 		Thread(wxTHREAD_DETACHED) { }
 };
 
+// Fixed size pool of worker threads for CPU bound jobs (map loading, borderizing...)
+// Jobs must not touch the GUI, results are handed back through the returned futures.
+class ThreadPool {
+public:
+	// 0 means one worker per hardware thread
+	explicit ThreadPool(size_t threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	size_t size() const noexcept {
+		return workers.size();
+	}
+
+	template <typename F>
+	std::future<std::invoke_result_t<F>> enqueue(F &&job);
+
+	// Runs job(i) for every i in [0, count) on the pool and blocks until all are done
+	template <typename F>
+	void parallelFor(size_t count, F &&job);
+
+	static size_t getDefaultThreadCount() {
+		return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+private:
+	void run();
+
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping;
+};
+
+inline ThreadPool::ThreadPool(size_t threads) :
+	stopping(false) {
+	if (threads == 0) {
+		threads = getDefaultThreadCount();
+	}
+	workers.reserve(threads);
+	for (size_t i = 0; i < threads; ++i) {
+		workers.emplace_back([this]() { run(); });
+	}
+}
+
+inline ThreadPool::~ThreadPool() {
+	{
+		std::scoped_lock lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+}
+
+inline void ThreadPool::run() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (jobs.empty()) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+		job();
+	}
+}
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::enqueue(F &&job) {
+	using ResultType = std::invoke_result_t<F>;
+	// std::function needs a copyable target, packaged_task is move-only
+	auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(job));
+	std::future<ResultType> result = task->get_future();
+	{
+		std::scoped_lock lock(mutex);
+		jobs.emplace([task]() { (*task)(); });
+	}
+	condition.notify_one();
+	return result;
+}
+
+template <typename F>
+void ThreadPool::parallelFor(size_t count, F &&job) {
+	std::vector<std::future<void>> pending;
+	pending.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		pending.push_back(enqueue([&job, i]() { job(i); }));
+	}
+	for (std::future<void> &done : pending) {
+		done.get();
+	}
+}
+
 inline Thread::Thread(wxThreadKind kind) :
 	wxThread(kind) { }
 
@@ -535,8 +535,8 @@ void Tile::update() {
 		if (ground->getUniqueID() != 0) {
 			statflags |= TILESTATE_UNIQUE;
 		}
-		if (ground->getMiniMapColor() != 0) {
-			minimapColor = ground->getMiniMapColor();
+		if (const uint8_t color = ground->getMiniMapColor(); color != 0) {
+			minimapColor = color;
 		}
 	}
 
@@ -547,22 +547,21 @@ void Tile::update() {
 		if (item->getUniqueID() != 0) {
 			statflags |= TILESTATE_UNIQUE;
 		}
-		if (item->getMiniMapColor() != 0) {
-			minimapColor = item->getMiniMapColor();
+		if (const uint8_t color = item->getMiniMapColor(); color != 0) {
+			minimapColor = color;
 		}
 
-		const ItemType &type = g_items.getItemType(item->getID());
-
-		if (type.unpassable) {
+		const uint16_t id = item->getID();
+		if (g_items.hasHotFlag(id, ItemDatabase::HOT_UNPASSABLE)) {
 			statflags |= TILESTATE_BLOCKING;
 		}
-		if (type.isOptionalBorder) {
+		if (g_items.hasHotFlag(id, ItemDatabase::HOT_OPTIONAL_BORDER)) {
 			statflags |= TILESTATE_OP_BORDER;
 		}
-		if (type.isTable) {
+		if (g_items.hasHotFlag(id, ItemDatabase::HOT_TABLE)) {
 			statflags |= TILESTATE_HAS_TABLE;
 		}
-		if (type.isCarpet) {
+		if (g_items.hasHotFlag(id, ItemDatabase::HOT_CARPET)) {
 			statflags |= TILESTATE_HAS_CARPET;
 		}
 	}
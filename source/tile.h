@@ -47,7 +47,7 @@ enum : uint8_t {
 	INVALID_MINIMAP_COLOR = 0xFF
 };
 
-class Tile {
+class Tile : public MapArenaObject {
 public: // Members
 	TileLocation* location;
 	Item* ground;
@@ -35,6 +35,7 @@ void Waypoints::addWaypoint(Waypoint* wp) {
 			map.setTile(wp->pos, t = map.allocator(map.createTileL(wp->pos)));
 		}
 		t->getLocation()->increaseWaypointCount();
+		map.markAreaDirty(wp->pos);
 	}
 	waypoints.insert(std::make_pair(as_lower_str(wp->name), wp));
 }
@@ -68,6 +69,9 @@ void Waypoints::removeWaypoint(std::string name) {
 	if (iter == waypoints.end()) {
 		return;
 	}
+	if (iter->second->pos.isValid()) {
+		map.markAreaDirty(iter->second->pos);
+	}
 	delete iter->second;
 	waypoints.erase(iter);
 }